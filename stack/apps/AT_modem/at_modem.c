@@ -225,6 +225,13 @@ static void packet_received(hw_radio_packet_t* hw_radio_packet)
 
     if (hw_radio_packet->rx_meta.crc_status == HW_CRC_UNAVAILABLE)
     {
+        if(hw_radio_packet->length < 2)
+        {
+            DPRINT("Packet too short");
+            missed_packets_counter++;
+            return;
+        }
+
         uint16_t crc;
         crc = __builtin_bswap16(crc_calculate(hw_radio_packet->data, hw_radio_packet->length - 2));
 
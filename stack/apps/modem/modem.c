@@ -30,6 +30,7 @@
 #include "log.h"
 #include "platform.h"
 #include "power_tracking_file.h"
+#include "scheduler_profiling_file.h"
 
 static bool forward_over_serial = false;
 
@@ -44,6 +45,9 @@ void bootstrap()
     alp_layer_init(NULL, forward_over_serial);
 
     power_tracking_file_initialize();
+#ifdef FRAMEWORK_USE_SCHEDULER_PROFILING_FILE
+    scheduler_profiling_file_initialize();
+#endif
 
     uint8_t uid[8];
     d7ap_fs_read_uid(uid);
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Micro-benchmark of the fifo, comparing the throughput of fifo.c with the reference implementation below, which is
+ * the fifo as it was before the masks, the inline byte access and the single bulk copy path. Bytes are streamed through
+ * a fifo which is kept half full, so the accesses wrap around the end of the buffer at every offset. This is measured
+ * for byte access and for bulk puts and pops of several chunk sizes, for a power of two capacity (masked) and another
+ * capacity (wrapped with a compare in fifo.c, with a modulo in the reference). The results are written to stdout as CSV:
+ *
+ *   implementation,operation,capacity,chunk,ns_per_byte,cycles_per_byte
+ *
+ * cycles_per_byte is measured with the time stamp counter and is left empty when the host has none.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_CYCLE_COUNTER 1
+#endif
+
+#include "fifo.h"
+#include "errors.h"
+
+#define BYTES_PER_MEASUREMENT (1 << 20)
+#define MEASUREMENT_REPEATS 5 // the fastest run is reported
+
+static volatile uint8_t sink; // keeps the compiler from optimising away the pops
+
+// the reference implementation, only the functions used by the benchmark
+static uint16_t ref_get_size(fifo_t* fifo)
+{
+    if(fifo->head_idx == fifo->tail_idx)
+        return fifo->is_full ? fifo->max_size : 0;
+    else if(fifo->head_idx < fifo->tail_idx)
+        return fifo->tail_idx - fifo->head_idx;
+    else
+        return fifo->tail_idx + (fifo->max_size - fifo->head_idx);
+}
+
+static error_t ref_put(fifo_t* fifo, uint8_t* data, uint16_t len)
+{
+    if(fifo->is_subview)
+        return EINVAL;
+
+    if(fifo->is_full)
+        return ESIZE;
+
+    if(fifo->tail_idx < fifo->head_idx)
+    {
+        if(fifo->tail_idx + len > fifo->head_idx)
+            return ESIZE;
+        memcpy(fifo->buffer + fifo->tail_idx, data, len);
+        fifo->tail_idx += len;
+        fifo->is_full = (fifo->tail_idx == fifo->head_idx);
+        return SUCCESS;
+    }
+
+    if(fifo->tail_idx + len < fifo->max_size)
+    {
+        memcpy(fifo->buffer + fifo->tail_idx, data, len);
+        fifo->tail_idx += len;
+        return SUCCESS;
+    }
+
+    uint16_t space_left_before_max_size = fifo->max_size - fifo->tail_idx;
+    uint16_t space_needed_after_wrap = len - space_left_before_max_size;
+    if(fifo->head_idx >= space_needed_after_wrap)
+    {
+        memcpy(fifo->buffer + fifo->tail_idx, data, space_left_before_max_size);
+        memcpy(fifo->buffer, data + space_left_before_max_size, space_needed_after_wrap);
+        fifo->tail_idx = space_needed_after_wrap;
+        fifo->is_full = (fifo->tail_idx == fifo->head_idx);
+        return SUCCESS;
+    }
+    else
+        return ESIZE;
+}
+
+static error_t ref_put_byte(fifo_t* fifo, uint8_t byte)
+{
+    return ref_put(fifo, &byte, 1);
+}
+
+// fifo_pop(), which peeks and then skips
+static error_t ref_pop(fifo_t* fifo, uint8_t* buffer, uint16_t len)
+{
+    if(len > ref_get_size(fifo))
+        return ESIZE;
+
+    uint16_t start_idx = fifo->head_idx % fifo->max_size;
+    uint16_t end_idx = (start_idx + len) % fifo->max_size;
+    if(end_idx >= start_idx)
+        memcpy(buffer, fifo->buffer + start_idx, len);
+    else
+    {
+        uint16_t part1 = fifo->max_size - start_idx;
+        memcpy(buffer, fifo->buffer + start_idx, part1);
+        memcpy(buffer + part1, fifo->buffer, len - part1);
+    }
+
+    fifo->head_idx = fifo->head_idx + len;
+    if(fifo->head_idx >= fifo->max_size)
+        fifo->head_idx = fifo->head_idx % fifo->max_size;
+    if(len > 0)
+        fifo->is_full = 0;
+
+    return SUCCESS;
+}
+
+static error_t ref_pop_byte(fifo_t* fifo, uint8_t* byte)
+{
+    return ref_pop(fifo, byte, 1);
+}
+
+typedef struct
+{
+    error_t (*put)(fifo_t* fifo, uint8_t* data, uint16_t len);
+    error_t (*pop)(fifo_t* fifo, uint8_t* buffer, uint16_t len);
+} implementation_t;
+
+static const implementation_t implementations[] = {
+    { &ref_put, &ref_pop },
+    { &fifo_put, &fifo_pop },
+};
+static const char* implementation_names[] = { "reference", "fifo" };
+
+static const uint16_t capacities[] = { 256, 250 };
+static const uint16_t chunks[] = { 1, 2, 4, 8, 16, 64 };
+
+static fifo_t fifo;
+static uint8_t fifo_buffer[256];
+static uint8_t data[64];
+
+static uint64_t get_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint64_t get_cycles()
+{
+#ifdef HAS_CYCLE_COUNTER
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// the byte access loops call the functions directly, so the inline functions of fifo.h are actually inlined
+static void stream_bytes_reference(uint32_t bytes)
+{
+    uint8_t byte;
+    for(uint32_t i = 0; i < bytes; i++)
+    {
+        ref_put_byte(&fifo, (uint8_t)i);
+        ref_pop_byte(&fifo, &byte);
+        sink = byte;
+    }
+}
+
+static void stream_bytes_fifo(uint32_t bytes)
+{
+    uint8_t byte;
+    for(uint32_t i = 0; i < bytes; i++)
+    {
+        fifo_put_byte(&fifo, (uint8_t)i);
+        fifo_pop_byte(&fifo, &byte);
+        sink = byte;
+    }
+}
+
+static void stream_chunks(const implementation_t* implementation, uint16_t chunk, uint32_t bytes)
+{
+    for(uint32_t i = 0; i < bytes; i += chunk)
+    {
+        implementation->put(&fifo, data, chunk);
+        implementation->pop(&fifo, data, chunk);
+    }
+    sink = data[0];
+}
+
+static void measure(int implementation, uint16_t capacity, uint16_t chunk, double* ns_per_byte, double* cycles_per_byte)
+{
+    *ns_per_byte = 0;
+    *cycles_per_byte = 0;
+    for(int repeat = 0; repeat < MEASUREMENT_REPEATS; repeat++)
+    {
+        // keep the fifo half full, so the puts and pops wrap around the end of the buffer at every offset
+        fifo_init(&fifo, fifo_buffer, capacity);
+        implementations[implementation].put(&fifo, fifo_buffer, capacity / 2 + 1);
+
+        uint64_t start_ns = get_ns();
+        uint64_t start_cycles = get_cycles();
+        if(chunk == 0 && implementation == 0)
+            stream_bytes_reference(BYTES_PER_MEASUREMENT);
+        else if(chunk == 0)
+            stream_bytes_fifo(BYTES_PER_MEASUREMENT);
+        else
+            stream_chunks(&implementations[implementation], chunk, BYTES_PER_MEASUREMENT);
+
+        double ns = (double)(get_ns() - start_ns) / BYTES_PER_MEASUREMENT;
+        double cycles = (double)(get_cycles() - start_cycles) / BYTES_PER_MEASUREMENT;
+        if(repeat == 0 || ns < *ns_per_byte)
+        {
+            *ns_per_byte = ns;
+            *cycles_per_byte = cycles;
+        }
+
+        if(ref_get_size(&fifo) != capacity / 2 + 1)
+        {
+            fprintf(stderr, "%s, capacity %i, chunk %i: the fifo lost bytes\n", implementation_names[implementation],
+                    capacity, chunk);
+            exit(1);
+        }
+    }
+}
+
+static void print_result(int implementation, const char* operation, uint16_t capacity, uint16_t chunk)
+{
+    double ns, cycles;
+    measure(implementation, capacity, chunk, &ns, &cycles);
+    printf("%s,%s,%u,%u,%.2f,", implementation_names[implementation], operation, capacity, chunk ? chunk : 1, ns);
+#ifdef HAS_CYCLE_COUNTER
+    printf("%.1f", cycles);
+#endif
+    printf("\n");
+}
+
+void bootstrap()
+{
+    printf("implementation,operation,capacity,chunk,ns_per_byte,cycles_per_byte\n");
+    for(int c = 0; c < sizeof(capacities) / sizeof(capacities[0]); c++)
+    {
+        for(int i = 0; i < sizeof(implementations) / sizeof(implementations[0]); i++)
+        {
+            print_result(i, "byte", capacities[c], 0);
+            for(int s = 0; s < sizeof(chunks) / sizeof(chunks[0]); s++)
+                print_result(i, "bulk", capacities[c], chunks[s]);
+        }
+    }
+
+    exit(0);
+}
@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Micro-benchmark of the PHY coding pipeline: CRC, PN9 whitening and FEC, as used by phy.c and packet.c on
+ * every transmitted and received frame. Every stage is measured for all frame lengths from 4 up to 255 bytes,
+ * for both PN9 and FEC+PN9 channel coding, and the results are written to stdout as CSV:
+ *
+ *   coding,stage,length,encoded_length,ns_per_packet,ns_per_byte,cycles_per_packet
+ *
+ * ns_per_byte is relative to the (unencoded) frame length. cycles_per_packet is measured with the time stamp
+ * counter and is left empty when the host has none. The tx and rx stages measure the complete pipeline, the
+ * same way it is executed by phy.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_CYCLE_COUNTER 1
+#endif
+
+#include "crc.h"
+#include "pn9.h"
+#include "fec.h"
+
+#define MIN_FRAME_LENGTH 4 // phy.c drops shorter frames
+#define MAX_FRAME_LENGTH 255
+#define MAX_ENCODED_LENGTH (2 * (MAX_FRAME_LENGTH + 3))
+#define BYTES_PER_MEASUREMENT 16384 // determines the number of iterations per measurement
+#define MEASUREMENT_REPEATS 5 // the fastest run is reported
+
+// same values as the channel coding in phy.h, this benchmark does not depend on the d7ap module
+typedef enum
+{
+    CODING_PN9 = 0x00,
+    CODING_FEC_PN9 = 0x02,
+} coding_t;
+
+typedef struct
+{
+    coding_t coding;
+    uint16_t length; // frame length, including the length byte and the CRC
+    uint16_t encoded_length;
+    uint8_t frame[MAX_FRAME_LENGTH];
+    uint8_t fec_encoded[MAX_ENCODED_LENGTH]; // FEC encoded but not yet whitened
+    uint8_t encoded[MAX_ENCODED_LENGTH]; // the frame as it goes on air
+    uint8_t buffer[MAX_ENCODED_LENGTH]; // the working buffer of a stage
+} bench_frame_t;
+
+typedef void (*stage_t)(bench_frame_t* f);
+
+typedef struct
+{
+    const char* name;
+    stage_t run;
+    bool fec_only;
+} bench_stage_t;
+
+static volatile uint16_t sink; // keeps the compiler from optimising away the stages
+
+// every stage starts with a copy of its input, the cost of this copy is measured separately and subtracted
+static void stage_copy(bench_frame_t* f)
+{
+    memcpy(f->buffer, f->encoded, f->encoded_length);
+}
+
+static void stage_crc(bench_frame_t* f)
+{
+    memcpy(f->buffer, f->encoded, f->encoded_length);
+    sink = crc_calculate(f->frame, f->length - 2);
+}
+
+static void stage_pn9(bench_frame_t* f)
+{
+    memcpy(f->buffer, f->encoded, f->encoded_length);
+    pn9_encode(f->buffer, f->encoded_length);
+}
+
+static void stage_fec_encode(bench_frame_t* f)
+{
+    memcpy(f->buffer, f->frame, f->length);
+    sink = fec_encode(f->buffer, f->length);
+}
+
+static void stage_fec_decode(bench_frame_t* f)
+{
+    memcpy(f->buffer, f->fec_encoded, f->encoded_length);
+    sink = fec_decode_packet(f->buffer, f->encoded_length, f->encoded_length);
+}
+
+// packet_assemble() and phy_send_packet(): without FEC the CRC is calculated while the frame is whitened
+static void stage_tx(bench_frame_t* f)
+{
+    uint16_t crc_offset = f->length - 2;
+    if(f->coding == CODING_PN9)
+    {
+        uint16_t crc = crc_final(pn9_encode_crc(f->buffer, f->frame, crc_offset, 0, crc_init()));
+        f->buffer[crc_offset] = crc >> 8;
+        f->buffer[crc_offset + 1] = crc & 0xFF;
+        pn9_encode_from(&f->buffer[crc_offset], 2, crc_offset);
+        return;
+    }
+
+    memcpy(f->buffer, f->frame, f->length);
+    uint16_t crc = __builtin_bswap16(crc_calculate(f->buffer, crc_offset));
+    memcpy(&f->buffer[crc_offset], &crc, 2);
+    uint16_t encoded_length = fec_encode(f->buffer, f->length);
+    pn9_encode(f->buffer, encoded_length);
+}
+
+// packet_received(): without FEC the frame is de-whitened and included in the CRC in a single pass
+static void stage_rx(bench_frame_t* f)
+{
+    memcpy(f->buffer, f->encoded, f->encoded_length);
+    uint16_t crc;
+    if(f->coding == CODING_PN9)
+    {
+        crc = pn9_decode_crc(f->buffer, 1, 0, crc_init());
+        crc = pn9_decode_crc(&f->buffer[1], f->buffer[0] - 2, 1, crc);
+        pn9_encode_from(&f->buffer[f->length - 2], 2, f->length - 2);
+    }
+    else
+    {
+        pn9_encode(f->buffer, f->encoded_length);
+        fec_decode_packet(f->buffer, f->encoded_length, f->encoded_length);
+        crc = crc_calculate(f->buffer, f->length - 2);
+    }
+
+    sink = f->buffer[f->length - 2] == (crc >> 8) && f->buffer[f->length - 1] == (crc & 0xFF);
+}
+
+static const bench_stage_t stages[] = {
+    { "crc", &stage_crc, false },
+    { "pn9", &stage_pn9, false },
+    { "fec_encode", &stage_fec_encode, true },
+    { "fec_decode", &stage_fec_decode, true },
+    { "tx", &stage_tx, false },
+    { "rx", &stage_rx, false },
+};
+
+static bench_frame_t frame;
+
+static uint64_t get_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint64_t get_cycles()
+{
+#ifdef HAS_CYCLE_COUNTER
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// returns the fastest time per packet of a number of repeated measurements
+static void measure(stage_t stage, uint32_t iterations, double* ns_per_packet, double* cycles_per_packet)
+{
+    *ns_per_packet = 0;
+    *cycles_per_packet = 0;
+    for(int repeat = 0; repeat < MEASUREMENT_REPEATS; repeat++)
+    {
+        uint64_t start_ns = get_ns();
+        uint64_t start_cycles = get_cycles();
+        for(uint32_t i = 0; i < iterations; i++)
+            stage(&frame);
+
+        double ns = (double)(get_ns() - start_ns) / iterations;
+        double cycles = (double)(get_cycles() - start_cycles) / iterations;
+        if(repeat == 0 || ns < *ns_per_packet)
+        {
+            *ns_per_packet = ns;
+            *cycles_per_packet = cycles;
+        }
+    }
+}
+
+static void prepare_frame(coding_t coding, uint16_t length)
+{
+    frame.coding = coding;
+    frame.length = length;
+    for(uint16_t i = 0; i < length; i++)
+        frame.frame[i] = rand();
+
+    frame.frame[0] = length - 1;
+    uint16_t crc = __builtin_bswap16(crc_calculate(frame.frame, length - 2));
+    memcpy(&frame.frame[length - 2], &crc, 2);
+
+    memcpy(frame.fec_encoded, frame.frame, length);
+    frame.encoded_length = length;
+    if(coding == CODING_FEC_PN9)
+        frame.encoded_length = fec_encode(frame.fec_encoded, length);
+
+    memcpy(frame.encoded, frame.fec_encoded, frame.encoded_length);
+    pn9_encode(frame.encoded, frame.encoded_length);
+
+    // make sure we are measuring a working pipeline
+    stage_rx(&frame);
+    if(memcmp(frame.buffer, frame.frame, length) != 0)
+    {
+        fprintf(stderr, "coding %i, length %i: decoded frame does not match\n", coding, length);
+        exit(1);
+    }
+}
+
+void bootstrap()
+{
+    static const coding_t codings[] = { CODING_PN9, CODING_FEC_PN9 };
+    static const char* coding_names[] = { "PN9", "FEC_PN9" };
+
+    srand(0);
+    printf("coding,stage,length,encoded_length,ns_per_packet,ns_per_byte,cycles_per_packet\n");
+    for(int c = 0; c < sizeof(codings) / sizeof(codings[0]); c++)
+    {
+        for(uint16_t length = MIN_FRAME_LENGTH; length <= MAX_FRAME_LENGTH; length++)
+        {
+            prepare_frame(codings[c], length);
+            uint32_t iterations = BYTES_PER_MEASUREMENT / length + 1;
+            double copy_ns, copy_cycles;
+            measure(&stage_copy, iterations, &copy_ns, &copy_cycles);
+            for(int s = 0; s < sizeof(stages) / sizeof(stages[0]); s++)
+            {
+                if(stages[s].fec_only && codings[c] != CODING_FEC_PN9)
+                    continue;
+
+                double ns, cycles;
+                measure(stages[s].run, iterations, &ns, &cycles);
+                ns = ns > copy_ns ? ns - copy_ns : 0;
+                cycles = cycles > copy_cycles ? cycles - copy_cycles : 0;
+                printf("%s,%s,%u,%u,%.1f,%.2f,", coding_names[c], stages[s].name, length, frame.encoded_length,
+                       ns, ns / length);
+#ifdef HAS_CYCLE_COUNTER
+                printf("%.0f", cycles);
+#endif
+                printf("\n");
+            }
+        }
+    }
+
+    exit(0);
+}
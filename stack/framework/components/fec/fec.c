@@ -26,39 +26,341 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
-#include <stdint.h>
 #include <string.h>
 
 #include "fec.h"
 
 #define INITIAL_FECSTATE 0x00
 #define TRELLIS_TERMINATOR 0x0B
-#define FEC_BUFFER_SIZE 256
+#define UNREACHABLE_COST 0x4000 // initial cost of the states the encoder can not start in
 
 #define INTERLEAVING
 
 //#ifdef D7_PHY_USE_FEC
 
-static const uint8_t fec_lut[16] = {0, 3, 1, 2, 3, 0, 2, 1, 3, 0, 2, 1, 0, 3, 1, 2};
-static const uint8_t trellis0_lut[8] = {0, 1, 3, 2, 3, 2, 0, 1};
-static const uint8_t trellis1_lut[8] = {3, 2, 0, 1, 0, 1, 3, 2};
-
-static uint8_t data_buffer[FEC_BUFFER_SIZE];
-static uint8_t* input_buffer;
-static uint8_t* output_buffer;
-
-static uint16_t packetlength;
-static uint16_t fecpacketlength;
-static uint16_t output_packet_length;
-
-static uint8_t processedbytes;
-static uint16_t fecprocessedbytes;
-
-static uint16_t pn9;
-static uint16_t fecstate;
-static VITERBISTATE vstate;
-
-static bool fec_decode(uint8_t* input);
+// fec_encode_lut[state][byte] holds the 8 symbols (first symbol in the MSBs) the convolutional encoder outputs for
+// 'byte', given the last 3 bits of the previous byte in 'state'. Generated from the symbol table
+// {0, 3, 1, 2, 3, 0, 2, 1, 3, 0, 2, 1, 0, 3, 1, 2}, indexed by the last 4 input bits.
+static const uint16_t fec_encode_lut[8][256] = {
+    {
+        0x0000, 0x0003, 0x000D, 0x000E, 0x0037, 0x0034, 0x003A, 0x0039,
+        0x00DF, 0x00DC, 0x00D2, 0x00D1, 0x00E8, 0x00EB, 0x00E5, 0x00E6,
+        0x037C, 0x037F, 0x0371, 0x0372, 0x034B, 0x0348, 0x0346, 0x0345,
+        0x03A3, 0x03A0, 0x03AE, 0x03AD, 0x0394, 0x0397, 0x0399, 0x039A,
+        0x0DF0, 0x0DF3, 0x0DFD, 0x0DFE, 0x0DC7, 0x0DC4, 0x0DCA, 0x0DC9,
+        0x0D2F, 0x0D2C, 0x0D22, 0x0D21, 0x0D18, 0x0D1B, 0x0D15, 0x0D16,
+        0x0E8C, 0x0E8F, 0x0E81, 0x0E82, 0x0EBB, 0x0EB8, 0x0EB6, 0x0EB5,
+        0x0E53, 0x0E50, 0x0E5E, 0x0E5D, 0x0E64, 0x0E67, 0x0E69, 0x0E6A,
+        0x37C0, 0x37C3, 0x37CD, 0x37CE, 0x37F7, 0x37F4, 0x37FA, 0x37F9,
+        0x371F, 0x371C, 0x3712, 0x3711, 0x3728, 0x372B, 0x3725, 0x3726,
+        0x34BC, 0x34BF, 0x34B1, 0x34B2, 0x348B, 0x3488, 0x3486, 0x3485,
+        0x3463, 0x3460, 0x346E, 0x346D, 0x3454, 0x3457, 0x3459, 0x345A,
+        0x3A30, 0x3A33, 0x3A3D, 0x3A3E, 0x3A07, 0x3A04, 0x3A0A, 0x3A09,
+        0x3AEF, 0x3AEC, 0x3AE2, 0x3AE1, 0x3AD8, 0x3ADB, 0x3AD5, 0x3AD6,
+        0x394C, 0x394F, 0x3941, 0x3942, 0x397B, 0x3978, 0x3976, 0x3975,
+        0x3993, 0x3990, 0x399E, 0x399D, 0x39A4, 0x39A7, 0x39A9, 0x39AA,
+        0xDF00, 0xDF03, 0xDF0D, 0xDF0E, 0xDF37, 0xDF34, 0xDF3A, 0xDF39,
+        0xDFDF, 0xDFDC, 0xDFD2, 0xDFD1, 0xDFE8, 0xDFEB, 0xDFE5, 0xDFE6,
+        0xDC7C, 0xDC7F, 0xDC71, 0xDC72, 0xDC4B, 0xDC48, 0xDC46, 0xDC45,
+        0xDCA3, 0xDCA0, 0xDCAE, 0xDCAD, 0xDC94, 0xDC97, 0xDC99, 0xDC9A,
+        0xD2F0, 0xD2F3, 0xD2FD, 0xD2FE, 0xD2C7, 0xD2C4, 0xD2CA, 0xD2C9,
+        0xD22F, 0xD22C, 0xD222, 0xD221, 0xD218, 0xD21B, 0xD215, 0xD216,
+        0xD18C, 0xD18F, 0xD181, 0xD182, 0xD1BB, 0xD1B8, 0xD1B6, 0xD1B5,
+        0xD153, 0xD150, 0xD15E, 0xD15D, 0xD164, 0xD167, 0xD169, 0xD16A,
+        0xE8C0, 0xE8C3, 0xE8CD, 0xE8CE, 0xE8F7, 0xE8F4, 0xE8FA, 0xE8F9,
+        0xE81F, 0xE81C, 0xE812, 0xE811, 0xE828, 0xE82B, 0xE825, 0xE826,
+        0xEBBC, 0xEBBF, 0xEBB1, 0xEBB2, 0xEB8B, 0xEB88, 0xEB86, 0xEB85,
+        0xEB63, 0xEB60, 0xEB6E, 0xEB6D, 0xEB54, 0xEB57, 0xEB59, 0xEB5A,
+        0xE530, 0xE533, 0xE53D, 0xE53E, 0xE507, 0xE504, 0xE50A, 0xE509,
+        0xE5EF, 0xE5EC, 0xE5E2, 0xE5E1, 0xE5D8, 0xE5DB, 0xE5D5, 0xE5D6,
+        0xE64C, 0xE64F, 0xE641, 0xE642, 0xE67B, 0xE678, 0xE676, 0xE675,
+        0xE693, 0xE690, 0xE69E, 0xE69D, 0xE6A4, 0xE6A7, 0xE6A9, 0xE6AA,
+    },
+    {
+        0x7C00, 0x7C03, 0x7C0D, 0x7C0E, 0x7C37, 0x7C34, 0x7C3A, 0x7C39,
+        0x7CDF, 0x7CDC, 0x7CD2, 0x7CD1, 0x7CE8, 0x7CEB, 0x7CE5, 0x7CE6,
+        0x7F7C, 0x7F7F, 0x7F71, 0x7F72, 0x7F4B, 0x7F48, 0x7F46, 0x7F45,
+        0x7FA3, 0x7FA0, 0x7FAE, 0x7FAD, 0x7F94, 0x7F97, 0x7F99, 0x7F9A,
+        0x71F0, 0x71F3, 0x71FD, 0x71FE, 0x71C7, 0x71C4, 0x71CA, 0x71C9,
+        0x712F, 0x712C, 0x7122, 0x7121, 0x7118, 0x711B, 0x7115, 0x7116,
+        0x728C, 0x728F, 0x7281, 0x7282, 0x72BB, 0x72B8, 0x72B6, 0x72B5,
+        0x7253, 0x7250, 0x725E, 0x725D, 0x7264, 0x7267, 0x7269, 0x726A,
+        0x4BC0, 0x4BC3, 0x4BCD, 0x4BCE, 0x4BF7, 0x4BF4, 0x4BFA, 0x4BF9,
+        0x4B1F, 0x4B1C, 0x4B12, 0x4B11, 0x4B28, 0x4B2B, 0x4B25, 0x4B26,
+        0x48BC, 0x48BF, 0x48B1, 0x48B2, 0x488B, 0x4888, 0x4886, 0x4885,
+        0x4863, 0x4860, 0x486E, 0x486D, 0x4854, 0x4857, 0x4859, 0x485A,
+        0x4630, 0x4633, 0x463D, 0x463E, 0x4607, 0x4604, 0x460A, 0x4609,
+        0x46EF, 0x46EC, 0x46E2, 0x46E1, 0x46D8, 0x46DB, 0x46D5, 0x46D6,
+        0x454C, 0x454F, 0x4541, 0x4542, 0x457B, 0x4578, 0x4576, 0x4575,
+        0x4593, 0x4590, 0x459E, 0x459D, 0x45A4, 0x45A7, 0x45A9, 0x45AA,
+        0xA300, 0xA303, 0xA30D, 0xA30E, 0xA337, 0xA334, 0xA33A, 0xA339,
+        0xA3DF, 0xA3DC, 0xA3D2, 0xA3D1, 0xA3E8, 0xA3EB, 0xA3E5, 0xA3E6,
+        0xA07C, 0xA07F, 0xA071, 0xA072, 0xA04B, 0xA048, 0xA046, 0xA045,
+        0xA0A3, 0xA0A0, 0xA0AE, 0xA0AD, 0xA094, 0xA097, 0xA099, 0xA09A,
+        0xAEF0, 0xAEF3, 0xAEFD, 0xAEFE, 0xAEC7, 0xAEC4, 0xAECA, 0xAEC9,
+        0xAE2F, 0xAE2C, 0xAE22, 0xAE21, 0xAE18, 0xAE1B, 0xAE15, 0xAE16,
+        0xAD8C, 0xAD8F, 0xAD81, 0xAD82, 0xADBB, 0xADB8, 0xADB6, 0xADB5,
+        0xAD53, 0xAD50, 0xAD5E, 0xAD5D, 0xAD64, 0xAD67, 0xAD69, 0xAD6A,
+        0x94C0, 0x94C3, 0x94CD, 0x94CE, 0x94F7, 0x94F4, 0x94FA, 0x94F9,
+        0x941F, 0x941C, 0x9412, 0x9411, 0x9428, 0x942B, 0x9425, 0x9426,
+        0x97BC, 0x97BF, 0x97B1, 0x97B2, 0x978B, 0x9788, 0x9786, 0x9785,
+        0x9763, 0x9760, 0x976E, 0x976D, 0x9754, 0x9757, 0x9759, 0x975A,
+        0x9930, 0x9933, 0x993D, 0x993E, 0x9907, 0x9904, 0x990A, 0x9909,
+        0x99EF, 0x99EC, 0x99E2, 0x99E1, 0x99D8, 0x99DB, 0x99D5, 0x99D6,
+        0x9A4C, 0x9A4F, 0x9A41, 0x9A42, 0x9A7B, 0x9A78, 0x9A76, 0x9A75,
+        0x9A93, 0x9A90, 0x9A9E, 0x9A9D, 0x9AA4, 0x9AA7, 0x9AA9, 0x9AAA,
+    },
+    {
+        0xF000, 0xF003, 0xF00D, 0xF00E, 0xF037, 0xF034, 0xF03A, 0xF039,
+        0xF0DF, 0xF0DC, 0xF0D2, 0xF0D1, 0xF0E8, 0xF0EB, 0xF0E5, 0xF0E6,
+        0xF37C, 0xF37F, 0xF371, 0xF372, 0xF34B, 0xF348, 0xF346, 0xF345,
+        0xF3A3, 0xF3A0, 0xF3AE, 0xF3AD, 0xF394, 0xF397, 0xF399, 0xF39A,
+        0xFDF0, 0xFDF3, 0xFDFD, 0xFDFE, 0xFDC7, 0xFDC4, 0xFDCA, 0xFDC9,
+        0xFD2F, 0xFD2C, 0xFD22, 0xFD21, 0xFD18, 0xFD1B, 0xFD15, 0xFD16,
+        0xFE8C, 0xFE8F, 0xFE81, 0xFE82, 0xFEBB, 0xFEB8, 0xFEB6, 0xFEB5,
+        0xFE53, 0xFE50, 0xFE5E, 0xFE5D, 0xFE64, 0xFE67, 0xFE69, 0xFE6A,
+        0xC7C0, 0xC7C3, 0xC7CD, 0xC7CE, 0xC7F7, 0xC7F4, 0xC7FA, 0xC7F9,
+        0xC71F, 0xC71C, 0xC712, 0xC711, 0xC728, 0xC72B, 0xC725, 0xC726,
+        0xC4BC, 0xC4BF, 0xC4B1, 0xC4B2, 0xC48B, 0xC488, 0xC486, 0xC485,
+        0xC463, 0xC460, 0xC46E, 0xC46D, 0xC454, 0xC457, 0xC459, 0xC45A,
+        0xCA30, 0xCA33, 0xCA3D, 0xCA3E, 0xCA07, 0xCA04, 0xCA0A, 0xCA09,
+        0xCAEF, 0xCAEC, 0xCAE2, 0xCAE1, 0xCAD8, 0xCADB, 0xCAD5, 0xCAD6,
+        0xC94C, 0xC94F, 0xC941, 0xC942, 0xC97B, 0xC978, 0xC976, 0xC975,
+        0xC993, 0xC990, 0xC99E, 0xC99D, 0xC9A4, 0xC9A7, 0xC9A9, 0xC9AA,
+        0x2F00, 0x2F03, 0x2F0D, 0x2F0E, 0x2F37, 0x2F34, 0x2F3A, 0x2F39,
+        0x2FDF, 0x2FDC, 0x2FD2, 0x2FD1, 0x2FE8, 0x2FEB, 0x2FE5, 0x2FE6,
+        0x2C7C, 0x2C7F, 0x2C71, 0x2C72, 0x2C4B, 0x2C48, 0x2C46, 0x2C45,
+        0x2CA3, 0x2CA0, 0x2CAE, 0x2CAD, 0x2C94, 0x2C97, 0x2C99, 0x2C9A,
+        0x22F0, 0x22F3, 0x22FD, 0x22FE, 0x22C7, 0x22C4, 0x22CA, 0x22C9,
+        0x222F, 0x222C, 0x2222, 0x2221, 0x2218, 0x221B, 0x2215, 0x2216,
+        0x218C, 0x218F, 0x2181, 0x2182, 0x21BB, 0x21B8, 0x21B6, 0x21B5,
+        0x2153, 0x2150, 0x215E, 0x215D, 0x2164, 0x2167, 0x2169, 0x216A,
+        0x18C0, 0x18C3, 0x18CD, 0x18CE, 0x18F7, 0x18F4, 0x18FA, 0x18F9,
+        0x181F, 0x181C, 0x1812, 0x1811, 0x1828, 0x182B, 0x1825, 0x1826,
+        0x1BBC, 0x1BBF, 0x1BB1, 0x1BB2, 0x1B8B, 0x1B88, 0x1B86, 0x1B85,
+        0x1B63, 0x1B60, 0x1B6E, 0x1B6D, 0x1B54, 0x1B57, 0x1B59, 0x1B5A,
+        0x1530, 0x1533, 0x153D, 0x153E, 0x1507, 0x1504, 0x150A, 0x1509,
+        0x15EF, 0x15EC, 0x15E2, 0x15E1, 0x15D8, 0x15DB, 0x15D5, 0x15D6,
+        0x164C, 0x164F, 0x1641, 0x1642, 0x167B, 0x1678, 0x1676, 0x1675,
+        0x1693, 0x1690, 0x169E, 0x169D, 0x16A4, 0x16A7, 0x16A9, 0x16AA,
+    },
+    {
+        0x8C00, 0x8C03, 0x8C0D, 0x8C0E, 0x8C37, 0x8C34, 0x8C3A, 0x8C39,
+        0x8CDF, 0x8CDC, 0x8CD2, 0x8CD1, 0x8CE8, 0x8CEB, 0x8CE5, 0x8CE6,
+        0x8F7C, 0x8F7F, 0x8F71, 0x8F72, 0x8F4B, 0x8F48, 0x8F46, 0x8F45,
+        0x8FA3, 0x8FA0, 0x8FAE, 0x8FAD, 0x8F94, 0x8F97, 0x8F99, 0x8F9A,
+        0x81F0, 0x81F3, 0x81FD, 0x81FE, 0x81C7, 0x81C4, 0x81CA, 0x81C9,
+        0x812F, 0x812C, 0x8122, 0x8121, 0x8118, 0x811B, 0x8115, 0x8116,
+        0x828C, 0x828F, 0x8281, 0x8282, 0x82BB, 0x82B8, 0x82B6, 0x82B5,
+        0x8253, 0x8250, 0x825E, 0x825D, 0x8264, 0x8267, 0x8269, 0x826A,
+        0xBBC0, 0xBBC3, 0xBBCD, 0xBBCE, 0xBBF7, 0xBBF4, 0xBBFA, 0xBBF9,
+        0xBB1F, 0xBB1C, 0xBB12, 0xBB11, 0xBB28, 0xBB2B, 0xBB25, 0xBB26,
+        0xB8BC, 0xB8BF, 0xB8B1, 0xB8B2, 0xB88B, 0xB888, 0xB886, 0xB885,
+        0xB863, 0xB860, 0xB86E, 0xB86D, 0xB854, 0xB857, 0xB859, 0xB85A,
+        0xB630, 0xB633, 0xB63D, 0xB63E, 0xB607, 0xB604, 0xB60A, 0xB609,
+        0xB6EF, 0xB6EC, 0xB6E2, 0xB6E1, 0xB6D8, 0xB6DB, 0xB6D5, 0xB6D6,
+        0xB54C, 0xB54F, 0xB541, 0xB542, 0xB57B, 0xB578, 0xB576, 0xB575,
+        0xB593, 0xB590, 0xB59E, 0xB59D, 0xB5A4, 0xB5A7, 0xB5A9, 0xB5AA,
+        0x5300, 0x5303, 0x530D, 0x530E, 0x5337, 0x5334, 0x533A, 0x5339,
+        0x53DF, 0x53DC, 0x53D2, 0x53D1, 0x53E8, 0x53EB, 0x53E5, 0x53E6,
+        0x507C, 0x507F, 0x5071, 0x5072, 0x504B, 0x5048, 0x5046, 0x5045,
+        0x50A3, 0x50A0, 0x50AE, 0x50AD, 0x5094, 0x5097, 0x5099, 0x509A,
+        0x5EF0, 0x5EF3, 0x5EFD, 0x5EFE, 0x5EC7, 0x5EC4, 0x5ECA, 0x5EC9,
+        0x5E2F, 0x5E2C, 0x5E22, 0x5E21, 0x5E18, 0x5E1B, 0x5E15, 0x5E16,
+        0x5D8C, 0x5D8F, 0x5D81, 0x5D82, 0x5DBB, 0x5DB8, 0x5DB6, 0x5DB5,
+        0x5D53, 0x5D50, 0x5D5E, 0x5D5D, 0x5D64, 0x5D67, 0x5D69, 0x5D6A,
+        0x64C0, 0x64C3, 0x64CD, 0x64CE, 0x64F7, 0x64F4, 0x64FA, 0x64F9,
+        0x641F, 0x641C, 0x6412, 0x6411, 0x6428, 0x642B, 0x6425, 0x6426,
+        0x67BC, 0x67BF, 0x67B1, 0x67B2, 0x678B, 0x6788, 0x6786, 0x6785,
+        0x6763, 0x6760, 0x676E, 0x676D, 0x6754, 0x6757, 0x6759, 0x675A,
+        0x6930, 0x6933, 0x693D, 0x693E, 0x6907, 0x6904, 0x690A, 0x6909,
+        0x69EF, 0x69EC, 0x69E2, 0x69E1, 0x69D8, 0x69DB, 0x69D5, 0x69D6,
+        0x6A4C, 0x6A4F, 0x6A41, 0x6A42, 0x6A7B, 0x6A78, 0x6A76, 0x6A75,
+        0x6A93, 0x6A90, 0x6A9E, 0x6A9D, 0x6AA4, 0x6AA7, 0x6AA9, 0x6AAA,
+    },
+    {
+        0xC000, 0xC003, 0xC00D, 0xC00E, 0xC037, 0xC034, 0xC03A, 0xC039,
+        0xC0DF, 0xC0DC, 0xC0D2, 0xC0D1, 0xC0E8, 0xC0EB, 0xC0E5, 0xC0E6,
+        0xC37C, 0xC37F, 0xC371, 0xC372, 0xC34B, 0xC348, 0xC346, 0xC345,
+        0xC3A3, 0xC3A0, 0xC3AE, 0xC3AD, 0xC394, 0xC397, 0xC399, 0xC39A,
+        0xCDF0, 0xCDF3, 0xCDFD, 0xCDFE, 0xCDC7, 0xCDC4, 0xCDCA, 0xCDC9,
+        0xCD2F, 0xCD2C, 0xCD22, 0xCD21, 0xCD18, 0xCD1B, 0xCD15, 0xCD16,
+        0xCE8C, 0xCE8F, 0xCE81, 0xCE82, 0xCEBB, 0xCEB8, 0xCEB6, 0xCEB5,
+        0xCE53, 0xCE50, 0xCE5E, 0xCE5D, 0xCE64, 0xCE67, 0xCE69, 0xCE6A,
+        0xF7C0, 0xF7C3, 0xF7CD, 0xF7CE, 0xF7F7, 0xF7F4, 0xF7FA, 0xF7F9,
+        0xF71F, 0xF71C, 0xF712, 0xF711, 0xF728, 0xF72B, 0xF725, 0xF726,
+        0xF4BC, 0xF4BF, 0xF4B1, 0xF4B2, 0xF48B, 0xF488, 0xF486, 0xF485,
+        0xF463, 0xF460, 0xF46E, 0xF46D, 0xF454, 0xF457, 0xF459, 0xF45A,
+        0xFA30, 0xFA33, 0xFA3D, 0xFA3E, 0xFA07, 0xFA04, 0xFA0A, 0xFA09,
+        0xFAEF, 0xFAEC, 0xFAE2, 0xFAE1, 0xFAD8, 0xFADB, 0xFAD5, 0xFAD6,
+        0xF94C, 0xF94F, 0xF941, 0xF942, 0xF97B, 0xF978, 0xF976, 0xF975,
+        0xF993, 0xF990, 0xF99E, 0xF99D, 0xF9A4, 0xF9A7, 0xF9A9, 0xF9AA,
+        0x1F00, 0x1F03, 0x1F0D, 0x1F0E, 0x1F37, 0x1F34, 0x1F3A, 0x1F39,
+        0x1FDF, 0x1FDC, 0x1FD2, 0x1FD1, 0x1FE8, 0x1FEB, 0x1FE5, 0x1FE6,
+        0x1C7C, 0x1C7F, 0x1C71, 0x1C72, 0x1C4B, 0x1C48, 0x1C46, 0x1C45,
+        0x1CA3, 0x1CA0, 0x1CAE, 0x1CAD, 0x1C94, 0x1C97, 0x1C99, 0x1C9A,
+        0x12F0, 0x12F3, 0x12FD, 0x12FE, 0x12C7, 0x12C4, 0x12CA, 0x12C9,
+        0x122F, 0x122C, 0x1222, 0x1221, 0x1218, 0x121B, 0x1215, 0x1216,
+        0x118C, 0x118F, 0x1181, 0x1182, 0x11BB, 0x11B8, 0x11B6, 0x11B5,
+        0x1153, 0x1150, 0x115E, 0x115D, 0x1164, 0x1167, 0x1169, 0x116A,
+        0x28C0, 0x28C3, 0x28CD, 0x28CE, 0x28F7, 0x28F4, 0x28FA, 0x28F9,
+        0x281F, 0x281C, 0x2812, 0x2811, 0x2828, 0x282B, 0x2825, 0x2826,
+        0x2BBC, 0x2BBF, 0x2BB1, 0x2BB2, 0x2B8B, 0x2B88, 0x2B86, 0x2B85,
+        0x2B63, 0x2B60, 0x2B6E, 0x2B6D, 0x2B54, 0x2B57, 0x2B59, 0x2B5A,
+        0x2530, 0x2533, 0x253D, 0x253E, 0x2507, 0x2504, 0x250A, 0x2509,
+        0x25EF, 0x25EC, 0x25E2, 0x25E1, 0x25D8, 0x25DB, 0x25D5, 0x25D6,
+        0x264C, 0x264F, 0x2641, 0x2642, 0x267B, 0x2678, 0x2676, 0x2675,
+        0x2693, 0x2690, 0x269E, 0x269D, 0x26A4, 0x26A7, 0x26A9, 0x26AA,
+    },
+    {
+        0xBC00, 0xBC03, 0xBC0D, 0xBC0E, 0xBC37, 0xBC34, 0xBC3A, 0xBC39,
+        0xBCDF, 0xBCDC, 0xBCD2, 0xBCD1, 0xBCE8, 0xBCEB, 0xBCE5, 0xBCE6,
+        0xBF7C, 0xBF7F, 0xBF71, 0xBF72, 0xBF4B, 0xBF48, 0xBF46, 0xBF45,
+        0xBFA3, 0xBFA0, 0xBFAE, 0xBFAD, 0xBF94, 0xBF97, 0xBF99, 0xBF9A,
+        0xB1F0, 0xB1F3, 0xB1FD, 0xB1FE, 0xB1C7, 0xB1C4, 0xB1CA, 0xB1C9,
+        0xB12F, 0xB12C, 0xB122, 0xB121, 0xB118, 0xB11B, 0xB115, 0xB116,
+        0xB28C, 0xB28F, 0xB281, 0xB282, 0xB2BB, 0xB2B8, 0xB2B6, 0xB2B5,
+        0xB253, 0xB250, 0xB25E, 0xB25D, 0xB264, 0xB267, 0xB269, 0xB26A,
+        0x8BC0, 0x8BC3, 0x8BCD, 0x8BCE, 0x8BF7, 0x8BF4, 0x8BFA, 0x8BF9,
+        0x8B1F, 0x8B1C, 0x8B12, 0x8B11, 0x8B28, 0x8B2B, 0x8B25, 0x8B26,
+        0x88BC, 0x88BF, 0x88B1, 0x88B2, 0x888B, 0x8888, 0x8886, 0x8885,
+        0x8863, 0x8860, 0x886E, 0x886D, 0x8854, 0x8857, 0x8859, 0x885A,
+        0x8630, 0x8633, 0x863D, 0x863E, 0x8607, 0x8604, 0x860A, 0x8609,
+        0x86EF, 0x86EC, 0x86E2, 0x86E1, 0x86D8, 0x86DB, 0x86D5, 0x86D6,
+        0x854C, 0x854F, 0x8541, 0x8542, 0x857B, 0x8578, 0x8576, 0x8575,
+        0x8593, 0x8590, 0x859E, 0x859D, 0x85A4, 0x85A7, 0x85A9, 0x85AA,
+        0x6300, 0x6303, 0x630D, 0x630E, 0x6337, 0x6334, 0x633A, 0x6339,
+        0x63DF, 0x63DC, 0x63D2, 0x63D1, 0x63E8, 0x63EB, 0x63E5, 0x63E6,
+        0x607C, 0x607F, 0x6071, 0x6072, 0x604B, 0x6048, 0x6046, 0x6045,
+        0x60A3, 0x60A0, 0x60AE, 0x60AD, 0x6094, 0x6097, 0x6099, 0x609A,
+        0x6EF0, 0x6EF3, 0x6EFD, 0x6EFE, 0x6EC7, 0x6EC4, 0x6ECA, 0x6EC9,
+        0x6E2F, 0x6E2C, 0x6E22, 0x6E21, 0x6E18, 0x6E1B, 0x6E15, 0x6E16,
+        0x6D8C, 0x6D8F, 0x6D81, 0x6D82, 0x6DBB, 0x6DB8, 0x6DB6, 0x6DB5,
+        0x6D53, 0x6D50, 0x6D5E, 0x6D5D, 0x6D64, 0x6D67, 0x6D69, 0x6D6A,
+        0x54C0, 0x54C3, 0x54CD, 0x54CE, 0x54F7, 0x54F4, 0x54FA, 0x54F9,
+        0x541F, 0x541C, 0x5412, 0x5411, 0x5428, 0x542B, 0x5425, 0x5426,
+        0x57BC, 0x57BF, 0x57B1, 0x57B2, 0x578B, 0x5788, 0x5786, 0x5785,
+        0x5763, 0x5760, 0x576E, 0x576D, 0x5754, 0x5757, 0x5759, 0x575A,
+        0x5930, 0x5933, 0x593D, 0x593E, 0x5907, 0x5904, 0x590A, 0x5909,
+        0x59EF, 0x59EC, 0x59E2, 0x59E1, 0x59D8, 0x59DB, 0x59D5, 0x59D6,
+        0x5A4C, 0x5A4F, 0x5A41, 0x5A42, 0x5A7B, 0x5A78, 0x5A76, 0x5A75,
+        0x5A93, 0x5A90, 0x5A9E, 0x5A9D, 0x5AA4, 0x5AA7, 0x5AA9, 0x5AAA,
+    },
+    {
+        0x3000, 0x3003, 0x300D, 0x300E, 0x3037, 0x3034, 0x303A, 0x3039,
+        0x30DF, 0x30DC, 0x30D2, 0x30D1, 0x30E8, 0x30EB, 0x30E5, 0x30E6,
+        0x337C, 0x337F, 0x3371, 0x3372, 0x334B, 0x3348, 0x3346, 0x3345,
+        0x33A3, 0x33A0, 0x33AE, 0x33AD, 0x3394, 0x3397, 0x3399, 0x339A,
+        0x3DF0, 0x3DF3, 0x3DFD, 0x3DFE, 0x3DC7, 0x3DC4, 0x3DCA, 0x3DC9,
+        0x3D2F, 0x3D2C, 0x3D22, 0x3D21, 0x3D18, 0x3D1B, 0x3D15, 0x3D16,
+        0x3E8C, 0x3E8F, 0x3E81, 0x3E82, 0x3EBB, 0x3EB8, 0x3EB6, 0x3EB5,
+        0x3E53, 0x3E50, 0x3E5E, 0x3E5D, 0x3E64, 0x3E67, 0x3E69, 0x3E6A,
+        0x07C0, 0x07C3, 0x07CD, 0x07CE, 0x07F7, 0x07F4, 0x07FA, 0x07F9,
+        0x071F, 0x071C, 0x0712, 0x0711, 0x0728, 0x072B, 0x0725, 0x0726,
+        0x04BC, 0x04BF, 0x04B1, 0x04B2, 0x048B, 0x0488, 0x0486, 0x0485,
+        0x0463, 0x0460, 0x046E, 0x046D, 0x0454, 0x0457, 0x0459, 0x045A,
+        0x0A30, 0x0A33, 0x0A3D, 0x0A3E, 0x0A07, 0x0A04, 0x0A0A, 0x0A09,
+        0x0AEF, 0x0AEC, 0x0AE2, 0x0AE1, 0x0AD8, 0x0ADB, 0x0AD5, 0x0AD6,
+        0x094C, 0x094F, 0x0941, 0x0942, 0x097B, 0x0978, 0x0976, 0x0975,
+        0x0993, 0x0990, 0x099E, 0x099D, 0x09A4, 0x09A7, 0x09A9, 0x09AA,
+        0xEF00, 0xEF03, 0xEF0D, 0xEF0E, 0xEF37, 0xEF34, 0xEF3A, 0xEF39,
+        0xEFDF, 0xEFDC, 0xEFD2, 0xEFD1, 0xEFE8, 0xEFEB, 0xEFE5, 0xEFE6,
+        0xEC7C, 0xEC7F, 0xEC71, 0xEC72, 0xEC4B, 0xEC48, 0xEC46, 0xEC45,
+        0xECA3, 0xECA0, 0xECAE, 0xECAD, 0xEC94, 0xEC97, 0xEC99, 0xEC9A,
+        0xE2F0, 0xE2F3, 0xE2FD, 0xE2FE, 0xE2C7, 0xE2C4, 0xE2CA, 0xE2C9,
+        0xE22F, 0xE22C, 0xE222, 0xE221, 0xE218, 0xE21B, 0xE215, 0xE216,
+        0xE18C, 0xE18F, 0xE181, 0xE182, 0xE1BB, 0xE1B8, 0xE1B6, 0xE1B5,
+        0xE153, 0xE150, 0xE15E, 0xE15D, 0xE164, 0xE167, 0xE169, 0xE16A,
+        0xD8C0, 0xD8C3, 0xD8CD, 0xD8CE, 0xD8F7, 0xD8F4, 0xD8FA, 0xD8F9,
+        0xD81F, 0xD81C, 0xD812, 0xD811, 0xD828, 0xD82B, 0xD825, 0xD826,
+        0xDBBC, 0xDBBF, 0xDBB1, 0xDBB2, 0xDB8B, 0xDB88, 0xDB86, 0xDB85,
+        0xDB63, 0xDB60, 0xDB6E, 0xDB6D, 0xDB54, 0xDB57, 0xDB59, 0xDB5A,
+        0xD530, 0xD533, 0xD53D, 0xD53E, 0xD507, 0xD504, 0xD50A, 0xD509,
+        0xD5EF, 0xD5EC, 0xD5E2, 0xD5E1, 0xD5D8, 0xD5DB, 0xD5D5, 0xD5D6,
+        0xD64C, 0xD64F, 0xD641, 0xD642, 0xD67B, 0xD678, 0xD676, 0xD675,
+        0xD693, 0xD690, 0xD69E, 0xD69D, 0xD6A4, 0xD6A7, 0xD6A9, 0xD6AA,
+    },
+    {
+        0x4C00, 0x4C03, 0x4C0D, 0x4C0E, 0x4C37, 0x4C34, 0x4C3A, 0x4C39,
+        0x4CDF, 0x4CDC, 0x4CD2, 0x4CD1, 0x4CE8, 0x4CEB, 0x4CE5, 0x4CE6,
+        0x4F7C, 0x4F7F, 0x4F71, 0x4F72, 0x4F4B, 0x4F48, 0x4F46, 0x4F45,
+        0x4FA3, 0x4FA0, 0x4FAE, 0x4FAD, 0x4F94, 0x4F97, 0x4F99, 0x4F9A,
+        0x41F0, 0x41F3, 0x41FD, 0x41FE, 0x41C7, 0x41C4, 0x41CA, 0x41C9,
+        0x412F, 0x412C, 0x4122, 0x4121, 0x4118, 0x411B, 0x4115, 0x4116,
+        0x428C, 0x428F, 0x4281, 0x4282, 0x42BB, 0x42B8, 0x42B6, 0x42B5,
+        0x4253, 0x4250, 0x425E, 0x425D, 0x4264, 0x4267, 0x4269, 0x426A,
+        0x7BC0, 0x7BC3, 0x7BCD, 0x7BCE, 0x7BF7, 0x7BF4, 0x7BFA, 0x7BF9,
+        0x7B1F, 0x7B1C, 0x7B12, 0x7B11, 0x7B28, 0x7B2B, 0x7B25, 0x7B26,
+        0x78BC, 0x78BF, 0x78B1, 0x78B2, 0x788B, 0x7888, 0x7886, 0x7885,
+        0x7863, 0x7860, 0x786E, 0x786D, 0x7854, 0x7857, 0x7859, 0x785A,
+        0x7630, 0x7633, 0x763D, 0x763E, 0x7607, 0x7604, 0x760A, 0x7609,
+        0x76EF, 0x76EC, 0x76E2, 0x76E1, 0x76D8, 0x76DB, 0x76D5, 0x76D6,
+        0x754C, 0x754F, 0x7541, 0x7542, 0x757B, 0x7578, 0x7576, 0x7575,
+        0x7593, 0x7590, 0x759E, 0x759D, 0x75A4, 0x75A7, 0x75A9, 0x75AA,
+        0x9300, 0x9303, 0x930D, 0x930E, 0x9337, 0x9334, 0x933A, 0x9339,
+        0x93DF, 0x93DC, 0x93D2, 0x93D1, 0x93E8, 0x93EB, 0x93E5, 0x93E6,
+        0x907C, 0x907F, 0x9071, 0x9072, 0x904B, 0x9048, 0x9046, 0x9045,
+        0x90A3, 0x90A0, 0x90AE, 0x90AD, 0x9094, 0x9097, 0x9099, 0x909A,
+        0x9EF0, 0x9EF3, 0x9EFD, 0x9EFE, 0x9EC7, 0x9EC4, 0x9ECA, 0x9EC9,
+        0x9E2F, 0x9E2C, 0x9E22, 0x9E21, 0x9E18, 0x9E1B, 0x9E15, 0x9E16,
+        0x9D8C, 0x9D8F, 0x9D81, 0x9D82, 0x9DBB, 0x9DB8, 0x9DB6, 0x9DB5,
+        0x9D53, 0x9D50, 0x9D5E, 0x9D5D, 0x9D64, 0x9D67, 0x9D69, 0x9D6A,
+        0xA4C0, 0xA4C3, 0xA4CD, 0xA4CE, 0xA4F7, 0xA4F4, 0xA4FA, 0xA4F9,
+        0xA41F, 0xA41C, 0xA412, 0xA411, 0xA428, 0xA42B, 0xA425, 0xA426,
+        0xA7BC, 0xA7BF, 0xA7B1, 0xA7B2, 0xA78B, 0xA788, 0xA786, 0xA785,
+        0xA763, 0xA760, 0xA76E, 0xA76D, 0xA754, 0xA757, 0xA759, 0xA75A,
+        0xA930, 0xA933, 0xA93D, 0xA93E, 0xA907, 0xA904, 0xA90A, 0xA909,
+        0xA9EF, 0xA9EC, 0xA9E2, 0xA9E1, 0xA9D8, 0xA9DB, 0xA9D5, 0xA9D6,
+        0xAA4C, 0xAA4F, 0xAA41, 0xAA42, 0xAA7B, 0xAA78, 0xAA76, 0xAA75,
+        0xAA93, 0xAA90, 0xAA9E, 0xAA9D, 0xAAA4, 0xAAA7, 0xAAA9, 0xAAAA,
+    },
+};
+
+// Interleaving transposes 4 bytes of 4 symbols each: symbol k of byte n becomes symbol n of byte k.
+// fec_interleave_lut[byte] spreads the symbols of a byte over the lowest bits of the 4 bytes of a word,
+// the same table de-interleaves.
+static const uint32_t fec_interleave_lut[256] = {
+    0x00000000, 0x00000001, 0x00000002, 0x00000003, 0x00000100, 0x00000101, 0x00000102, 0x00000103,
+    0x00000200, 0x00000201, 0x00000202, 0x00000203, 0x00000300, 0x00000301, 0x00000302, 0x00000303,
+    0x00010000, 0x00010001, 0x00010002, 0x00010003, 0x00010100, 0x00010101, 0x00010102, 0x00010103,
+    0x00010200, 0x00010201, 0x00010202, 0x00010203, 0x00010300, 0x00010301, 0x00010302, 0x00010303,
+    0x00020000, 0x00020001, 0x00020002, 0x00020003, 0x00020100, 0x00020101, 0x00020102, 0x00020103,
+    0x00020200, 0x00020201, 0x00020202, 0x00020203, 0x00020300, 0x00020301, 0x00020302, 0x00020303,
+    0x00030000, 0x00030001, 0x00030002, 0x00030003, 0x00030100, 0x00030101, 0x00030102, 0x00030103,
+    0x00030200, 0x00030201, 0x00030202, 0x00030203, 0x00030300, 0x00030301, 0x00030302, 0x00030303,
+    0x01000000, 0x01000001, 0x01000002, 0x01000003, 0x01000100, 0x01000101, 0x01000102, 0x01000103,
+    0x01000200, 0x01000201, 0x01000202, 0x01000203, 0x01000300, 0x01000301, 0x01000302, 0x01000303,
+    0x01010000, 0x01010001, 0x01010002, 0x01010003, 0x01010100, 0x01010101, 0x01010102, 0x01010103,
+    0x01010200, 0x01010201, 0x01010202, 0x01010203, 0x01010300, 0x01010301, 0x01010302, 0x01010303,
+    0x01020000, 0x01020001, 0x01020002, 0x01020003, 0x01020100, 0x01020101, 0x01020102, 0x01020103,
+    0x01020200, 0x01020201, 0x01020202, 0x01020203, 0x01020300, 0x01020301, 0x01020302, 0x01020303,
+    0x01030000, 0x01030001, 0x01030002, 0x01030003, 0x01030100, 0x01030101, 0x01030102, 0x01030103,
+    0x01030200, 0x01030201, 0x01030202, 0x01030203, 0x01030300, 0x01030301, 0x01030302, 0x01030303,
+    0x02000000, 0x02000001, 0x02000002, 0x02000003, 0x02000100, 0x02000101, 0x02000102, 0x02000103,
+    0x02000200, 0x02000201, 0x02000202, 0x02000203, 0x02000300, 0x02000301, 0x02000302, 0x02000303,
+    0x02010000, 0x02010001, 0x02010002, 0x02010003, 0x02010100, 0x02010101, 0x02010102, 0x02010103,
+    0x02010200, 0x02010201, 0x02010202, 0x02010203, 0x02010300, 0x02010301, 0x02010302, 0x02010303,
+    0x02020000, 0x02020001, 0x02020002, 0x02020003, 0x02020100, 0x02020101, 0x02020102, 0x02020103,
+    0x02020200, 0x02020201, 0x02020202, 0x02020203, 0x02020300, 0x02020301, 0x02020302, 0x02020303,
+    0x02030000, 0x02030001, 0x02030002, 0x02030003, 0x02030100, 0x02030101, 0x02030102, 0x02030103,
+    0x02030200, 0x02030201, 0x02030202, 0x02030203, 0x02030300, 0x02030301, 0x02030302, 0x02030303,
+    0x03000000, 0x03000001, 0x03000002, 0x03000003, 0x03000100, 0x03000101, 0x03000102, 0x03000103,
+    0x03000200, 0x03000201, 0x03000202, 0x03000203, 0x03000300, 0x03000301, 0x03000302, 0x03000303,
+    0x03010000, 0x03010001, 0x03010002, 0x03010003, 0x03010100, 0x03010101, 0x03010102, 0x03010103,
+    0x03010200, 0x03010201, 0x03010202, 0x03010203, 0x03010300, 0x03010301, 0x03010302, 0x03010303,
+    0x03020000, 0x03020001, 0x03020002, 0x03020003, 0x03020100, 0x03020101, 0x03020102, 0x03020103,
+    0x03020200, 0x03020201, 0x03020202, 0x03020203, 0x03020300, 0x03020301, 0x03020302, 0x03020303,
+    0x03030000, 0x03030001, 0x03030002, 0x03030003, 0x03030100, 0x03030101, 0x03030102, 0x03030103,
+    0x03030200, 0x03030201, 0x03030202, 0x03030203, 0x03030300, 0x03030301, 0x03030302, 0x03030303,
+};
+
+// hamming distance between a received hard decision symbol and each possible symbol
+static const uint16_t hard_metric_lut[4][4] = {
+	{0, 1, 1, 2},
+	{1, 0, 2, 1},
+	{1, 2, 0, 1},
+	{2, 1, 1, 0},
+};
 
 #if defined(FRAMEWORK_LOG_ENABLED) && defined(FRAMEWORK_PHY_LOG_ENABLED) // TODO more granular (LOG_PHY_ENABLED)
 #define DPRINT(...) log_print_stack_string(LOG_STACK_PHY, __VA_ARGS__)
@@ -68,341 +370,278 @@ static bool fec_decode(uint8_t* input);
 #define DPRINT_DATA(...)
 #endif
 
-//void print_array(uint8_t* buffer, uint8_t length)
-//	for (i = 0; i < length; i++)
-//void print_array(uint8_t* buffer, uint8_t length)
-//{
-//	int i = 0;
-//	for (; i < length; i++)
-//	{
-//	    printf("%02X", buffer[i]);
-//	}
-//	printf(" ");
-//
-//	for (i = 0; i < length; i++)
-//	{
-//		printf("%s", byte_to_binary(buffer[i]));
-//	}
-//}
-
-const char *int_to_binary(uint16_t x)
-{
-    static char b[17];
-    b[0] = '\0';
-
-    uint16_t z;
-    for (z = 0x8000; z > 0; z >>= 1)
-    {
-        strcat(b, ((x & z) == z) ? "1" : "0");
-    }
-
-    return b;
-}
-
-static void print_vstate()
+uint16_t fec_calculated_decoded_length(uint16_t packet_length)
 {
-//	typedef struct {
-//		uint8_t cost;
-//		uint16_t path;
-//	} VITERBIPATH;
-//	typedef struct {
-//		uint8_t path_size;
-//		VITERBIPATH* old;
-//		VITERBIPATH* new;
-//		VITERBIPATH states1[8];
-//		VITERBIPATH states2[8];
-//	} VITERBISTATE;
-
-  DPRINT("VSTATE:\n");
-  DPRINT(" - path_size: %d\n", vstate.path_size);
-	//printf(" - old: %03d - %s\n", vstate.old->cost, int_to_binary(vstate.old->path));
-	//printf(" - new: %03d - %s\n", vstate.new->cost, int_to_binary(vstate.new->path));
-	int i;
-	for (i=0;i<8;i++)
-    DPRINT(" - states - %d: %03d - %s\n", i, vstate.old[i].cost, int_to_binary(vstate.old[i].path));
-
+	return 2* (packet_length + 2 - (packet_length % 2));
 }
 
-
-uint16_t fec_calculated_decoded_length(uint16_t packet_length)
+static inline uint8_t encoder_input(const uint8_t *data, uint16_t nbytes, int32_t i)
 {
-	return 2* (packet_length + 2 - (packet_length % 2));
+	return (i < nbytes) ? data[i] : TRELLIS_TERMINATOR;
 }
 
-/* Convolutional encoder */
+/* Convolutional encoder
+ *
+ * Every pair of input bytes results in 4 interleaved output bytes at twice the input offset. Since the encoder state
+ * only depends on the previous input byte the pairs are encoded from the back, so the data can be encoded in place
+ * without overwriting input which is still needed.
+ */
 uint16_t fec_encode(uint8_t *data, uint16_t nbytes)
 {
-	memcpy(data_buffer, data, nbytes);
-	uint8_t *input = data_buffer;
-	unsigned int encstate = 0;
-	int i;
-
-	int termintor_bytes = 2 + nbytes%2;
-	//printf("Length %d -> terminator %d\n", nbytes, termintor_bytes);
-	nbytes+=termintor_bytes;
-	uint16_t length = 0;
-	uint8_t fecbuffer[4] = {0,0,0,0};
-
-	int8_t buffer_pointer = 0;
-	while(nbytes-- > 0){
-		if (nbytes < termintor_bytes) *input = TRELLIS_TERMINATOR;
-
-		//printf("%02X:", *input);
-
-		int j = 6;
-		for(i=7;i>=0;i--){
-				encstate = (encstate << 1) | ((*input >> i) & 1);
-				fecbuffer[buffer_pointer] |= fec_lut[encstate & 0x0F] << j;
-				j -=2;
-
-				//printf("%d: %d - %d -> %s\n",j+2, ((*input >> i) & 1), encstate & 0x0F, byte_to_binary(fec_lut[encstate & 0x0F]));
-				if (j < 0)
-				{
-//						//fecbuffer[buffer_pointer] = 0;
-					buffer_pointer++;
-					j = 6;
-//						length++;
-				}
-		}
+	int32_t total_bytes = nbytes + 2 + nbytes%2; // including the trellis terminator
+	int32_t i;
+
+	for (i = total_bytes - 2; i >= 0; i -= 2)
+	{
+		uint8_t state = (i > 0) ? (encoder_input(data, nbytes, i - 1) & 0x07) : INITIAL_FECSTATE;
+		uint8_t byte0 = encoder_input(data, nbytes, i);
+		uint8_t byte1 = encoder_input(data, nbytes, i + 1);
+		uint16_t symbols0 = fec_encode_lut[state][byte0];
+		uint16_t symbols1 = fec_encode_lut[byte0 & 0x07][byte1];
 
-		if (buffer_pointer == 4)
-		{
 #ifdef INTERLEAVING
-			//printf("Non: "); print_array(fecbuffer, 4); printf("\n");
-			//Interleaving and write to output buffer
-			*data++ = ((fecbuffer[0] & 0x03)) |\
-						((fecbuffer[1] & 0x03) << 2) |\
-						((fecbuffer[2] & 0x03) << 4) |\
-						((fecbuffer[3] & 0x03) << 6);
-			*data++ = (((fecbuffer[0] >> 2) & 0x03)) |\
-							(((fecbuffer[1] >> 2) & 0x03) << 2) |\
-							(((fecbuffer[2] >> 2) & 0x03) << 4) |\
-							(((fecbuffer[3] >> 2) & 0x03) << 6);
-			*data++ = (((fecbuffer[0] >> 4) & 0x03)) |\
-							(((fecbuffer[1] >> 4) & 0x03) << 2) |\
-							(((fecbuffer[2] >> 4) & 0x03) << 4) |\
-							(((fecbuffer[3] >> 4) & 0x03) << 6);
-			*data++ = (((fecbuffer[0] >> 6) & 0x03)) |\
-							(((fecbuffer[1] >> 6) & 0x03) << 2) |\
-							(((fecbuffer[2] >> 6) & 0x03) << 4) |\
-							(((fecbuffer[3] >> 6) & 0x03) << 6);
-			//printf("Int: "); print_array(output-4, 4); printf("\n");
+		uint32_t interleaved = fec_interleave_lut[symbols0 >> 8] |
+				(fec_interleave_lut[symbols0 & 0xFF] << 2) |
+				(fec_interleave_lut[symbols1 >> 8] << 4) |
+				(fec_interleave_lut[symbols1 & 0xFF] << 6);
+		data[2*i] = interleaved;
+		data[2*i + 1] = interleaved >> 8;
+		data[2*i + 2] = interleaved >> 16;
+		data[2*i + 3] = interleaved >> 24;
 #else
-			*output++ = fecbuffer[0];
-			*output++ = fecbuffer[1];
-			*output++ = fecbuffer[2];
-			*output++ = fecbuffer[3];
-
+		data[2*i] = symbols0 >> 8;
+		data[2*i + 1] = symbols0;
+		data[2*i + 2] = symbols1 >> 8;
+		data[2*i + 3] = symbols1;
 #endif
-			buffer_pointer=0;
-			fecbuffer[0] = 0;
-			fecbuffer[1] = 0;
-			fecbuffer[2] = 0;
-			fecbuffer[3] = 0;
-			length+=4;
-		}
-
-
-		//printf("%02X%02X ", *(output-2), *(output-1));
+	}
 
-		input++;
+	return 2 * total_bytes;
+}
 
+void fec_decoder_init(fec_decoder_t *decoder)
+{
+	uint8_t k;
+	for (k = 0; k < FEC_DECODER_STATES; k++)
+	{
+		decoder->cost[k] = UNREACHABLE_COST;
+		decoder->path[k] = 0;
 	}
 
-
-	//printf("\n");
-	return length;
+	decoder->cost[INITIAL_FECSTATE] = 0;
+	decoder->path_size = 0;
 }
 
-uint16_t fec_decode_packet(uint8_t* data, uint16_t packet_length, uint16_t output_length)
+// The symbol of the transition from state s to state 2s, for s = 0..3. The transition from s to 2s + 1 and from
+// s + 4 to 2s output the inverted symbol, the transition from s + 4 to 2s + 1 outputs the same symbol.
+static const uint8_t butterfly_symbol[4] = {0, 1, 3, 2};
+
+/* Add-compare-select for one received symbol, given the branch metric of each of the 4 possible symbols.
+ *
+ * The trellis consists of 4 butterflies: states s and s + 4 both lead to states 2s and 2s + 1. The even and odd
+ * successors are calculated in separate arrays which are only interleaved at the end, since the new costs and paths
+ * can not overwrite the old ones while those are still read.
+ */
+static inline void decode_symbol(uint16_t *cost, uint16_t *path, const uint16_t *metric)
 {
-	uint8_t* output = data_buffer;
-	if(output_length < packet_length)
+	uint16_t metric0[4], metric1[4];
+	uint16_t even_cost[4], odd_cost[4], even_path[4], odd_path[4];
+	int s;
+	for (s = 0; s < 4; s++)
 	{
-		DPRINT("FEC decoding error: buffer to small\n");
-		return 0;
+		metric0[s] = metric[butterfly_symbol[s]];
+		metric1[s] = metric[butterfly_symbol[s] ^ 3];
+	}
+	for (s = 0; s < 4; s++)
+	{
+		uint16_t a = cost[s] + metric0[s], b = cost[s + 4] + metric1[s];
+		even_cost[s] = a <= b ? a : b;
+		even_path[s] = (a <= b ? path[s] : path[s + 4]) << 1;
+		a = cost[s] + metric1[s]; b = cost[s + 4] + metric0[s];
+		odd_cost[s] = a <= b ? a : b;
+		odd_path[s] = ((a <= b ? path[s] : path[s + 4]) << 1) | 1;
+	}
+	for (s = 0; s < 4; s++)
+	{
+		cost[2 * s] = even_cost[s];
+		cost[2 * s + 1] = odd_cost[s];
+		path[2 * s] = even_path[s];
+		path[2 * s + 1] = odd_path[s];
 	}
+}
 
-	if(packet_length % 4 != 0)
+static inline uint8_t lowest_cost_state(const uint16_t *cost)
+{
+	uint8_t min_state = 0;
+	int8_t j;
+
+	for (j = FEC_DECODER_STATES - 1; j != 0; j--)
 	{
-		DPRINT("FEC decoding error: data 32 bit aligned\n");
-		return 0;
+		if (cost[j] < cost[min_state])
+			min_state = j;
 	}
 
-	output_buffer = output;
-	packetlength = packet_length;
-	output_packet_length = output_length;
+	return min_state;
+}
 
-	processedbytes = 0;
-	fecprocessedbytes = 0;
+/* Called after every 8 symbols, outputs the byte before the one that was just decoded */
+static inline uint8_t decode_byte_done(uint16_t *cost, const uint16_t *path, uint8_t *path_size, uint8_t *output)
+{
+	if (++(*path_size) < 2)
+		return 0;
 
-	vstate.path_size = 0;
+	uint8_t min_state = lowest_cost_state(cost);
+	uint16_t min_cost = cost[min_state];
+	uint8_t j;
 
-	vstate.states1[0].cost = 0;
-	int16_t i;
-	for (i=1;i<8;i++)
-			vstate.states1[i].cost = 100;
+	//Normalize costs
+	for (j = 0; j < FEC_DECODER_STATES; j++)
+		cost[j] -= min_cost;
 
-	vstate.old = vstate.states1;
-	vstate.new = vstate.states2;
+	*output = path[min_state] >> 8;
+	(*path_size)--;
+	return 1;
+}
 
-	uint16_t decoded_length = 0;
+uint8_t fec_decode_block(fec_decoder_t *decoder, const uint8_t *input, uint8_t *output)
+{
+	uint16_t cost[FEC_DECODER_STATES];
+	uint16_t path[FEC_DECODER_STATES];
+	uint8_t path_size = decoder->path_size;
+	uint8_t fecbuffer[4];
+	uint8_t decoded = 0;
+	uint8_t i;
+	int8_t j;
 
-	for(i = 0; i < packet_length; i = i + 4)
+	//Deinterleaving
+#ifdef INTERLEAVING
+	uint32_t deinterleaved = fec_interleave_lut[input[0]] |
+			(fec_interleave_lut[input[1]] << 2) |
+			(fec_interleave_lut[input[2]] << 4) |
+			(fec_interleave_lut[input[3]] << 6);
+	fecbuffer[0] = deinterleaved;
+	fecbuffer[1] = deinterleaved >> 8;
+	fecbuffer[2] = deinterleaved >> 16;
+	fecbuffer[3] = deinterleaved >> 24;
+#else
+	memcpy(fecbuffer, input, 4);
+#endif
+
+	memcpy(cost, decoder->cost, sizeof(cost));
+	memcpy(path, decoder->path, sizeof(path));
+	for (i = 0; i < 4; i++)
 	{
-		//printf("FEC encoding i = %d\n", i);
+		// 4 symbols per byte, the first symbol in the MSBs
+		for (j = 3; j >= 0; j--)
+			decode_symbol(cost, path, hard_metric_lut[(fecbuffer[i] >> (2 * j)) & 0x03]);
 
-		bool err = fec_decode(&data[i]);
-		decoded_length+=2;
-		if (!err) 
-		{
-			DPRINT("FEC encoding error\n");
-		}
+		if (i & 0x01)
+			decoded += decode_byte_done(cost, path, &path_size, &output[decoded]);
 	}
 
-	memcpy(data, data_buffer, decoded_length);
-
-	return decoded_length;
+	memcpy(decoder->cost, cost, sizeof(cost));
+	memcpy(decoder->path, path, sizeof(path));
+	decoder->path_size = path_size;
+	return decoded;
 }
 
-static bool fec_decode(uint8_t* input)
+uint8_t fec_decode_block_soft(fec_decoder_t *decoder, const uint8_t *soft_input, uint8_t *output)
 {
-	uint8_t i, k;
-	int8_t j;
-	uint8_t min_state;
-	uint8_t symbol;
-	uint16_t tmppn9;
-	uint8_t fecbuffer[4];
-	VITERBIPATH* vstate_tmp;
-
-	if(fecprocessedbytes >= packetlength)
-		return false;
-
-	//Deinterleaving (symbols are stored in reverse as this is easier for Viterbi decoding)
-
+	uint16_t cost[FEC_DECODER_STATES];
+	uint16_t path[FEC_DECODER_STATES];
+	uint8_t path_size = decoder->path_size;
+	uint8_t decoded = 0;
+	uint8_t n, p;
+
+	memcpy(cost, decoder->cost, sizeof(cost));
+	memcpy(path, decoder->path, sizeof(path));
+	for (n = 0; n < 4; n++)
+	{
+		for (p = 4; p-- > 0; )
+		{
+			// the soft values of symbol p of the n-th de-interleaved byte, see fec_interleave_lut
 #ifdef INTERLEAVING
-	//printf("Int: "); print_array(input, 4); printf("\n");
-	fecbuffer[0] = ((input[0] & 0x03)) |\
-					((input[1] & 0x03) << 2) |\
-					((input[2] & 0x03) << 4) |\
-					((input[3] & 0x03) << 6);
-	fecbuffer[1] = (((input[0] >> 2) & 0x03)) |\
-					(((input[1] >> 2) & 0x03) << 2) |\
-					(((input[2] >> 2) & 0x03) << 4) |\
-					(((input[3] >> 2) & 0x03) << 6);
-	fecbuffer[2] = (((input[0] >> 4) & 0x03)) |\
-					(((input[1] >> 4) & 0x03) << 2) |\
-					(((input[2] >> 4) & 0x03) << 4) |\
-					(((input[3] >> 4) & 0x03) << 6);
-	fecbuffer[3] = (((input[0] >> 6) & 0x03)) |\
-					(((input[1] >> 6) & 0x03) << 2) |\
-					(((input[2] >> 6) & 0x03) << 4) |\
-					(((input[3] >> 6) & 0x03) << 6);
-	//printf("DeI: "); print_array(fecbuffer, 4); printf("\n");
+			const uint8_t *bits = &soft_input[8 * p + 6 - 2 * n];
 #else
-	fecbuffer[0] = input[0];
-	fecbuffer[1] = input[1];
-	fecbuffer[2] = input[2];
-	fecbuffer[3] = input[3];
+			const uint8_t *bits = &soft_input[8 * n + 6 - 2 * p];
 #endif
-	//printf(" input = %04X%04X\n", fecbuffer[0],fecbuffer[1]);
-	fecprocessedbytes +=4;
-
-	for (i = 0; i < 3; i=i+2) {
-		//Viterbi decoding
-		//printf(" Encode i  %d -> %04X %s\n", i, fecbuffer[i], int_to_binary(fecbuffer[i]));
-
-		// todo: fix for loop
-		for (j = 7; j >= 0; j--) {
-			if (j>3)
-				symbol = (fecbuffer[i] >> (j-4)*2) & 0x03;
-			else
-				symbol = (fecbuffer[i+1] >> j*2) & 0x03;
-			//printf(" Symbol %d %x - %s\n", j, symbol, int_to_binary(symbol));
-			//fecbuffer[i] >>= 2;
-
-			for(k = 0; k < 8; k++) {
-				uint8_t cost0, cost1;
-				uint8_t state0, state1;
-				uint8_t hamming0, hamming1;
-
-				state0 = k >> 1;
-				state1 = state0 + 4;
-
-				cost0  = vstate.old[state0].cost;
-				cost1  = vstate.old[state1].cost;
-
-				//butterfly operation for 0
-				hamming0 = cost0 + (((trellis0_lut[state0] ^ symbol) + 1) >> 1);
-				hamming1 = cost1 + (((trellis0_lut[state1] ^ symbol) + 1) >> 1);
-
-				if(hamming0 <= hamming1) {
-					vstate.new[k].cost = hamming0;
-					vstate.new[k].path = vstate.old[state0].path << 1;
-				} else {
-					vstate.new[k].cost = hamming1;
-					vstate.new[k].path = vstate.old[state1].path << 1;
-				}
-
-				//printf("k %d part 1\n");
-				//print_vstate();
-
-				k++;
-
-				//butterfly operation for 1
-				hamming0 = cost0 + (((trellis1_lut[state0] ^ symbol) + 1) >> 1);
-				hamming1 = cost1 + (((trellis1_lut[state1] ^ symbol) + 1) >> 1);
-
-				if(hamming0 <= hamming1) {
-					vstate.new[k].cost = hamming0;
-					vstate.new[k].path = vstate.old[state0].path << 1 | 0x01;
-				} else {
-					vstate.new[k].cost = hamming1;
-					vstate.new[k].path = vstate.old[state1].path << 1 | 0x01;
-				}
-
-				//printf("k %d part 2\n");
-				//print_vstate();
-			}
-
-			//Swap Viterbi paths
-			vstate_tmp = vstate.new;
-			vstate.new = vstate.old;
-			vstate.old = vstate_tmp;
-
-			//print_vstate();
+			uint16_t metric[4];
+			metric[0] = bits[0] + bits[1];
+			metric[1] = bits[0] + (FEC_SOFT_ONE - bits[1]);
+			metric[2] = (FEC_SOFT_ONE - bits[0]) + bits[1];
+			metric[3] = (FEC_SOFT_ONE - bits[0]) + (FEC_SOFT_ONE - bits[1]);
+			decode_symbol(cost, path, metric);
 		}
 
-		vstate.path_size++;
+		if (n & 0x01)
+			decoded += decode_byte_done(cost, path, &path_size, &output[decoded]);
+	}
 
-		//Flush out byte if path is full
-		if ((vstate.path_size == 2) && (processedbytes < packetlength)) {
-			//Calculate path with lowest cost
-			min_state = 0;
-			for (j = 7; j != 0; j--) {
-				if(vstate.old[j].cost < vstate.old[min_state].cost)
-					min_state = j;
-			}
+	memcpy(decoder->cost, cost, sizeof(cost));
+	memcpy(decoder->path, path, sizeof(path));
+	decoder->path_size = path_size;
+	return decoded;
+}
 
-	        //Normalize costs
-			if (vstate.old[min_state].cost > 0)
-				for (j = 0; j < 8; j++) vstate.old[j].cost -= vstate.old[min_state].cost;
+uint8_t fec_decoder_flush(fec_decoder_t *decoder, uint8_t *output)
+{
+	if (decoder->path_size == 0)
+		return 0;
 
-			*output_buffer++ = vstate.old[min_state].path >> 8;
-			vstate.path_size--;
+	*output = decoder->path[lowest_cost_state(decoder->cost)];
+	decoder->path_size = 0;
+	return 1;
+}
 
-			processedbytes++;
+uint16_t fec_decode_packet(uint8_t* data, uint16_t packet_length, uint16_t output_length)
+{
+	fec_decoder_t decoder;
+	uint16_t decoded_length = 0;
+	uint16_t i;
 
-			if (processedbytes+ 2 == packetlength)
-				*output_buffer = (uint8_t) (vstate.old[min_state].path);
-		}
+	if(output_length < packet_length)
+	{
+		DPRINT("FEC decoding error: buffer to small\n");
+		return 0;
 	}
 
-	//print_vstate();
-
+	if(packet_length % 4 != 0)
+	{
+		DPRINT("FEC decoding error: data 32 bit aligned\n");
+		return 0;
+	}
 
+	// decoding happens in place, the output always trails the block being decoded
+	fec_decoder_init(&decoder);
+	for(i = 0; i < packet_length; i += 4)
+		decoded_length += fec_decode_block(&decoder, &data[i], &data[decoded_length]);
 
-	return true;
+	decoded_length += fec_decoder_flush(&decoder, &data[decoded_length]);
+	return decoded_length;
 }
 
-//#endif /* D7_PHY_USE_FEC */
+uint16_t fec_decode_packet_soft(const uint8_t* soft_input, uint16_t packet_length, uint8_t* output, uint16_t output_length)
+{
+	fec_decoder_t decoder;
+	uint16_t decoded_length = 0;
+	uint16_t i;
+
+	if(output_length < packet_length / 2)
+	{
+		DPRINT("FEC decoding error: buffer to small\n");
+		return 0;
+	}
+
+	if(packet_length % 4 != 0)
+	{
+		DPRINT("FEC decoding error: data 32 bit aligned\n");
+		return 0;
+	}
+
+	fec_decoder_init(&decoder);
+	for(i = 0; i < packet_length; i += 4)
+		decoded_length += fec_decode_block_soft(&decoder, &soft_input[8 * i], &output[decoded_length]);
+
+	decoded_length += fec_decoder_flush(&decoder, &output[decoded_length]);
+	return decoded_length;
+}
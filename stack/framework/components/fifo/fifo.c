@@ -26,6 +26,31 @@
 #include "errors.h"
 #include "debug.h"
 
+// a power of two max_size is masked, other sizes are wrapped with a compare instead of a division
+static inline uint16_t get_mask(uint16_t max_size)
+{
+    return (max_size & (max_size - 1)) == 0 ? max_size - 1 : 0;
+}
+
+// returns idx modulo max_size, idx has to be smaller than 2 * max_size
+static inline uint16_t wrap(fifo_t* fifo, uint32_t idx)
+{
+    if(fifo->mask)
+        return idx & fifo->mask;
+
+    return idx >= fifo->max_size ? idx - fifo->max_size : idx;
+}
+
+static inline uint16_t get_size(fifo_t* fifo)
+{
+    if(fifo->head_idx == fifo->tail_idx)
+        return fifo->is_full ? fifo->max_size : 0;
+    else if(fifo->head_idx < fifo->tail_idx)
+        return fifo->tail_idx - fifo->head_idx;
+    else
+        return fifo->tail_idx + (fifo->max_size - fifo->head_idx);
+}
+
 void fifo_init(fifo_t *fifo, uint8_t *buffer, uint16_t max_size)
 {
     fifo_init_filled(fifo, buffer, 0, max_size);
@@ -36,7 +61,7 @@ void fifo_init_filled(fifo_t *fifo, uint8_t *buffer, uint16_t filled_size, uint1
     fifo->buffer = buffer;
     fifo->head_idx = 0;
     fifo->max_size = max_size;
-    fifo->tail_idx = filled_size == 0 ? 0 : filled_size;
+    fifo->mask = get_mask(max_size);
     fifo->tail_idx = filled_size == max_size ? 0 : filled_size;
     fifo->is_full = (filled_size == max_size);
     fifo->is_subview = false;    
@@ -47,9 +72,10 @@ error_t fifo_init_subview(fifo_t *subset_fifo, fifo_t* original_fifo, uint16_t o
         return ESIZE;
 
     subset_fifo->buffer = original_fifo->buffer;
-    subset_fifo->head_idx = (original_fifo->head_idx + offset) % original_fifo->max_size;
-    subset_fifo->tail_idx = (original_fifo->head_idx + offset + subset_size) % original_fifo->max_size;
     subset_fifo->max_size = original_fifo->max_size;
+    subset_fifo->mask = original_fifo->mask;
+    subset_fifo->head_idx = wrap(original_fifo, (uint32_t)original_fifo->head_idx + offset);
+    subset_fifo->tail_idx = wrap(original_fifo, (uint32_t)subset_fifo->head_idx + subset_size);
     subset_fifo->is_full = (subset_size == subset_fifo->max_size);
     subset_fifo->is_subview = true;
     return SUCCESS;
@@ -63,41 +89,22 @@ error_t fifo_put(fifo_t *fifo, uint8_t *data, uint16_t len)
     if(fifo->is_full)
         return ESIZE;
 
-    if(fifo->tail_idx < fifo->head_idx)
-    {
-        if(fifo->tail_idx + len > fifo->head_idx)
-            return ESIZE;
-        memcpy(fifo->buffer + fifo->tail_idx, data, len);
-        fifo->tail_idx += len;
-        fifo->is_full = (fifo->tail_idx == fifo->head_idx);
-        return SUCCESS;
-    }
+    if(len > fifo->max_size - get_size(fifo))
+        return ESIZE;
 
-    if(fifo->tail_idx + len < fifo->max_size)
-    {
+    // the data is copied up to the end of the buffer, and the remainder (if any) to the start of the buffer
+    uint16_t part1 = fifo->max_size - fifo->tail_idx;
+    if(part1 >= len)
         memcpy(fifo->buffer + fifo->tail_idx, data, len);
-        fifo->tail_idx += len;
-        return SUCCESS;
-    }
-
-    uint16_t space_left_before_max_size = fifo->max_size - fifo->tail_idx;
-    uint16_t space_needed_after_wrap = len - space_left_before_max_size;
-    if(fifo->head_idx >= space_needed_after_wrap)
+    else
     {
-        // wrap
-        memcpy(fifo->buffer + fifo->tail_idx, data, space_left_before_max_size);
-        memcpy(fifo->buffer, data + space_left_before_max_size, space_needed_after_wrap);
-        fifo->tail_idx = space_needed_after_wrap;
-        fifo->is_full = (fifo->tail_idx == fifo->head_idx);
-        return SUCCESS;
+        memcpy(fifo->buffer + fifo->tail_idx, data, part1);
+        memcpy(fifo->buffer, data + part1, len - part1);
     }
-    else
-        return ESIZE;
-}
 
-error_t fifo_put_byte(fifo_t* fifo, uint8_t byte)
-{
-    return fifo_put(fifo, &byte, 1);
+    fifo->tail_idx = wrap(fifo, (uint32_t)fifo->tail_idx + len);
+    fifo->is_full = (len > 0 && fifo->tail_idx == fifo->head_idx);
+    return SUCCESS;
 }
 
 static error_t check_len(fifo_t* fifo, uint16_t len) {
@@ -105,18 +112,14 @@ static error_t check_len(fifo_t* fifo, uint16_t len) {
   if(len == 0) { return SUCCESS; }
 
   // quick check if requested len doesn't exceed available data
-  if(len > fifo_get_size(fifo)) { return ESIZE; }
+  if(len > get_size(fifo)) { return ESIZE; }
 
   return SUCCESS;
 }
 
 static void skip(fifo_t* fifo, uint16_t len) {
   // progress head to implement popping behaviour
-  fifo->head_idx = (fifo->head_idx + len);
-  if(fifo->head_idx >= fifo->max_size)
-  {
-    fifo->head_idx = fifo->head_idx % fifo->max_size;
-  }
+  fifo->head_idx = wrap(fifo, (uint32_t)fifo->head_idx + len);
 
   if(len > 0)
     fifo->is_full = 0;
@@ -170,21 +173,14 @@ error_t fifo_remove_last_byte(fifo_t* fifo) {
     return fifo_remove(fifo, 1);
 }
 
-error_t fifo_peek(fifo_t* fifo, uint8_t* buffer, uint16_t offset, uint16_t len) {
-  error_t err = check_len(fifo, offset + len);
-  if(err != SUCCESS)
-    return err;
-
-  // determine start/end index (in circular buffer)
-  uint16_t start_idx = (fifo->head_idx + offset) % fifo->max_size;
-  uint16_t end_idx   = (start_idx      + len   ) % fifo->max_size;
-
+// copies len bytes starting from start_idx, which can wrap around the end of the buffer
+static inline void copy_out(fifo_t* fifo, uint8_t* buffer, uint16_t start_idx, uint16_t len) {
   // simple case: the end doesn't wrap...
   // .............
   //     S-len->E
-  if(end_idx >= start_idx) {
+  if(start_idx + len <= fifo->max_size) {
     memcpy(buffer, fifo->buffer + start_idx, len);
-    return SUCCESS;
+    return;
   }
 
   // the end does wrap...
@@ -196,28 +192,82 @@ error_t fifo_peek(fifo_t* fifo, uint8_t* buffer, uint16_t offset, uint16_t len)
   memcpy(buffer,         fifo->buffer + start_idx, part1);
   // copy remaining (wrapped) bytes from start
   memcpy(buffer + part1, fifo->buffer,             len - part1);
+}
+
+error_t fifo_peek(fifo_t* fifo, uint8_t* buffer, uint16_t offset, uint16_t len) {
+  error_t err = check_len(fifo, offset + len);
+  if(err != SUCCESS)
+    return err;
 
+  // determine start index (in circular buffer)
+  copy_out(fifo, buffer, wrap(fifo, (uint32_t)fifo->head_idx + offset), len);
   return SUCCESS;
 }
 
 error_t fifo_pop(fifo_t* fifo, uint8_t* buffer, uint16_t len) {
-  // use peek logic to retrieve data
-  error_t err = fifo_peek(fifo, buffer, 0, len);
-  if( err != SUCCESS ) { return err; }
+  if(len > get_size(fifo))
+    return ESIZE;
 
+  copy_out(fifo, buffer, fifo->head_idx, len);
   skip(fifo, len);
 
   return SUCCESS;
 }
 
+// fills in the spans of len bytes starting from start_idx, which can wrap around the end of the buffer
+static void get_segments(fifo_t* fifo, uint16_t start_idx, uint16_t len, fifo_segment_t segments[2])
+{
+    uint16_t part1 = fifo->max_size - start_idx;
+    if(part1 > len)
+        part1 = len;
+
+    segments[0].data = fifo->buffer + start_idx;
+    segments[0].len = part1;
+    segments[1].data = fifo->buffer;
+    segments[1].len = len - part1;
+}
+
+error_t fifo_peek_segments(fifo_t* fifo, uint16_t offset, uint16_t len, fifo_segment_t segments[2])
+{
+    error_t err = check_len(fifo, offset + len);
+    if(err != SUCCESS)
+        return err;
+
+    get_segments(fifo, wrap(fifo, (uint32_t)fifo->head_idx + offset), len, segments);
+    return SUCCESS;
+}
+
+error_t fifo_reserve(fifo_t* fifo, uint16_t len, fifo_segment_t segments[2])
+{
+    if(fifo->is_subview)
+        return EINVAL;
+
+    if(len > fifo->max_size - get_size(fifo))
+        return ESIZE;
+
+    get_segments(fifo, fifo->tail_idx, len, segments);
+    return SUCCESS;
+}
+
+error_t fifo_commit(fifo_t* fifo, uint16_t len)
+{
+    if(fifo->is_subview)
+        return EINVAL;
+
+    if(len > fifo->max_size - get_size(fifo))
+        return ESIZE;
+
+    if(len == 0)
+        return SUCCESS;
+
+    fifo->tail_idx = wrap(fifo, (uint32_t)fifo->tail_idx + len);
+    fifo->is_full = (fifo->tail_idx == fifo->head_idx);
+    return SUCCESS;
+}
+
 uint16_t fifo_get_size(fifo_t* fifo)
 {
-    if(fifo->head_idx == fifo->tail_idx)
-        return fifo->is_full ? fifo->max_size : 0;
-    else if(fifo->head_idx < fifo->tail_idx)
-        return fifo->tail_idx - fifo->head_idx;
-    else
-        return fifo->tail_idx + (fifo->max_size - fifo->head_idx);
+    return get_size(fifo);
 }
 
 void fifo_get_continuos_raw_data(fifo_t* fifo, uint8_t** pdata, uint16_t* plen)
@@ -243,3 +293,91 @@ void fifo_clear(fifo_t* fifo)
 bool fifo_is_full(fifo_t* fifo) {
     return fifo->is_full;
 }
+
+// the indices of the spsc fifo are only written by one side, the acquire and release semantics make sure the data in the
+// buffer is accessed before (release) or after (acquire) the index which is shared with the other side
+#define load_acquire(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define store_release(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+
+error_t fifo_spsc_init(fifo_spsc_t* fifo, uint8_t* buffer, uint16_t max_size)
+{
+    return fifo_spsc_init_filled(fifo, buffer, 0, max_size);
+}
+
+error_t fifo_spsc_init_filled(fifo_spsc_t* fifo, uint8_t* buffer, uint16_t filled_size, uint16_t max_size)
+{
+    if(max_size == 0 || (max_size & (max_size - 1)) != 0 || filled_size > max_size)
+        return EINVAL;
+
+    fifo->buffer = buffer;
+    fifo->mask = max_size - 1;
+    fifo->head = 0;
+    fifo->tail = filled_size;
+    return SUCCESS;
+}
+
+error_t fifo_put_from_isr(fifo_spsc_t* fifo, const uint8_t* data, uint16_t len)
+{
+    uint16_t tail = fifo->tail;
+    uint16_t size = (uint16_t)(tail - load_acquire(&fifo->head));
+    if(len > fifo->mask + 1 - size)
+        return ESIZE;
+
+    uint16_t tail_idx = tail & fifo->mask;
+    uint16_t part1 = fifo->mask + 1 - tail_idx;
+    if(part1 >= len)
+        memcpy(fifo->buffer + tail_idx, data, len);
+    else
+    {
+        memcpy(fifo->buffer + tail_idx, data, part1);
+        memcpy(fifo->buffer, data + part1, len - part1);
+    }
+
+    store_release(&fifo->tail, (uint16_t)(tail + len));
+    return SUCCESS;
+}
+
+uint16_t fifo_spsc_get_size(fifo_spsc_t* fifo)
+{
+    return (uint16_t)(load_acquire(&fifo->tail) - fifo->head);
+}
+
+error_t fifo_spsc_peek(fifo_spsc_t* fifo, uint8_t* buffer, uint16_t offset, uint16_t len)
+{
+    fifo_t subview;
+    error_t err = fifo_spsc_init_subview(&subview, fifo, offset, len);
+    if(err != SUCCESS)
+        return err;
+
+    return fifo_peek(&subview, buffer, 0, len);
+}
+
+error_t fifo_spsc_skip(fifo_spsc_t* fifo, uint16_t len)
+{
+    if(len > fifo_spsc_get_size(fifo))
+        return ESIZE;
+
+    store_release(&fifo->head, (uint16_t)(fifo->head + len));
+    return SUCCESS;
+}
+
+void fifo_spsc_clear(fifo_spsc_t* fifo)
+{
+    store_release(&fifo->head, load_acquire(&fifo->tail));
+}
+
+error_t fifo_spsc_init_subview(fifo_t* subset_fifo, fifo_spsc_t* original_fifo, uint16_t offset, uint16_t subset_size)
+{
+    if((uint32_t)offset + subset_size > fifo_spsc_get_size(original_fifo))
+        return ESIZE;
+
+    uint16_t head = original_fifo->head + offset;
+    subset_fifo->buffer = original_fifo->buffer;
+    subset_fifo->head_idx = head & original_fifo->mask;
+    subset_fifo->tail_idx = (uint16_t)(head + subset_size) & original_fifo->mask;
+    subset_fifo->max_size = original_fifo->mask + 1;
+    subset_fifo->mask = original_fifo->mask;
+    subset_fifo->is_full = (subset_size == subset_fifo->max_size);
+    subset_fifo->is_subview = true;
+    return SUCCESS;
+}
@@ -29,11 +29,18 @@
 
 #include "framework_defs.h"
 #include "debug.h"
+#include "ng.h"
 #include "log.h"
 #include "fs.h"
 #include "errors.h"
 #include "platform.h"
 #include "hwblockdevice.h"
+#ifdef FRAMEWORK_FS_WRITE_BACK_CACHE
+#include "blockdevice_cache.h"
+#include "hwsystem.h"
+#include "scheduler.h"
+#include "timer.h"
+#endif
 
 #if defined(FRAMEWORK_LOG_ENABLED) && defined(FRAMEWORK_FS_LOG_ENABLED)
   #define DPRINT(...) log_print_string( __VA_ARGS__)
@@ -41,17 +48,45 @@
   #define DPRINT(...)
 #endif
 
-static fs_file_t files[FRAMEWORK_FS_FILE_COUNT] = { 0 }; // TODO do not keep all file metadata in RAM but use smaller MRU cache to save RAM
+static fs_file_t NGDEF(_files)[FRAMEWORK_FS_FILE_COUNT]; // TODO do not keep all file metadata in RAM but use smaller MRU cache to save RAM
+#define files NG(_files)
 
-static bool is_fs_init_completed = false;  //set in _d7a_verify_magic()
+static bool NGDEF(_is_fs_init_completed);  //set in _d7a_verify_magic()
+#define is_fs_init_completed NG(_is_fs_init_completed)
 
 #define IS_SYSTEM_FILE(file_id)         (file_id <= 0x3F)
 
-static uint32_t volatile_data_offset = 0;
-static uint32_t permanent_data_offset = 0;
+static uint32_t NGDEF(_volatile_data_offset);
+#define volatile_data_offset NG(_volatile_data_offset)
+
+static uint32_t NGDEF(_permanent_data_offset);
+#define permanent_data_offset NG(_permanent_data_offset)
+
+static uint32_t NGDEF(_bd_data_offset)[FRAMEWORK_FS_BLOCKDEVICES_COUNT];
+#define bd_data_offset NG(_bd_data_offset)
+
+static blockdevice_t* NGDEF(_bd)[FRAMEWORK_FS_BLOCKDEVICES_COUNT];
+#define bd NG(_bd)
+
+#ifdef FRAMEWORK_FS_WRITE_BACK_CACHE
+// the permanent storage is accessed through a write-back cache, which is flushed a while after the first write
+static uint8_t NGDEF(_permanent_cache_buffer)[FRAMEWORK_FS_WRITE_BACK_CACHE_PAGES * FRAMEWORK_FS_WRITE_BACK_CACHE_PAGE_SIZE];
+#define permanent_cache_buffer NG(_permanent_cache_buffer)
+
+static blockdevice_cache_page_t NGDEF(_permanent_cache_pages)[FRAMEWORK_FS_WRITE_BACK_CACHE_PAGES];
+#define permanent_cache_pages NG(_permanent_cache_pages)
+
+static blockdevice_cache_t NGDEF(_permanent_cache); // set up in fs_init()
+#define permanent_cache NG(_permanent_cache)
+
+static bool NGDEF(_is_flush_scheduled);
+#define is_flush_scheduled NG(_is_flush_scheduled)
 
-static uint32_t bd_data_offset[FRAMEWORK_FS_BLOCKDEVICES_COUNT] = { 0 };
-static blockdevice_t* bd[FRAMEWORK_FS_BLOCKDEVICES_COUNT] = { 0 };
+static void flush_task(void* arg)
+{
+    fs_flush();
+}
+#endif
 
 /* forward internal declarations */
 static int _fs_init(void);
@@ -100,6 +135,20 @@ void fs_init()
     bd[FS_BLOCKDEVICE_TYPE_PERMANENT] = PLATFORM_PERMANENT_BLOCKDEVICE;
     bd[FS_BLOCKDEVICE_TYPE_VOLATILE] = PLATFORM_VOLATILE_BLOCKDEVICE;
 
+#ifdef FRAMEWORK_FS_WRITE_BACK_CACHE
+    permanent_cache = (blockdevice_cache_t) {
+        .base.driver = &blockdevice_driver_cache,
+        .backing = PLATFORM_PERMANENT_BLOCKDEVICE,
+        .buffer = permanent_cache_buffer,
+        .pages = permanent_cache_pages,
+        .page_size = FRAMEWORK_FS_WRITE_BACK_CACHE_PAGE_SIZE,
+        .page_count = FRAMEWORK_FS_WRITE_BACK_CACHE_PAGES
+    };
+    blockdevice_init(&permanent_cache.base);
+    bd[FS_BLOCKDEVICE_TYPE_PERMANENT] = &permanent_cache.base;
+    sched_register_task(&flush_task);
+#endif
+
     _fs_init();
 
     is_fs_init_completed = true;
@@ -308,12 +357,54 @@ int fs_write_file(uint8_t file_id, uint32_t offset, const uint8_t* buffer, uint3
 
     } while (remaining_length > 0);
 
+#ifdef FRAMEWORK_FS_WRITE_BACK_CACHE
+    // the flush is not postponed by later writes, the slack allows it to share a wakeup with other events
+    if(bd[bd_type] == &permanent_cache.base && !is_flush_scheduled)
+    {
+        timer_tick_t delay = FRAMEWORK_FS_WRITE_BACK_CACHE_FLUSH_DELAY * TIMER_TICKS_PER_SEC;
+        is_flush_scheduled = timer_post_task_prio(&flush_task, timer_get_counter_value() + delay - delay / 4,
+                                                  MIN_PRIORITY, 0, delay / 4, NULL) == SUCCESS;
+    }
+#endif
+
     DPRINT("fs write_file (file_id %d, offset %d, addr %lu, length %d)\n",
            file_id, offset, files[file_id].addr, length);
 
     return 0;
 }
 
+error_t fs_flush()
+{
+    error_t rc = SUCCESS;
+#ifdef FRAMEWORK_FS_WRITE_BACK_CACHE
+    if(is_flush_scheduled)
+    {
+        timer_cancel_task(&flush_task);
+        is_flush_scheduled = false;
+    }
+#endif
+
+    for(uint8_t bd_index = 0; bd_index < FRAMEWORK_FS_BLOCKDEVICES_COUNT; bd_index++)
+    {
+        if(bd[bd_index] == NULL)
+            continue;
+
+        error_t err = blockdevice_flush(bd[bd_index]);
+        if(err != SUCCESS && rc == SUCCESS)
+            rc = err;
+    }
+
+    return rc;
+}
+
+#ifdef FRAMEWORK_FS_WRITE_BACK_CACHE
+void hw_brownout_detected()
+{
+    // called from the interrupt of the supply voltage monitor, which could have interrupted an access to the cache
+    sched_post_task_prio(&flush_task, MAX_PRIORITY, NULL);
+}
+#endif
+
 fs_file_stat_t *fs_file_stat(uint8_t file_id)
 {
     assert(is_fs_init_completed);
@@ -44,6 +44,7 @@
 
 
 #define RX_BUFFER_SIZE 256
+_Static_assert((RX_BUFFER_SIZE & (RX_BUFFER_SIZE - 1)) == 0, "RX_BUFFER_SIZE should be a power of two, for the rx_fifo");
 
 #define TX_FIFO_FLUSH_CHUNK_SIZE 10 // at a baudrate of 115200 this ensures completion within 1 ms
                                     // TODO baudrate dependent
@@ -67,7 +68,9 @@ static timer_tick_t modem_interface_timeout_start_time;
 #endif
 
 static uint8_t rx_buffer[RX_BUFFER_SIZE];
-static fifo_t rx_fifo;
+// filled from the UART interrupt and processed by process_rx_fifo()
+static fifo_spsc_t rx_fifo;
+static volatile bool rx_overrun = false;
 
 #if defined(FRAMEWORK_LOG_ENABLED) && defined(FRAMEWORK_MODEM_INTERFACE_LOG_ENABLED)
   #define DPRINT(...) log_print_string(__VA_ARGS__)
@@ -91,6 +94,11 @@ static fifo_t rx_fifo;
 static uint8_t modem_interface_tx_buffer[MODEM_INTERFACE_TX_FIFO_SIZE];
 static fifo_t modem_interface_tx_fifo;
 static bool request_pending = false;
+#ifdef HAL_UART_USE_DMA_TX
+// the DMA transfer keeps reading from this buffer after uart_send_bytes() returns, so it can not live on the stack
+// or be the FIFO storage, which is freed for new data as soon as it is popped
+static uint8_t modem_interface_tx_dma_buffer[MODEM_INTERFACE_TX_FIFO_SIZE];
+#endif
 
 uint8_t header[SERIAL_FRAME_HEADER_SIZE];
 static uint8_t payload_len = 0;
@@ -102,6 +110,9 @@ static volatile uint8_t target_uart_state_isr_count;
 
 static bool modem_listen_uart_inited = false;
 static bool parsed_header = false;
+// handles of the tasks which are posted from the UART interrupts
+static sched_task_id_t process_rx_fifo_id;
+static sched_task_id_t execute_state_machine_id;
 
 static cmd_handler_t alp_handler;
 static cmd_handler_t ping_response_handler;
@@ -185,10 +196,9 @@ static void flush_modem_interface_tx_fifo(void *arg)
   uint8_t len = fifo_get_size(&modem_interface_tx_fifo);
 
 #ifdef HAL_UART_USE_DMA_TX
-  // when using DMA we transmit the whole FIFO at once
-  uint8_t buffer[MODEM_INTERFACE_TX_FIFO_SIZE];
-  fifo_pop(&modem_interface_tx_fifo, buffer, len);
-  uart_send_bytes(uart, buffer, len);
+  // when using DMA we transmit the whole FIFO at once, as a single contiguous transfer
+  fifo_pop(&modem_interface_tx_fifo, modem_interface_tx_dma_buffer, len);
+  uart_send_bytes(uart, modem_interface_tx_dma_buffer, len);
 #elif defined(FRAMEWORK_MODEM_INTERFACE_USE_DMA)
   //Execute atomic, otherwise there is a chance that the DMA complete callback is called during execution of this code.
   // If that would happen a DMA transfer with length 0 is started which will not trigger a complete callback
@@ -223,11 +233,15 @@ static void flush_modem_interface_tx_fifo(void *arg)
   // we don't interfer with critical stack timings.
   // When there is still data left in the fifo this will be rescheduled
   // with lowest prio
-  uint8_t chunk[TX_FIFO_FLUSH_CHUNK_SIZE];
+  fifo_segment_t segments[2];
+  fifo_peek_segments(&modem_interface_tx_fifo, 0, len <= TX_FIFO_FLUSH_CHUNK_SIZE ? len : TX_FIFO_FLUSH_CHUNK_SIZE, segments);
+  uart_send_bytes(uart, segments[0].data, segments[0].len);
+  if(segments[1].len)
+    uart_send_bytes(uart, segments[1].data, segments[1].len);
+  fifo_skip(&modem_interface_tx_fifo, segments[0].len + segments[1].len);
+
   if(len <= TX_FIFO_FLUSH_CHUNK_SIZE)
   {
-    fifo_pop(&modem_interface_tx_fifo, chunk, len);
-    uart_send_bytes(uart, chunk, len);
     request_pending = false;
     release_receiver();
 #ifdef FRAMEWORK_MODEM_INTERFACE_USE_INTERRUPT_LINES
@@ -236,8 +250,6 @@ static void flush_modem_interface_tx_fifo(void *arg)
   } 
   else 
   {
-    fifo_pop(&modem_interface_tx_fifo, chunk, TX_FIFO_FLUSH_CHUNK_SIZE);
-    uart_send_bytes(uart, chunk, TX_FIFO_FLUSH_CHUNK_SIZE);
     sched_post_task_prio(&flush_modem_interface_tx_fifo, MIN_PRIORITY, NULL);
   }
 #endif
@@ -325,7 +337,7 @@ static void execute_state_machine()
       // response period completed, process the request
 #ifdef FRAMEWORK_MODEM_INTERFACE_USE_DMA
       size_t received_bytes = uart_stop_read_bytes_via_DMA(uart);
-      fifo_init_filled(&rx_fifo, rx_buffer, received_bytes, RX_BUFFER_SIZE);
+      assert(fifo_spsc_init_filled(&rx_fifo, rx_buffer, received_bytes, RX_BUFFER_SIZE) == SUCCESS);
 #endif
       sched_post_task(&process_rx_fifo);
       if(request_pending) {
@@ -344,7 +356,7 @@ static void execute_state_machine()
         // wake-up requested
         target_uart_state_isr_count = 0;
 #ifdef FRAMEWORK_MODEM_INTERFACE_USE_DMA
-        if(fifo_get_size(&rx_fifo) == 0)
+        if(fifo_spsc_get_size(&rx_fifo) == 0)
         {
           clear_modem_interface_timeout();
 #endif
@@ -442,8 +454,9 @@ static void execute_state_machine()
  */
 static bool verify_payload(fifo_t* bytes, uint8_t* frame_header)
 {
-  static uint8_t payload[RX_BUFFER_SIZE - SERIAL_FRAME_HEADER_SIZE]; // statically allocated so this does not end up on stack
-  fifo_peek(bytes, payload, 0, frame_header[SERIAL_FRAME_SIZE]);
+  // the CRC is calculated over the payload in the fifo, without copying it out first
+  fifo_segment_t payload[2];
+  fifo_peek_segments(bytes, 0, frame_header[SERIAL_FRAME_SIZE], payload);
 
   //check for missing packages
   packet_down_counter++;
@@ -457,9 +470,11 @@ static bool verify_payload(fifo_t* bytes, uint8_t* frame_header)
   DPRINT("RX HEADER: ");
   DPRINT_DATA(frame_header, SERIAL_FRAME_HEADER_SIZE);
   DPRINT("RX PAYLOAD: ");
-  DPRINT_DATA(payload, frame_header[SERIAL_FRAME_SIZE]);
+  DPRINT_DATA(payload[0].data, payload[0].len);
+  DPRINT_DATA(payload[1].data, payload[1].len);
 
-  uint16_t calculated_crc = crc_calculate(payload, frame_header[SERIAL_FRAME_SIZE]);
+  uint16_t calculated_crc = crc_update(crc_init(), payload[0].data, payload[0].len);
+  calculated_crc = crc_final(crc_update(calculated_crc, payload[1].data, payload[1].len));
  
   if(frame_header[SERIAL_FRAME_CRC1]!=((calculated_crc >> 8) & 0x00FF) || frame_header[SERIAL_FRAME_CRC2]!=(calculated_crc & 0x00FF))
   {
@@ -481,7 +496,7 @@ void modem_interface_clear_handler() {
     //clear RX
     parsed_header = false;
     payload_len = 0;
-    fifo_clear(&rx_fifo);
+    fifo_spsc_clear(&rx_fifo);
 
     //clear TX
 #ifdef FRAMEWORK_MODEM_INTERFACE_USE_DMA
@@ -503,9 +518,9 @@ void modem_interface_clear_handler() {
 static void uart_error_callback(uart_error_t error) {
     log_print_string("UART ERROR %i", error);
     if(error == UART_OVERRUN_ERROR) {
-      parsed_header = false;
-      payload_len = 0;
-      fifo_clear(&rx_fifo);
+      // only the consumer can drop the received bytes, process_rx_fifo() does this
+      rx_overrun = true;
+      sched_post_task_id_from_isr(process_rx_fifo_id, DEFAULT_PRIORITY, NULL);
     }
 }
 
@@ -519,24 +534,33 @@ static void uart_error_callback(uart_error_t error) {
  */
 static void process_rx_fifo(void *arg) 
 {
+  if(rx_overrun)
+  {
+    rx_overrun = false;
+    parsed_header = false;
+    payload_len = 0;
+    fifo_spsc_clear(&rx_fifo);
+    return;
+  }
+
   if(!parsed_header) 
   {
-    if(fifo_get_size(&rx_fifo) > SERIAL_FRAME_HEADER_SIZE) 
+    if(fifo_spsc_get_size(&rx_fifo) > SERIAL_FRAME_HEADER_SIZE) 
     {
-        fifo_peek(&rx_fifo, header, 0, SERIAL_FRAME_HEADER_SIZE);
+        fifo_spsc_peek(&rx_fifo, header, 0, SERIAL_FRAME_HEADER_SIZE);
 
         if(header[0] != SERIAL_FRAME_SYNC_BYTE || header[1] != SERIAL_FRAME_VERSION) 
         {
-          fifo_skip(&rx_fifo, 1);
+          fifo_spsc_skip(&rx_fifo, 1);
           DPRINT("skip");
           parsed_header = false;
           payload_len = 0;
-          if(fifo_get_size(&rx_fifo) > SERIAL_FRAME_HEADER_SIZE)
+          if(fifo_spsc_get_size(&rx_fifo) > SERIAL_FRAME_HEADER_SIZE)
             sched_post_task(&process_rx_fifo);
           return;
         }
         parsed_header = true;
-        fifo_skip(&rx_fifo, SERIAL_FRAME_HEADER_SIZE);
+        fifo_spsc_skip(&rx_fifo, SERIAL_FRAME_HEADER_SIZE);
         payload_len = header[SERIAL_FRAME_SIZE];
         DPRINT("UART RX, payload size = %i", payload_len);
         sched_post_task(&process_rx_fifo);
@@ -544,14 +568,14 @@ static void process_rx_fifo(void *arg)
   }
   else 
   {
-    if(fifo_get_size(&rx_fifo) < payload_len) {
+    if(fifo_spsc_get_size(&rx_fifo) < payload_len) {
       return;
     }
     // payload complete, start parsing
     // rx_fifo can be bigger than the current serial packet, init a subview fifo
     // which is restricted to payload_len so we can't parse past this packet.
     fifo_t payload_fifo;
-    fifo_init_subview(&payload_fifo, &rx_fifo, 0, payload_len);
+    assert(fifo_spsc_init_subview(&payload_fifo, &rx_fifo, 0, payload_len) == SUCCESS);
   
     if(verify_payload(&payload_fifo,header))
     {
@@ -584,7 +608,7 @@ static void process_rx_fifo(void *arg)
         fifo_skip(&payload_fifo, payload_len);
         DPRINT("!!!FRAME TYPE NOT IMPLEMENTED");
       }
-      fifo_skip(&rx_fifo, payload_len - fifo_get_size(&payload_fifo)); // pop parsed bytes from original fifo
+      fifo_spsc_skip(&rx_fifo, payload_len - fifo_get_size(&payload_fifo)); // pop parsed bytes from original fifo
     }
     else 
     {
@@ -593,7 +617,7 @@ static void process_rx_fifo(void *arg)
       
     payload_len = 0;
     parsed_header = false;
-    if(fifo_get_size(&rx_fifo) > SERIAL_FRAME_HEADER_SIZE)
+    if(fifo_spsc_get_size(&rx_fifo) > SERIAL_FRAME_HEADER_SIZE)
       sched_post_task(&process_rx_fifo);
   }
 }
@@ -610,14 +634,12 @@ static void uart_tx_cb()
  */
 static void uart_rx_callback(uint8_t data)
 {
-    error_t err;
-    start_atomic();
-    err = fifo_put(&rx_fifo, &data, 1);
+    // this is the only producer of rx_fifo, so no critical section is needed
+    error_t err = fifo_put_from_isr(&rx_fifo, &data, 1);
     assert(err == SUCCESS);
-    end_atomic();
 
 #ifndef FRAMEWORK_MODEM_INTERFACE_USE_INTERRUPT_LINES
-    sched_post_task(&process_rx_fifo);
+    sched_post_task_id_from_isr(process_rx_fifo_id, DEFAULT_PRIORITY, NULL);
 #endif
 }
 #endif
@@ -629,7 +651,7 @@ static void uart_int_cb(void *arg)
 {
   target_uart_state_isr_count++;
   // do not read GPIO level here in interrupt context (GPIO clock might not be enabled yet), execute state machine instead
-  sched_post_task(&execute_state_machine);
+  sched_post_task_id_from_isr(execute_state_machine_id, DEFAULT_PRIORITY, NULL);
 }
 
 static void modem_interface_set_rx_interrupt_callback(uart_rx_inthandler_t uart_rx_cb) {
@@ -650,6 +672,8 @@ void modem_interface_init(uint8_t idx, uint32_t baudrate, pin_id_t uart_state_pi
   sched_register_task(&flush_modem_interface_tx_fifo);
   sched_register_task(&execute_state_machine);
   sched_register_task(&process_rx_fifo);
+  process_rx_fifo_id = sched_get_task_id(&process_rx_fifo);
+  execute_state_machine_id = sched_get_task_id(&execute_state_machine);
   state = STATE_IDLE;
   uart_state_pin=uart_state_pin_id;
   target_uart_state_pin=target_uart_state_pin_id;
@@ -657,7 +681,7 @@ void modem_interface_init(uint8_t idx, uint32_t baudrate, pin_id_t uart_state_pi
   uart = uart_init(idx, baudrate,0);
   DPRINT("uart initialized");
   
-  fifo_init(&rx_fifo, rx_buffer, sizeof(rx_buffer));
+  assert(fifo_spsc_init(&rx_fifo, rx_buffer, sizeof(rx_buffer)) == SUCCESS);
 #ifdef FRAMEWORK_MODEM_INTERFACE_USE_DMA
   dma_rx = dma_channel_init(PLATFORM_MODEM_INTERFACE_DMA_RX);
   dma_tx = dma_channel_init(PLATFORM_MODEM_INTERFACE_DMA_TX);
@@ -692,6 +716,25 @@ void modem_interface_init(uint8_t idx, uint32_t baudrate, pin_id_t uart_state_pi
 #endif
 }
 
+// copies data into the space returned by fifo_reserve(), starting at the given offset in that space
+static void write_reserved(fifo_segment_t segments[2], uint16_t offset, const uint8_t* data, uint16_t len)
+{
+  for(uint8_t i = 0; i < 2 && len > 0; i++)
+  {
+    if(offset >= segments[i].len)
+    {
+      offset -= segments[i].len;
+      continue;
+    }
+
+    uint16_t chunk = segments[i].len - offset < len ? segments[i].len - offset : len;
+    memcpy(segments[i].data + offset, data, chunk);
+    data += chunk;
+    len -= chunk;
+    offset = 0;
+  }
+}
+
 error_t modem_interface_transfer_bytes(uint8_t* bytes, uint8_t length, serial_message_type_t type) 
 {
   error_t result;
@@ -713,12 +756,15 @@ error_t modem_interface_transfer_bytes(uint8_t* bytes, uint8_t length, serial_me
   DPRINT("TX PAYLOAD:");
   DPRINT_DATA(bytes, length);
    
+  fifo_segment_t segments[2];
   start_atomic();
-  if((sizeof(modem_interface_tx_buffer) - fifo_get_size(&modem_interface_tx_fifo)) >= (uint8_t) (SERIAL_FRAME_HEADER_SIZE + length))
+  // the frame is written straight into the free space of the FIFO and only added to it as a whole
+  if(fifo_reserve(&modem_interface_tx_fifo, SERIAL_FRAME_HEADER_SIZE + length, segments) == SUCCESS)
   {
     request_pending = true;
-    fifo_put(&modem_interface_tx_fifo, (uint8_t*) &frame_header, SERIAL_FRAME_HEADER_SIZE);
-    fifo_put(&modem_interface_tx_fifo, bytes, length);
+    write_reserved(segments, 0, frame_header, SERIAL_FRAME_HEADER_SIZE);
+    write_reserved(segments, SERIAL_FRAME_HEADER_SIZE, bytes, length);
+    fifo_commit(&modem_interface_tx_fifo, SERIAL_FRAME_HEADER_SIZE + length);
 
 #ifdef FRAMEWORK_MODEM_INTERFACE_USE_INTERRUPT_LINES
     sched_post_task_prio(&execute_state_machine, MIN_PRIORITY, NULL);
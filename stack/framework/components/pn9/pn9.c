@@ -21,8 +21,54 @@
  */
 
 #include <stdint.h>
+#include <string.h>
 
 #include "pn9.h"
+#include "crc.h"
+
+#define PN9_SEQUENCE_LENGTH 511 // the byte sequence repeats after 511 bytes
+
+#if UINTPTR_MAX > 0xFFFFFFFF
+typedef uint64_t pn9_word_t;
+#else
+typedef uint32_t pn9_word_t;
+#endif
+
+// the whitening sequence starting from PN9_INITIALIZER, as generated by pn9_generator()
+static const uint8_t pn9_sequence[PN9_SEQUENCE_LENGTH] = {
+    0xFF, 0xE1, 0x1D, 0x9A, 0xED, 0x85, 0x33, 0x24, 0xEA, 0x7A, 0xD2, 0x39, 0x70, 0x97, 0x57, 0x0A,
+    0x54, 0x7D, 0x2D, 0xD8, 0x6D, 0x0D, 0xBA, 0x8F, 0x67, 0x59, 0xC7, 0xA2, 0xBF, 0x34, 0xCA, 0x18,
+    0x30, 0x53, 0x93, 0xDF, 0x92, 0xEC, 0xA7, 0x15, 0x8A, 0xDC, 0xF4, 0x86, 0x55, 0x4E, 0x18, 0x21,
+    0x40, 0xC4, 0xC4, 0xD5, 0xC6, 0x91, 0x8A, 0xCD, 0xE7, 0xD1, 0x4E, 0x09, 0x32, 0x17, 0xDF, 0x83,
+    0xFF, 0xF0, 0x0E, 0xCD, 0xF6, 0xC2, 0x19, 0x12, 0x75, 0x3D, 0xE9, 0x1C, 0xB8, 0xCB, 0x2B, 0x05,
+    0xAA, 0xBE, 0x16, 0xEC, 0xB6, 0x06, 0xDD, 0xC7, 0xB3, 0xAC, 0x63, 0xD1, 0x5F, 0x1A, 0x65, 0x0C,
+    0x98, 0xA9, 0xC9, 0x6F, 0x49, 0xF6, 0xD3, 0x0A, 0x45, 0x6E, 0x7A, 0xC3, 0x2A, 0x27, 0x8C, 0x10,
+    0x20, 0x62, 0xE2, 0x6A, 0xE3, 0x48, 0xC5, 0xE6, 0xF3, 0x68, 0xA7, 0x04, 0x99, 0x8B, 0xEF, 0xC1,
+    0x7F, 0x78, 0x87, 0x66, 0x7B, 0xE1, 0x0C, 0x89, 0xBA, 0x9E, 0x74, 0x0E, 0xDC, 0xE5, 0x95, 0x02,
+    0x55, 0x5F, 0x0B, 0x76, 0x5B, 0x83, 0xEE, 0xE3, 0x59, 0xD6, 0xB1, 0xE8, 0x2F, 0x8D, 0x32, 0x06,
+    0xCC, 0xD4, 0xE4, 0xB7, 0x24, 0xFB, 0x69, 0x85, 0x22, 0x37, 0xBD, 0x61, 0x95, 0x13, 0x46, 0x08,
+    0x10, 0x31, 0x71, 0xB5, 0x71, 0xA4, 0x62, 0xF3, 0x79, 0xB4, 0x53, 0x82, 0xCC, 0xC5, 0xF7, 0xE0,
+    0x3F, 0xBC, 0x43, 0xB3, 0xBD, 0x70, 0x86, 0x44, 0x5D, 0x4F, 0x3A, 0x07, 0xEE, 0xF2, 0x4A, 0x81,
+    0xAA, 0xAF, 0x05, 0xBB, 0xAD, 0x41, 0xF7, 0xF1, 0x2C, 0xEB, 0x58, 0xF4, 0x97, 0x46, 0x19, 0x03,
+    0x66, 0x6A, 0xF2, 0x5B, 0x92, 0xFD, 0xB4, 0x42, 0x91, 0x9B, 0xDE, 0xB0, 0xCA, 0x09, 0x23, 0x04,
+    0x88, 0x98, 0xB8, 0xDA, 0x38, 0x52, 0xB1, 0xF9, 0x3C, 0xDA, 0x29, 0x41, 0xE6, 0xE2, 0x7B, 0xF0,
+    0x1F, 0xDE, 0xA1, 0xD9, 0x5E, 0x38, 0x43, 0xA2, 0xAE, 0x27, 0x9D, 0x03, 0x77, 0x79, 0xA5, 0x40,
+    0xD5, 0xD7, 0x82, 0xDD, 0xD6, 0xA0, 0xFB, 0x78, 0x96, 0x75, 0x2C, 0xFA, 0x4B, 0xA3, 0x8C, 0x01,
+    0x33, 0x35, 0xF9, 0x2D, 0xC9, 0x7E, 0x5A, 0xA1, 0xC8, 0x4D, 0x6F, 0x58, 0xE5, 0x84, 0x11, 0x02,
+    0x44, 0x4C, 0x5C, 0x6D, 0x1C, 0xA9, 0xD8, 0x7C, 0x1E, 0xED, 0x94, 0x20, 0x73, 0xF1, 0x3D, 0xF8,
+    0x0F, 0xEF, 0xD0, 0x6C, 0x2F, 0x9C, 0x21, 0x51, 0xD7, 0x93, 0xCE, 0x81, 0xBB, 0xBC, 0x52, 0xA0,
+    0xEA, 0x6B, 0xC1, 0x6E, 0x6B, 0xD0, 0x7D, 0x3C, 0xCB, 0x3A, 0x16, 0xFD, 0xA5, 0x51, 0xC6, 0x80,
+    0x99, 0x9A, 0xFC, 0x96, 0x64, 0x3F, 0xAD, 0x50, 0xE4, 0xA6, 0x37, 0xAC, 0x72, 0xC2, 0x08, 0x01,
+    0x22, 0x26, 0xAE, 0x36, 0x8E, 0x54, 0x6C, 0x3E, 0x8F, 0x76, 0x4A, 0x90, 0xB9, 0xF8, 0x1E, 0xFC,
+    0x87, 0x77, 0x68, 0xB6, 0x17, 0xCE, 0x90, 0xA8, 0xEB, 0x49, 0xE7, 0xC0, 0x5D, 0x5E, 0x29, 0x50,
+    0xF5, 0xB5, 0x60, 0xB7, 0x35, 0xE8, 0x3E, 0x9E, 0x65, 0x1D, 0x8B, 0xFE, 0xD2, 0x28, 0x63, 0xC0,
+    0x4C, 0x4D, 0x7E, 0x4B, 0xB2, 0x9F, 0x56, 0x28, 0x72, 0xD3, 0x1B, 0x56, 0x39, 0x61, 0x84, 0x00,
+    0x11, 0x13, 0x57, 0x1B, 0x47, 0x2A, 0x36, 0x9F, 0x47, 0x3B, 0x25, 0xC8, 0x5C, 0x7C, 0x0F, 0xFE,
+    0xC3, 0x3B, 0x34, 0xDB, 0x0B, 0x67, 0x48, 0xD4, 0xF5, 0xA4, 0x73, 0xE0, 0x2E, 0xAF, 0x14, 0xA8,
+    0xFA, 0x5A, 0xB0, 0xDB, 0x1A, 0x74, 0x1F, 0xCF, 0xB2, 0x8E, 0x45, 0x7F, 0x69, 0x94, 0x31, 0x60,
+    0xA6, 0x26, 0xBF, 0x25, 0xD9, 0x4F, 0x2B, 0x14, 0xB9, 0xE9, 0x0D, 0xAB, 0x9C, 0x30, 0x42, 0x80,
+    0x88, 0x89, 0xAB, 0x8D, 0x23, 0x15, 0x9B, 0xCF, 0xA3, 0x9D, 0x12, 0x64, 0x2E, 0xBE, 0x07,
+};
 
 void pn9_next(uint16_t *last)
 {
@@ -42,13 +88,74 @@ uint16_t pn9_generator(uint16_t *pn9)
     return *pn9;
 }
 
+static void xor_sequence(uint8_t *data, const uint8_t *sequence, uint16_t length)
+{
+    // memcpy() takes care of unaligned accesses, it compiles to plain loads and stores where the core allows it
+    for (; length >= sizeof(pn9_word_t); length -= sizeof(pn9_word_t)) {
+        pn9_word_t d, s;
+        memcpy(&d, data, sizeof(d));
+        memcpy(&s, sequence, sizeof(s));
+        d ^= s;
+        memcpy(data, &d, sizeof(d));
+        data += sizeof(pn9_word_t);
+        sequence += sizeof(pn9_word_t);
+    }
+
+    while (length--)
+        *data++ ^= *sequence++;
+}
+
+void pn9_encode_from(uint8_t *data, uint16_t length, uint16_t offset)
+{
+    uint16_t position = offset % PN9_SEQUENCE_LENGTH;
+    while (length > 0) {
+        uint16_t chunk = PN9_SEQUENCE_LENGTH - position;
+        if (chunk > length)
+            chunk = length;
+
+        xor_sequence(data, &pn9_sequence[position], chunk);
+        data += chunk;
+        length -= chunk;
+        position = 0;
+    }
+}
+
 void pn9_encode(uint8_t *data, uint16_t length)
 {
-    uint16_t pn9 = PN9_INITIALIZER; //// LFSR initialised to the specified polynomial
-    uint8_t *p = data;
+    pn9_encode_from(data, length, 0);
+}
+
+uint16_t pn9_encode_crc(uint8_t *dst, const uint8_t *src, uint16_t length, uint16_t offset, uint16_t crc)
+{
+    uint16_t position = offset % PN9_SEQUENCE_LENGTH;
+    while (length > 0) {
+        uint16_t chunk = PN9_SEQUENCE_LENGTH - position;
+        if (chunk > length)
+            chunk = length;
 
-    for (; p < data + length; p++) {
-        *p ^= pn9;
-        pn9_generator(&pn9);
+        crc = crc_update_xor_input(crc, dst, src, &pn9_sequence[position], chunk);
+        dst += chunk;
+        src += chunk;
+        length -= chunk;
+        position = 0;
     }
+
+    return crc;
+}
+
+uint16_t pn9_decode_crc(uint8_t *data, uint16_t length, uint16_t offset, uint16_t crc)
+{
+    uint16_t position = offset % PN9_SEQUENCE_LENGTH;
+    while (length > 0) {
+        uint16_t chunk = PN9_SEQUENCE_LENGTH - position;
+        if (chunk > length)
+            chunk = length;
+
+        crc = crc_update_xor_output(crc, data, data, &pn9_sequence[position], chunk);
+        data += chunk;
+        length -= chunk;
+        position = 0;
+    }
+
+    return crc;
 }
@@ -84,7 +84,20 @@ error_t power_tracking_file_initialize()
     switch (ret) {
     case -EEXIST:
     {
-        uint32_t length = POWER_TRACKING_FILE_SIZE;
+        uint32_t length = d7ap_fs_get_file_length(POWER_TRACKING_FILE_ID);
+        if(length < POWER_TRACKING_FILE_SIZE)
+        {
+            // the file was created by a build which tracked less fields, these are appended so keep the existing
+            // values and grow the file into its allocated space, otherwise every write of the full file is refused
+            ret = d7ap_fs_change_file_length(POWER_TRACKING_FILE_ID, POWER_TRACKING_FILE_SIZE);
+            if(ret != SUCCESS)
+            {
+                log_print_error_string("Error growing power tracking file: %d", ret);
+                return ret;
+            }
+        }
+        else
+            length = POWER_TRACKING_FILE_SIZE;
         d7ap_fs_read_file(POWER_TRACKING_FILE_ID, 0, current_power_tracking_file.bytes, &length, ROOT_AUTH);
         cpu_active_time_prev_store_value = current_power_tracking_file.cpu_active_time;
         break;
@@ -156,6 +169,19 @@ error_t power_tracking_register_radio_action(power_tracking_transmit_mode_t powe
 }
 #endif // FRAMEWORK_POWER_TRACKING_RF
 
+#ifdef FRAMEWORK_POWER_TRACKING_LP_MODES
+error_t power_tracking_register_lp_mode_time(uint8_t mode, timer_tick_t time)
+{
+    if(mode >= POWER_TRACKING_LP_MODES)
+        return -EINVAL;
+
+    // only kept in RAM, this is persisted together with the active time
+    current_power_tracking_file.lp_mode_count[mode]++;
+    current_power_tracking_file.lp_mode_time[mode] += time;
+    return SUCCESS;
+}
+#endif // FRAMEWORK_POWER_TRACKING_LP_MODES
+
 error_t power_tracking_register_run_time(timer_tick_t time)
 {
     current_power_tracking_file.cpu_active_time += time;
@@ -48,24 +48,52 @@
 _Static_assert(SCHEDULER_MAX_TASKS < UINT8_MAX,
                "SCHEDULER_MAX_TASKS can not be set larger than 254");
 
-#ifdef NODE_GLOBALS
-    #warning NODE_GLOBALS is defined when using the default scheduler. Are you sure this is what you want ?
-#endif
-
 #if defined(FRAMEWORK_LOG_ENABLED) && defined(FRAMEWORK_SCHED_LOG_ENABLED)
   #define DPRINT(...) log_print_string( __VA_ARGS__)
 #else
   #define DPRINT(...)
 #endif
 
+_Static_assert(MIN_PRIORITY < 15, "the ready lists bitmap is 16 bits wide");
+
 enum
 {
 	NUM_PRIORITIES = MIN_PRIORITY+1,
+	// the list of tasks posted with a deadline, sorted on deadline and executed before the tasks of all priorities
+	DEADLINE_LIST = NUM_PRIORITIES,
+	NUM_LISTS = NUM_PRIORITIES+1,
 	NUM_TASKS = SCHEDULER_MAX_TASKS,
-	NOT_SCHEDULED = NUM_PRIORITIES,
+	NOT_SCHEDULED = NUM_LISTS,
 	NO_TASK = SCHEDULER_MAX_TASKS,
+	// a task can only be queued once by sched_post_task_id_from_isr() until it is drained, so the ISR queue can not overflow
+	ISR_QUEUE_SIZE = NUM_TASKS <= 16 ? 16 : NUM_TASKS <= 32 ? 32 : NUM_TASKS <= 64 ? 64 : NUM_TASKS <= 128 ? 128 : 256,
 };
 
+// The ISR queue is written with atomic read-modify-write instructions only. Cores without them (Cortex-M0+) fall back
+// to a critical section around the single read-modify-write.
+#if __GCC_ATOMIC_CHAR_LOCK_FREE == 2
+#define atomic_exchange_u8(ptr, value) __atomic_exchange_n(ptr, value, __ATOMIC_ACQ_REL)
+#define atomic_fetch_add_u8(ptr, value) __atomic_fetch_add(ptr, value, __ATOMIC_ACQ_REL)
+#else
+static inline uint8_t atomic_exchange_u8(volatile uint8_t* ptr, uint8_t value)
+{
+	start_atomic();
+	uint8_t old = *ptr;
+	*ptr = value;
+	end_atomic();
+	return old;
+}
+
+static inline uint8_t atomic_fetch_add_u8(volatile uint8_t* ptr, uint8_t value)
+{
+	start_atomic();
+	uint8_t old = *ptr;
+	*ptr = old + value;
+	end_atomic();
+	return old;
+}
+#endif
+
 typedef struct
 {
 	task_t task;
@@ -73,7 +101,13 @@ typedef struct
 	uint8_t next;
 	uint8_t prev;
 	uint8_t priority;
-
+	volatile uint8_t isr_posted; // queued in the ISR queue, with isr_priority and isr_arg
+	uint8_t isr_priority;
+	void *isr_arg;
+	timer_tick_t deadline; // only valid in the DEADLINE_LIST
+#ifdef FRAMEWORK_SCHEDULER_PROFILING
+	timer_tick_t post_time;
+#endif
 } task_info_t;
 
 
@@ -86,19 +120,42 @@ typedef struct
 taskindex_info_t NGDEF(m_index)[NUM_TASKS];
 task_info_t NGDEF(m_info)[NUM_TASKS];
 
-uint8_t NGDEF(m_head)[NUM_PRIORITIES];
-uint8_t NGDEF(m_tail)[NUM_PRIORITIES];
-uint8_t current_task_id;
-volatile uint8_t NGDEF(current_priority);
+uint8_t NGDEF(m_head)[NUM_LISTS];
+uint8_t NGDEF(m_tail)[NUM_LISTS];
+static uint8_t NGDEF(_current_task_id);
+#define current_task_id NG(_current_task_id)
+// bit n is set when the list of priority n is not empty, the highest pending priority is the lowest bit set
+// the bit of the DEADLINE_LIST takes precedence over all priorities
+volatile uint16_t NGDEF(ready_lists);
+uint32_t NGDEF(missed_deadlines);
 uint8_t NGDEF(num_registered_tasks);
-static bool scheduler_active = false;
+#ifdef FRAMEWORK_SCHEDULER_PROFILING
+sched_task_stats_t NGDEF(m_stats)[NUM_TASKS];
+#endif
+// ids posted by sched_post_task_id_from_isr(), in order, which are moved to the task lists by drain_isr_queue()
+volatile uint8_t NGDEF(isr_queue)[ISR_QUEUE_SIZE];
+volatile uint8_t NGDEF(isr_queue_head);
+uint8_t NGDEF(isr_queue_tail);
+static bool NGDEF(_scheduler_active);
+#define scheduler_active NG(_scheduler_active)
 #if defined FRAMEWORK_USE_WATCHDOG
 #define WATCHDOG_WARNING_TIMEOUT TIMER_TICKS_PER_SEC * 17
-bool watchdog_wakeup;
-static timer_tick_t last_task_start_time = 0;
+static bool NGDEF(_watchdog_wakeup);
+#define watchdog_wakeup NG(_watchdog_wakeup)
+static timer_tick_t NGDEF(_last_task_start_time);
+#define last_task_start_time NG(_last_task_start_time)
 #endif
 
-volatile bool task_scheduled_after_sched_loop = false;
+static volatile bool NGDEF(_task_scheduled_after_sched_loop);
+#define task_scheduled_after_sched_loop NG(_task_scheduled_after_sched_loop)
+static uint8_t NGDEF(_low_power_mode);
+#define low_power_mode NG(_low_power_mode)
+
+// compares timer ticks in a circular fashion, like the timer does
+static inline bool is_before(timer_tick_t time, timer_tick_t reference)
+{
+	return (int32_t)(time - reference) < 0;
+}
 
 #ifdef SCHEDULER_DEBUG
 void check_structs_are_valid()
@@ -126,7 +183,7 @@ void check_structs_are_valid()
 
 
 	memset(visited, false, NUM_TASKS);
-	for(int prio = 0; prio < NUM_PRIORITIES;prio++)
+	for(int prio = 0; prio < NUM_LISTS;prio++)
 	{
 		uint8_t prev_ind=NO_TASK;
 		for(uint8_t cur_ind = NG(m_head)[prio]; cur_ind != NO_TASK; cur_ind = NG(m_info)[cur_ind].next)
@@ -143,6 +200,8 @@ void check_structs_are_valid()
 
 			assert(NG(m_info)[cur_ind].task != 0x0);
 			assert(NG(m_info)[cur_ind].priority == prio);
+			if(prio == DEADLINE_LIST && prev_ind != NO_TASK)
+				assert(!is_before(NG(m_info)[cur_ind].deadline, NG(m_info)[prev_ind].deadline));
 			prev_ind=cur_ind;
 		}
 		assert(NG(m_tail)[prio] == prev_ind);
@@ -152,9 +211,8 @@ void check_structs_are_valid()
 		assert((visited[i]) || NG(m_info)[i].priority == NOT_SCHEDULED);
 	}
 
-	assert(NG(current_priority) <= NUM_PRIORITIES);
-	for(int i = 0; i < NG(current_priority); i++)
-		assert(NG(m_head)[i] == NO_TASK);
+	for(int i = 0; i < NUM_LISTS; i++)
+		assert(((NG(ready_lists) >> i) & 1) == (NG(m_head)[i] != NO_TASK));
 	//INT_Enable();
 	end_atomic();
 }
@@ -174,23 +232,38 @@ __LINK_C void scheduler_init()
 		NG(m_info)[i].prev = NO_TASK;
 		NG(m_info)[i].task = 0x0;
 		NG(m_info)[i].priority = NOT_SCHEDULED;
+		NG(m_info)[i].isr_posted = false;
 
 		NG(m_index)[i].index = NO_TASK;
 		NG(m_index)[i].task = 0x0;
 	}
 	memset(NG(m_head), NO_TASK, sizeof(NG(m_head)));
 	memset(NG(m_tail), NO_TASK, sizeof(NG(m_tail)));
-	NG(current_priority) = NUM_PRIORITIES;
+	NG(ready_lists) = 0;
+	NG(missed_deadlines) = 0;
+#ifdef FRAMEWORK_SCHEDULER_PROFILING
+	memset(NG(m_stats), 0, sizeof(NG(m_stats)));
+#endif
+	memset((void*)NG(isr_queue), NO_TASK, sizeof(NG(isr_queue)));
+	NG(isr_queue_head) = 0;
+	NG(isr_queue_tail) = 0;
 	NG(num_registered_tasks) = 0;
+	scheduler_active = false;
+	task_scheduled_after_sched_loop = false;
+	low_power_mode = FRAMEWORK_SCHEDULER_LP_MODE;
 	check_structs_are_valid();
 #if defined FRAMEWORK_USE_WATCHDOG
 	__watchdog_init();
 	sched_register_task(&__feed_watchdog_task);
-	timer_post_task_prio_delay(&__feed_watchdog_task, hw_watchdog_get_timeout() * TIMER_TICKS_PER_SEC, MAX_PRIORITY);
+	// the watchdog can be fed in the second half of its timeout, together with any other timer event
+	timer_tick_t half_timeout = hw_watchdog_get_timeout() * TIMER_TICKS_PER_SEC / 2;
+	timer_post_task_prio(&__feed_watchdog_task, timer_get_counter_value() + half_timeout, MAX_PRIORITY, 0, half_timeout, NULL);
 #endif
 }
 
-__LINK_C uint8_t get_task_id(task_t task)
+// Returns the position in m_index of the first registration of the given task, or NO_TASK when it was not registered.
+// This search is only needed by the task_t based API, a sched_task_id_t indexes m_info directly.
+static uint8_t lookup_task(task_t task)
 {
 	check_structs_are_valid();
 	assert(NG(num_registered_tasks) <= NUM_TASKS);
@@ -207,7 +280,7 @@ __LINK_C uint8_t get_task_id(task_t task)
 			end = pivot-1;
 		else
 		{
-			while((pivot > 1) && (NG(m_index)[pivot-1].task == task))
+			while((pivot > 0) && (NG(m_index)[pivot-1].task == task))
 			{
 				pivot--;
 			}
@@ -219,15 +292,10 @@ __LINK_C uint8_t get_task_id(task_t task)
 	return NO_TASK;
 }
 
-__LINK_C error_t sched_register_task_allow_multiple(task_t task, bool allow)
+static sched_task_id_t register_task(task_t task)
 {
-  assert(NG(num_registered_tasks) < NUM_TASKS);
-  if(!allow && (get_task_id(task) != NO_TASK))
-    return -EALREADY;
-
-	error_t retVal;
+	sched_task_id_t id;
 	check_structs_are_valid();
-	//INT_Disable();
 	start_atomic();
 
     for(int i = NG(num_registered_tasks); i >= 0; i--)
@@ -245,13 +313,39 @@ __LINK_C error_t sched_register_task_allow_multiple(task_t task, bool allow)
             NG(m_index)[i] = NG(m_index)[i-1];
         }
     }
-    NG(num_registered_tasks)++;
-    retVal = SUCCESS;
+    // the id is the (fixed) slot in m_info, only m_index is reordered on registration
+    id = NG(num_registered_tasks)++;
 
-	//INT_Enable();
 	end_atomic();
 	check_structs_are_valid();
-	return retVal;
+	return id;
+}
+
+__LINK_C error_t sched_register_task_allow_multiple(task_t task, bool allow)
+{
+  assert(NG(num_registered_tasks) < NUM_TASKS);
+  if(!allow && (lookup_task(task) != NO_TASK))
+    return -EALREADY;
+
+  register_task(task);
+  return SUCCESS;
+}
+
+__LINK_C sched_task_id_t sched_register_task_id(task_t task)
+{
+  assert(NG(num_registered_tasks) < NUM_TASKS);
+  return register_task(task);
+}
+
+__LINK_C sched_task_id_t sched_get_task_id(task_t task)
+{
+	sched_task_id_t id = SCHED_INVALID_TASK_ID;
+	start_atomic();
+	uint8_t task_id = lookup_task(task);
+	if(task_id != NO_TASK)
+		id = NG(m_index)[task_id].index;
+	end_atomic();
+	return id;
 }
 
 static inline bool is_next_task_the_same(uint8_t id)
@@ -259,11 +353,17 @@ static inline bool is_next_task_the_same(uint8_t id)
 	return ((id + 1) < NG(num_registered_tasks)) && (NG(m_index)[id].task == NG(m_index)[id + 1].task);
 }
 
+// a task posted from an ISR which is not yet drained counts as scheduled
+static inline bool is_slot_scheduled(uint8_t index)
+{
+	return NG(m_info)[index].priority != NOT_SCHEDULED || NG(m_info)[index].isr_posted;
+}
+
 static inline bool is_scheduled(uint8_t id)
 {
 	assert(id < NUM_TASKS);
 	check_structs_are_valid();
-	return NG(m_info)[NG(m_index)[id].index].priority != NOT_SCHEDULED;
+	return is_slot_scheduled(NG(m_index)[id].index);
 }
 
 static bool is_scheduled_with_arg(uint8_t id, void *arg)
@@ -293,7 +393,7 @@ __LINK_C bool sched_is_scheduled_with_arg(task_t task, void *arg)
 {
 	//INT_Disable();
 	start_atomic();
-	uint8_t task_id = get_task_id(task);
+	uint8_t task_id = lookup_task(task);
 	bool retVal = false;
 	if(task_id != NO_TASK)
 	{
@@ -334,24 +434,124 @@ static error_t do_initial_task_checks(uint8_t task_id, void *arg, bool cancel)
 	return SUCCESS;
 }
 
-__LINK_C error_t sched_post_task_prio(task_t task, uint8_t priority, void *arg)
+// the queueing delay of a task is measured from the moment it was posted, also when it was posted from an ISR
+static inline void profile_post(uint8_t index)
+{
+#ifdef FRAMEWORK_SCHEDULER_PROFILING
+	NG(m_info)[index].post_time = timer_get_counter_value();
+#endif
+}
+
+#ifdef FRAMEWORK_SCHEDULER_PROFILING
+static void profile_run(uint8_t index, timer_tick_t start, timer_tick_t stop)
+{
+	sched_task_stats_t* stats = &NG(m_stats)[index];
+	timer_tick_t run_time = timer_calculate_difference(start, stop);
+	timer_tick_t queue_delay = timer_calculate_difference(NG(m_info)[index].post_time, start);
+	stats->invocations++;
+	stats->total_run_time += run_time;
+	stats->total_queue_delay += queue_delay;
+	if(run_time > stats->max_run_time)
+		stats->max_run_time = run_time;
+	if(queue_delay > stats->max_queue_delay)
+		stats->max_queue_delay = queue_delay;
+}
+#endif
+
+// appends the m_info slot to the tail of the list of the given priority, must be called atomically
+// in the DEADLINE_LIST the slot is inserted after all tasks with an earlier or the same deadline instead
+static void enqueue_task(uint8_t index, uint8_t priority, void *arg)
+{
+	uint8_t prev = NG(m_tail)[priority];
+	if(priority == DEADLINE_LIST)
+	{
+		while(prev != NO_TASK && is_before(NG(m_info)[index].deadline, NG(m_info)[prev].deadline))
+			prev = NG(m_info)[prev].prev;
+	}
+	uint8_t next = (prev == NO_TASK) ? NG(m_head)[priority] : NG(m_info)[prev].next;
+
+	NG(m_info)[index].prev = prev;
+	NG(m_info)[index].next = next;
+	if(prev == NO_TASK)
+		NG(m_head)[priority] = index;
+	else
+		NG(m_info)[prev].next = index;
+
+	if(next == NO_TASK)
+		NG(m_tail)[priority] = index;
+	else
+		NG(m_info)[next].prev = index;
+
+	NG(m_info)[index].priority = priority;
+	NG(m_info)[index].arg = arg;
+	NG(ready_lists) |= 1 << priority;
+	check_structs_are_valid();
+}
+
+// unlinks the m_info slot from the list it is scheduled in, must be called atomically
+static void dequeue_task(uint8_t index)
+{
+	if (NG(m_info)[index].prev == NO_TASK)
+	{
+		NG(m_head)[NG(m_info)[index].priority] = NG(m_info)[index].next;
+		if(NG(m_info)[index].next == NO_TASK)
+			NG(ready_lists) &= ~(1 << NG(m_info)[index].priority);
+	}
+	else
+		NG(m_info)[NG(m_info)[index].prev].next = NG(m_info)[index].next;
+
+	if (NG(m_info)[index].next == NO_TASK)
+		NG(m_tail)[NG(m_info)[index].priority] = NG(m_info)[index].prev;
+	else
+		NG(m_info)[NG(m_info)[index].next].prev = NG(m_info)[index].prev;
+
+	NG(m_info)[index].prev = NO_TASK;
+	NG(m_info)[index].next = NO_TASK;
+	NG(m_info)[index].priority = NOT_SCHEDULED;
+	check_structs_are_valid();
+}
+
+// moves the oldest task posted from an ISR to the task lists, returns false when the ISR queue is empty
+static bool drain_isr_queue_entry()
+{
+	start_atomic();
+	uint8_t slot = NG(isr_queue_tail) & (ISR_QUEUE_SIZE - 1);
+	uint8_t index = NG(isr_queue)[slot];
+	if(index != NO_TASK)
+	{
+		NG(isr_queue)[slot] = NO_TASK;
+		NG(isr_queue_tail)++;
+		NG(m_info)[index].isr_posted = false;
+		if(NG(m_info)[index].priority == NOT_SCHEDULED)
+			enqueue_task(index, NG(m_info)[index].isr_priority, NG(m_info)[index].isr_arg);
+	}
+	end_atomic();
+	return index != NO_TASK;
+}
+
+// Every entry is moved in a separate, short atomic section. An ISR which reserved a slot but did not yet write its id
+// (because it was interrupted by a nested ISR which posted as well) stops the drain, the remaining entries are drained
+// once the interrupted ISR finished.
+static void drain_isr_queue()
+{
+	while(drain_isr_queue_entry());
+}
+
+// posts a task registered with the task_t based API in the given list
+static error_t post_task(task_t task, uint8_t list, timer_tick_t deadline, void *arg)
 {
 	error_t retVal;
 	start_atomic();
 	check_structs_are_valid();
-	uint8_t task_id = get_task_id(task);
+	uint8_t task_id = lookup_task(task);
 	retVal = do_initial_task_checks(task_id, arg, false);
-	if(priority > MIN_PRIORITY)
-	{
-		retVal = -ESIZE;
-	}
-	else if(retVal == SUCCESS)
+	if(retVal == SUCCESS)
 	{
 		if(is_next_task_the_same(task_id))
 		{
 			while (true)
 			{
-				if(NG(m_info)[NG(m_index)[task_id].index].priority == NOT_SCHEDULED)
+				if(!is_slot_scheduled(NG(m_index)[task_id].index))
 				{
 					break;
 				}
@@ -366,26 +566,11 @@ __LINK_C error_t sched_post_task_prio(task_t task, uint8_t priority, void *arg)
 				}
 			}
 		}
-		uint8_t index = NG(m_index)[task_id].index;
 		if(retVal == SUCCESS)
 		{
-			if(NG(m_head)[priority] == NO_TASK)
-			{
-				NG(m_head)[priority] = index;
-				NG(m_tail)[priority] = index;
-			}
-			else
-			{
-				NG(m_info)[NG(m_tail)[priority]].next = index;
-				NG(m_info)[index].prev = NG(m_tail)[priority];
-				NG(m_tail)[priority] = index;
-			}
-			NG(m_info)[index].priority = priority;
-			NG(m_info)[index].arg = arg;
-			//if our priority is higher than the currently known maximum priority
-			if((priority < NG(current_priority)))
-				NG(current_priority) = priority;
-			check_structs_are_valid();
+			profile_post(NG(m_index)[task_id].index);
+			NG(m_info)[NG(m_index)[task_id].index].deadline = deadline;
+			enqueue_task(NG(m_index)[task_id].index, list, arg);
 		}
 	}
 	end_atomic();
@@ -394,13 +579,28 @@ __LINK_C error_t sched_post_task_prio(task_t task, uint8_t priority, void *arg)
 	return retVal;
 }
 
+__LINK_C error_t sched_post_task_prio(task_t task, uint8_t priority, void *arg)
+{
+	if(priority > MIN_PRIORITY)
+		return -ESIZE;
+
+	return post_task(task, priority, 0, arg);
+}
+
+__LINK_C error_t sched_post_task_deadline(task_t task, timer_tick_t deadline, void *arg)
+{
+	return post_task(task, DEADLINE_LIST, deadline, arg);
+}
+
 __LINK_C error_t sched_cancel_task_with_arg(task_t task, void *arg)
 {
 	check_structs_are_valid();
 	error_t retVal = SUCCESS;
 
 	start_atomic();
-	uint8_t id = get_task_id(task);
+	// a task posted from an ISR can only be cancelled once it is in the task lists
+	drain_isr_queue();
+	uint8_t id = lookup_task(task);
 	retVal = do_initial_task_checks(id, arg, true);
 	if(retVal == SUCCESS)
 	{
@@ -425,57 +625,157 @@ __LINK_C error_t sched_cancel_task_with_arg(task_t task, void *arg)
 			}
 		}
 		if(retVal == SUCCESS)
-		{
-			uint8_t index = NG(m_index)[id].index;
-			if (NG(m_info)[index].prev == NO_TASK)
-				NG(m_head)[NG(m_info)[index].priority] = NG(m_info)[index].next;
-			else
-				NG(m_info)[NG(m_info)[index].prev].next = NG(m_info)[index].next;
-
-			if (NG(m_info)[index].next == NO_TASK)
-				NG(m_tail)[NG(m_info)[index].priority] = NG(m_info)[index].prev;
-			else
-				NG(m_info)[NG(m_info)[index].next].prev = NG(m_info)[index].prev;
-
-			NG(m_info)[index].prev = NO_TASK;
-			NG(m_info)[index].next = NO_TASK;
-			NG(m_info)[index].priority = NOT_SCHEDULED;
-			check_structs_are_valid();
-		}
+			dequeue_task(NG(m_index)[id].index);
 	}
 	end_atomic();
 	return retVal;
 }
 
-static uint8_t pop_task(int priority)
+static error_t post_task_id(sched_task_id_t id, uint8_t list, timer_tick_t deadline, void *arg)
 {
-	uint8_t id = NO_TASK;
-	check_structs_are_valid();
+	error_t retVal = -EALREADY;
 	start_atomic();
-	if (NG(m_head)[priority] != NO_TASK)
+	if(!is_slot_scheduled(id))
 	{
-		id = NG(m_head)[priority];
-		NG(m_head)[priority] = NG(m_info)[NG(m_head)[priority]].next;
-		if(NG(m_head)[priority] == NO_TASK)
-			NG(m_tail)[priority] = NO_TASK;
-		else
-			NG(m_info)[NG(m_head)[priority]].prev = NO_TASK;
+		profile_post(id);
+		NG(m_info)[id].deadline = deadline;
+		enqueue_task(id, list, arg);
+		retVal = SUCCESS;
+	}
+	end_atomic();
+	task_scheduled_after_sched_loop = true;
+	return retVal;
+}
+
+__LINK_C error_t sched_post_task_id(sched_task_id_t id, uint8_t priority, void *arg)
+{
+	if(id >= NG(num_registered_tasks))
+		return -EINVAL;
+	if(priority > MIN_PRIORITY)
+		return -ESIZE;
+
+	return post_task_id(id, priority, 0, arg);
+}
+
+__LINK_C error_t sched_post_task_id_deadline(sched_task_id_t id, timer_tick_t deadline, void *arg)
+{
+	if(id >= NG(num_registered_tasks))
+		return -EINVAL;
+
+	return post_task_id(id, DEADLINE_LIST, deadline, arg);
+}
+
+__LINK_C uint32_t sched_get_missed_deadlines()
+{
+	return NG(missed_deadlines);
+}
+
+__LINK_C error_t sched_cancel_task_id(sched_task_id_t id)
+{
+	if(id >= NG(num_registered_tasks))
+		return -EINVAL;
 
-		NG(m_info)[id].next = NO_TASK;
-		NG(m_info)[id].prev = NO_TASK;
-		NG(m_info)[id].priority = NOT_SCHEDULED;
+	error_t retVal = -EALREADY;
+	start_atomic();
+	drain_isr_queue();
+	if(NG(m_info)[id].priority != NOT_SCHEDULED)
+	{
+		dequeue_task(id);
+		retVal = SUCCESS;
 	}
 	end_atomic();
+	return retVal;
+}
+
+__LINK_C bool sched_is_scheduled_id(sched_task_id_t id)
+{
+	return (id < NG(num_registered_tasks)) && is_slot_scheduled(id);
+}
+
+__LINK_C error_t sched_post_task_id_from_isr(sched_task_id_t id, uint8_t priority, void *arg)
+{
+	if(id >= NG(num_registered_tasks))
+		return -EINVAL;
+	if(priority > MIN_PRIORITY)
+		return -ESIZE;
+	if(NG(m_info)[id].priority != NOT_SCHEDULED)
+		return -EALREADY;
+
+	// claim the task, only one post can be queued per task so the argument is not overwritten until it is drained
+	if(atomic_exchange_u8(&NG(m_info)[id].isr_posted, true))
+		return -EALREADY;
+
+	NG(m_info)[id].isr_priority = priority;
+	NG(m_info)[id].isr_arg = arg;
+	profile_post(id);
+	uint8_t slot = atomic_fetch_add_u8(&NG(isr_queue_head), 1) & (ISR_QUEUE_SIZE - 1);
+	NG(isr_queue)[slot] = id;
+	task_scheduled_after_sched_loop = true;
+	return SUCCESS;
+}
+
+// pops the first task of the highest pending priority, returns NO_TASK when no tasks are pending
+// the list the task was popped from is returned in 'list'
+static uint8_t pop_task(uint8_t* list)
+{
+	uint8_t id = NO_TASK;
+	bool isr_queue_empty;
+	do
+	{
+		drain_isr_queue();
+		start_atomic();
+		uint16_t ready = NG(ready_lists);
+		// an ISR can post a task after the ISR queue was drained
+		isr_queue_empty = NG(isr_queue)[NG(isr_queue_tail) & (ISR_QUEUE_SIZE - 1)] == NO_TASK;
+		if(ready)
+		{
+			uint8_t priority = (ready & (1 << DEADLINE_LIST)) ? DEADLINE_LIST : __builtin_ctz(ready);
+			*list = priority;
+			id = NG(m_head)[priority];
+			NG(m_head)[priority] = NG(m_info)[id].next;
+			if(NG(m_head)[priority] == NO_TASK)
+			{
+				NG(m_tail)[priority] = NO_TASK;
+				NG(ready_lists) = ready & ~(1 << priority);
+			}
+			else
+				NG(m_info)[NG(m_head)[priority]].prev = NO_TASK;
+
+			NG(m_info)[id].next = NO_TASK;
+			NG(m_info)[id].priority = NOT_SCHEDULED;
+		}
+		else if(isr_queue_empty)
+		{
+			// the task lists are empty, a task posted from now on has to prevent scheduler_run() from sleeping
+			task_scheduled_after_sched_loop = false;
+		}
+		end_atomic();
+	} while(id == NO_TASK && !isr_queue_empty);
+
 	check_structs_are_valid();
 	return id;
 }
 
-static inline bool tasks_waiting(int priority)
+#ifdef FRAMEWORK_SCHEDULER_PROFILING
+__LINK_C error_t sched_get_task_stats(sched_task_id_t id, task_t* task, sched_task_stats_t* stats)
 {
-	return NG(m_head)[priority] != NO_TASK;
+	if(id >= NG(num_registered_tasks))
+		return -EINVAL;
+
+	start_atomic();
+	*task = NG(m_info)[id].task;
+	*stats = NG(m_stats)[id];
+	end_atomic();
+	return SUCCESS;
 }
 
-static uint8_t low_power_mode = FRAMEWORK_SCHEDULER_LP_MODE;
+__LINK_C void sched_reset_task_stats()
+{
+	start_atomic();
+	memset(NG(m_stats), 0, sizeof(NG(m_stats)));
+	end_atomic();
+}
+#endif
 
 uint8_t sched_get_low_power_mode(void) {
   return low_power_mode;
@@ -485,6 +785,33 @@ void sched_set_low_power_mode(uint8_t mode) {
   low_power_mode = mode;
 }
 
+__LINK_C uint8_t sched_select_low_power_mode(void)
+{
+#ifdef FRAMEWORK_SCHEDULER_TICKLESS_IDLE
+	uint64_t idle_time = UINT64_MAX;
+	timer_tick_t fire_time;
+	if(timer_get_next_event_time(&fire_time))
+	{
+		int32_t delay = (int32_t)(fire_time - timer_get_counter_value());
+		idle_time = delay > 0 ? delay : 0;
+	}
+
+	for(uint8_t mode = low_power_mode; mode > 0; mode--)
+	{
+		uint32_t latency = hw_get_lowpower_mode_wakeup_latency(mode);
+		if(latency == HW_LOWPOWER_MODE_UNAVAILABLE)
+			continue;
+
+		// round the latency up to whole timer ticks
+		if(((uint64_t)latency * TIMER_TICKS_PER_SEC + 999999) / 1000000 <= idle_time)
+			return mode;
+	}
+	return 0;
+#else
+	return low_power_mode;
+#endif
+}
+
 // This is in interrupt context
 __LINK_C timer_tick_t sched_check_software_watchdog(task_t task, timer_tick_t current_time) {
 #ifdef FRAMEWORK_USE_WATCHDOG
@@ -519,79 +846,92 @@ __LINK_C task_t sched_get_current_task(void)
 	}
 }
 
-__LINK_C void scheduler_run()
+__LINK_C void scheduler_run_pending_tasks()
 {
-	while(1)
-	{
 #if defined FRAMEWORK_USE_WATCHDOG
-		bool task_list_empty = true;
-		uint8_t executed_tasks = 0;
-		watchdog_wakeup = false;
+	bool task_list_empty = true;
+	uint8_t executed_tasks = 0;
+	watchdog_wakeup = false;
 #endif
 #if defined FRAMEWORK_USE_POWER_TRACKING
-		timer_tick_t wakeup_time = timer_get_counter_value();
+	timer_tick_t wakeup_time = timer_get_counter_value();
 #endif
-		while(NG(current_priority) < NUM_PRIORITIES)
-		{
-			check_structs_are_valid();
-			for(uint8_t id = pop_task((NG(current_priority))); id != NO_TASK; id = pop_task(NG(current_priority)))
-			{
-				scheduler_active = true;
+	uint8_t list;
+	for(uint8_t id = pop_task(&list); id != NO_TASK; id = pop_task(&list))
+	{
+		scheduler_active = true;
 #if defined FRAMEWORK_USE_WATCHDOG
-				executed_tasks++;
-				task_list_empty = false;
-				hw_watchdog_feed();
-				last_task_start_time = timer_get_counter_value();
+		executed_tasks++;
+		task_list_empty = false;
+		hw_watchdog_feed();
+		last_task_start_time = timer_get_counter_value();
 #endif
-				check_structs_are_valid();
 #if defined(FRAMEWORK_LOG_ENABLED) && defined(FRAMEWORK_SCHED_LOG_ENABLED)
-        timer_tick_t start = timer_get_counter_value();
-        log_print_string("SCHED start %p at %i", NG(m_info)[id].task, start);
+		timer_tick_t start = timer_get_counter_value();
+		log_print_string("SCHED start %p at %i", NG(m_info)[id].task, start);
 #endif
 		current_task_id = id;
-        NG(m_info)[id].task(NG(m_info)[id].arg);
-#if defined(FRAMEWORK_LOG_ENABLED) && defined(FRAMEWORK_SCHED_LOG_ENABLED)
-        timer_tick_t stop = timer_get_counter_value();
-        timer_tick_t duration = stop - start;
-        log_print_string("SCHED stop %p at %i took %i", NG(m_info)[id].task, stop, duration);
+		// the task can post itself again with a new deadline
+		timer_tick_t deadline = NG(m_info)[id].deadline;
+#ifdef FRAMEWORK_SCHEDULER_PROFILING
+		timer_tick_t run_start = timer_get_counter_value();
 #endif
-			}
-			//this needs to be done atomically since otherwise we risk decrementing the current priority
-			//while a higher priority task is waiting in the queue
-			start_atomic();
-			if (!tasks_waiting(NG(current_priority)))
-				NG(current_priority)++;
-#ifndef NDEBUG
-			for(int i = 0; i < NG(current_priority); i++)
-				assert(!tasks_waiting(i));
+		NG(m_info)[id].task(NG(m_info)[id].arg);
+#ifdef FRAMEWORK_SCHEDULER_PROFILING
+		profile_run(id, run_start, timer_get_counter_value());
 #endif
-			task_scheduled_after_sched_loop = false;
-			end_atomic();	
-		}		
-		scheduler_active = false;
+		// a task has missed its deadline when it did not finish before it
+		if(list == DEADLINE_LIST && is_before(deadline, timer_get_counter_value()))
+		{
+			NG(missed_deadlines)++;
+#ifdef FRAMEWORK_SCHEDULER_PROFILING
+			NG(m_stats)[id].missed_deadlines++;
+#endif
+		}
+#if defined(FRAMEWORK_LOG_ENABLED) && defined(FRAMEWORK_SCHED_LOG_ENABLED)
+		timer_tick_t stop = timer_get_counter_value();
+		timer_tick_t duration = stop - start;
+		log_print_string("SCHED stop %p at %i took %i", NG(m_info)[id].task, stop, duration);
+#endif
+	}
+	scheduler_active = false;
 #if defined FRAMEWORK_USE_WATCHDOG
-		hw_watchdog_feed();
+	hw_watchdog_feed();
 #if defined FRAMEWORK_USE_POWER_TRACKING
-		//we don't want to register wake-ups that only trigger the watchdog
-		//we also need to check that the watchdog task was the only task that was executed as there is a small chance that
-		//the watchdog task is triggered when also other tasks are executing. In that case we want to track the time as active.
-		if(!(task_list_empty || (watchdog_wakeup && executed_tasks == 1)))
-		{
+	//we don't want to register wake-ups that only trigger the watchdog
+	//we also need to check that the watchdog task was the only task that was executed as there is a small chance that
+	//the watchdog task is triggered when also other tasks are executing. In that case we want to track the time as active.
+	if(!(task_list_empty || (watchdog_wakeup && executed_tasks == 1)))
+	{
 #endif
 #endif
 #if defined FRAMEWORK_USE_POWER_TRACKING
-			power_tracking_register_run_time(timer_get_current_time_difference(wakeup_time));
+		power_tracking_register_run_time(timer_get_current_time_difference(wakeup_time));
 #endif			
 #if defined FRAMEWORK_USE_WATCHDOG && defined FRAMEWORK_USE_POWER_TRACKING
-		}
+	}
 #endif
+}
+
+__LINK_C void scheduler_run()
+{
+	while(1)
+	{
+		scheduler_run_pending_tasks();
 
 		//during some oss7-testsuite cases we can see a scheduling of the flushing of the fifos for the UART in between the end of the scheduler 
 		//priority loop, and the call to enter low power mode. This caused the test to fail as the response was received by the testsuite only 
 		//after the watchdog woke up the device. So, task_scheduled_after_sched_loop is used to ensure the tasklist is really empty.
 		start_atomic();
 		if(!task_scheduled_after_sched_loop) {
-			hw_enter_lowpower_mode(low_power_mode);
+			uint8_t mode = sched_select_low_power_mode();
+#ifdef FRAMEWORK_POWER_TRACKING_LP_MODES
+			timer_tick_t sleep_start = timer_get_counter_value();
+#endif
+			hw_enter_lowpower_mode(mode);
+#ifdef FRAMEWORK_POWER_TRACKING_LP_MODES
+			power_tracking_register_lp_mode_time(mode, timer_get_current_time_difference(sleep_start));
+#endif
 		}
 		end_atomic();
 	}
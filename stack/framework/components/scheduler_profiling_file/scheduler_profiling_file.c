@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scheduler_profiling_file.h"
+
+#include "d7ap_fs.h"
+#include "debug.h"
+#include "log.h"
+#include "modules_defs.h"
+#include "timer.h"
+
+#include "string.h"
+
+#ifndef MODULE_D7AP_FS
+#error Module D7AP_FS is needed to use the scheduler profiling file
+#endif
+
+#ifndef FRAMEWORK_SCHEDULER_PROFILING
+#error FRAMEWORK_SCHEDULER_PROFILING is needed to use the scheduler profiling file
+#endif
+
+#define UPDATE_PERIOD TIMER_TICKS_PER_MINUTE
+
+_Static_assert(SCHEDULER_PROFILING_FILE_ENTRY_SIZE == sizeof(scheduler_profiling_file_entry_t),
+               "length define of a scheduler profiling file entry is not the same size as the struct");
+_Static_assert(SCHEDULER_PROFILING_FILE_SIZE == sizeof(scheduler_profiling_file_t),
+               "length define of scheduler profiling file is not the same size as the struct");
+
+static scheduler_profiling_file_t profiling_file;
+static timer_tick_t reset_time;
+
+// inserts the task in the entries which are sorted on descending maximum run time, if it is one of the slowest tasks
+static void insert_entry(task_t task, const sched_task_stats_t* stats)
+{
+    int i = FRAMEWORK_SCHEDULER_PROFILING_FILE_ENTRIES;
+    while(i > 0 && (profiling_file.entries[i - 1].stats.invocations == 0
+                    || stats->max_run_time > profiling_file.entries[i - 1].stats.max_run_time))
+    {
+        if(i < FRAMEWORK_SCHEDULER_PROFILING_FILE_ENTRIES)
+            profiling_file.entries[i] = profiling_file.entries[i - 1];
+        i--;
+    }
+
+    if(i < FRAMEWORK_SCHEDULER_PROFILING_FILE_ENTRIES)
+    {
+        profiling_file.entries[i].task = (uint32_t)(uintptr_t)task;
+        profiling_file.entries[i].stats = *stats;
+    }
+}
+
+error_t scheduler_profiling_file_update()
+{
+    memset(profiling_file.bytes, 0, SCHEDULER_PROFILING_FILE_SIZE);
+    profiling_file.profiling_time = timer_calculate_difference(reset_time, timer_get_counter_value());
+
+    task_t task;
+    sched_task_stats_t stats;
+    for(sched_task_id_t id = 0; sched_get_task_stats(id, &task, &stats) == SUCCESS; id++)
+    {
+        if(stats.invocations > 0)
+            insert_entry(task, &stats);
+    }
+
+    // the modified callback is only meant for writes over ALP
+    return d7ap_fs_write_file_with_callback(SCHEDULER_PROFILING_FILE_ID, 0, profiling_file.bytes,
+        SCHEDULER_PROFILING_FILE_SIZE, ROOT_AUTH, false);
+}
+
+static void update_task(void* arg)
+{
+    scheduler_profiling_file_update();
+    timer_post_task_prio_delay(&update_task, UPDATE_PERIOD, MIN_PRIORITY);
+}
+
+static void file_modified_callback(uint8_t file_id)
+{
+    sched_reset_task_stats();
+    reset_time = timer_get_counter_value();
+    scheduler_profiling_file_update();
+}
+
+error_t scheduler_profiling_file_initialize()
+{
+    d7ap_fs_file_header_t file_header = { .file_permissions
+        = (file_permission_t) { .guest_read = true, .user_read = true, .user_write = true },
+        .file_properties.storage_class = FS_STORAGE_VOLATILE,
+        .length = SCHEDULER_PROFILING_FILE_SIZE,
+        .allocated_length = SCHEDULER_PROFILING_FILE_SIZE };
+
+    error_t ret = d7ap_fs_init_file(SCHEDULER_PROFILING_FILE_ID, &file_header, NULL);
+    if(ret != SUCCESS && ret != -EEXIST)
+    {
+        log_print_error_string("Error initialization of scheduler profiling file: %d", ret);
+        return ret;
+    }
+
+    d7ap_fs_register_file_modified_callback(SCHEDULER_PROFILING_FILE_ID, &file_modified_callback);
+    reset_time = timer_get_counter_value();
+    sched_register_task(&update_task);
+    update_task(NULL);
+    return SUCCESS;
+}
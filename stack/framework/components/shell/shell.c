@@ -38,6 +38,7 @@
 #include "hwsystem.h"
 #include "hwatomic.h"
 #include "debug.h"
+#include "fs.h"
 
 #include "console.h"
 
@@ -64,6 +65,7 @@ static void process_shell_cmd(char cmd)
             else     { console_print("echo is off\r\n"); }
             break;
         case 'R':
+            fs_flush(); // write back the cached permanent storage, which is lost by the reset
             hw_reset();
             break;
         default:
@@ -25,6 +25,7 @@
 #include "framework_defs.h"
 #include "log.h"
 #include "errors.h"
+#include <string.h>
 
 #if defined(FRAMEWORK_LOG_ENABLED) && defined(FRAMEWORK_TIMER_LOG_ENABLED)
   #define DPRINT(...) log_print_stack_string(LOG_STACK_FWK, __VA_ARGS__)
@@ -32,11 +33,6 @@
   #define DPRINT(...)
 #endif
 
-
-#ifdef NODE_GLOBALS
-    #warning Default Timer implementation used when NODE_GLOBALS is active. Are you sure this is what you want ??
-#endif
-
 #define HW_TIMER_ID 0
 
 #define COUNTER_OVERFLOW_INCREASE (UINT32_C(1) << (8*sizeof(hwtimer_tick_t)))
@@ -47,29 +43,241 @@ extern inline error_t timer_post_task_prio_delay(task_t task, timer_tick_t delay
 extern inline error_t timer_post_task_delay(task_t task, timer_tick_t delay);
 extern inline error_t timer_add_event(timer_event* event);
 
-static timer_event NGDEF(timers)[FRAMEWORK_TIMER_STACK_SIZE];
-static volatile timer_tick_t NGDEF(next_event);
-static volatile bool NGDEF(hw_event_scheduled);
-static volatile timer_tick_t NGDEF(timer_offset);
-static const hwtimer_info_t* timer_info;
-static bool timer_busy_programming = false;
-static bool fired_by_interrupt = true;
+_Static_assert(FRAMEWORK_TIMER_STACK_SIZE < UINT16_MAX, "FRAMEWORK_TIMER_STACK_SIZE can not be set larger than 65534");
+
 enum
 {
     NO_EVENT = FRAMEWORK_TIMER_STACK_SIZE,
+    NOT_IN_HEAP = FRAMEWORK_TIMER_STACK_SIZE,
+    // the buckets of the index on task, a power of two which is at least FRAMEWORK_TIMER_STACK_SIZE
+    NUM_BUCKETS = FRAMEWORK_TIMER_STACK_SIZE <= 16 ? 16 : FRAMEWORK_TIMER_STACK_SIZE <= 64 ? 64 :
+                  FRAMEWORK_TIMER_STACK_SIZE <= 256 ? 256 : FRAMEWORK_TIMER_STACK_SIZE <= 1024 ? 1024 : 4096,
 };
 
+typedef struct
+{
+    task_t f;
+    // an event fires somewhere between window_start and fire_time, which are absolute times on the timebase of
+    // timer_get_time64(). The window is only longer than a single tick for events posted with slack.
+    uint64_t window_start;
+    uint64_t fire_time;
+    void *arg;
+    timer_tick_t period;
+    timer_tick_t slack;
+    uint8_t priority;
+} event_t;
+
+typedef struct
+{
+    uint16_t slots[FRAMEWORK_TIMER_STACK_SIZE];
+    uint16_t pos[FRAMEWORK_TIMER_STACK_SIZE]; // the position of every slot in the heap, or NOT_IN_HEAP
+    uint16_t size;
+} heap_t;
+
+// the events are stored in NG(timers), a slot is free when its task is 0x0. An event is identified by its task and
+// argument, or by its handle: the slot index combined with the generation of the slot, which is incremented every time
+// the slot is freed so handles of events which already fired or were cancelled do not match a new event in the same slot.
+// The pending events are ordered on fire time in a binary min-heap of slot indices, which also holds the position
+// of every slot in the heap so an event can be removed or rescheduled without searching for it. The events with slack
+// are also ordered on the start of their window in a second heap, so the events which can be fired early when
+// the timer wakes up for another event are found without searching either. The events are also indexed on task,
+// by hashing the task into NG(buckets) and chaining the slots in the same bucket through NG(slot_next), so all
+// events of a task are in the same chain.
+// Free slots are chained through NG(slot_next) as well.
+static event_t NGDEF(timers)[FRAMEWORK_TIMER_STACK_SIZE];
+static heap_t NGDEF(fire_heap);
+static heap_t NGDEF(window_heap);
+static timer_stats_t NGDEF(stats);
+static uint16_t NGDEF(buckets)[NUM_BUCKETS];
+static uint16_t NGDEF(slot_next)[FRAMEWORK_TIMER_STACK_SIZE];
+static uint16_t NGDEF(generation)[FRAMEWORK_TIMER_STACK_SIZE];
+static uint16_t NGDEF(free_slots);
+static volatile uint16_t NGDEF(next_event);
+static volatile bool NGDEF(hw_event_scheduled);
+// the 64-bit time at which the hw timer last overflowed, only updated from the overflow interrupt
+static volatile uint64_t NGDEF(timer_offset);
+static const hwtimer_info_t* NGDEF(_timer_info);
+#define timer_info NG(_timer_info)
+static bool NGDEF(_timer_busy_programming);
+#define timer_busy_programming NG(_timer_busy_programming)
+static bool NGDEF(_fired_by_interrupt);
+#define fired_by_interrupt NG(_fired_by_interrupt)
+
 static void timer_overflow();
 static void timer_fired();
 
+static inline uint64_t heap_key(heap_t* heap, uint16_t slot)
+{
+    return heap == &NG(window_heap) ? NG(timers)[slot].window_start : NG(timers)[slot].fire_time;
+}
+
+static inline bool heap_less(heap_t* heap, uint16_t pos_a, uint16_t pos_b)
+{
+    return heap_key(heap, heap->slots[pos_a]) < heap_key(heap, heap->slots[pos_b]);
+}
+
+static void heap_swap(heap_t* heap, uint16_t pos_a, uint16_t pos_b)
+{
+    uint16_t slot = heap->slots[pos_a];
+    heap->slots[pos_a] = heap->slots[pos_b];
+    heap->slots[pos_b] = slot;
+    heap->pos[heap->slots[pos_a]] = pos_a;
+    heap->pos[heap->slots[pos_b]] = pos_b;
+}
+
+static void heap_sift_up(heap_t* heap, uint16_t pos)
+{
+    while(pos > 0 && heap_less(heap, pos, (pos - 1) / 2))
+    {
+        heap_swap(heap, pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+}
+
+static void heap_sift_down(heap_t* heap, uint16_t pos)
+{
+    while(true)
+    {
+        uint32_t smallest = pos;
+        uint32_t child = 2 * (uint32_t)pos + 1;
+        if(child < heap->size && heap_less(heap, child, smallest))
+            smallest = child;
+        if(child + 1 < heap->size && heap_less(heap, child + 1, smallest))
+            smallest = child + 1;
+        if(smallest == pos)
+            return;
+        heap_swap(heap, pos, smallest);
+        pos = smallest;
+    }
+}
+
+static void heap_init(heap_t* heap)
+{
+    heap->size = 0;
+    for(uint32_t i = 0; i < FRAMEWORK_TIMER_STACK_SIZE; i++)
+        heap->pos[i] = NOT_IN_HEAP;
+}
+
+static void heap_insert(heap_t* heap, uint16_t slot)
+{
+    heap->slots[heap->size] = slot;
+    heap->pos[slot] = heap->size;
+    heap->size++;
+    heap_sift_up(heap, heap->size - 1);
+}
+
+static void heap_remove(heap_t* heap, uint16_t slot)
+{
+    uint16_t pos = heap->pos[slot];
+    heap->size--;
+    if(pos != heap->size)
+    {
+        heap_swap(heap, pos, heap->size);
+        heap_sift_up(heap, pos);
+        heap_sift_down(heap, pos);
+    }
+    heap->pos[slot] = NOT_IN_HEAP;
+}
+
+// adds the event to the heaps or restores the heap order after its times changed
+static void schedule_event(uint16_t slot)
+{
+    if(NG(fire_heap).pos[slot] == NOT_IN_HEAP)
+        heap_insert(&NG(fire_heap), slot);
+    else
+    {
+        heap_sift_up(&NG(fire_heap), NG(fire_heap).pos[slot]);
+        heap_sift_down(&NG(fire_heap), NG(fire_heap).pos[slot]);
+    }
+
+    if(NG(window_heap).pos[slot] != NOT_IN_HEAP)
+        heap_remove(&NG(window_heap), slot);
+    if(NG(timers)[slot].window_start < NG(timers)[slot].fire_time)
+        heap_insert(&NG(window_heap), slot);
+}
+
+static inline uint16_t bucket_of(task_t task)
+{
+    return (((uint32_t)(uintptr_t)task * UINT32_C(2654435761)) >> 16) & (NUM_BUCKETS - 1);
+}
+
+// returns the first event of the task, or the event with the given task and argument when match_arg is set
+static uint16_t find_event(task_t task, bool match_arg, void *arg)
+{
+    uint16_t slot = NG(buckets)[bucket_of(task)];
+    while(slot != NO_EVENT && (NG(timers)[slot].f != task || (match_arg && NG(timers)[slot].arg != arg)))
+        slot = NG(slot_next)[slot];
+    return slot;
+}
+
+static inline timer_handle_t handle_of(uint16_t slot)
+{
+    return ((timer_handle_t)NG(generation)[slot] << 16) | slot;
+}
+
+// returns the slot of the event with the given handle, or NO_EVENT when the event is no longer pending
+static uint16_t find_handle(timer_handle_t handle)
+{
+    uint16_t slot = handle & 0xFFFF;
+    if(slot >= FRAMEWORK_TIMER_STACK_SIZE || NG(timers)[slot].f == 0x0 || handle_of(slot) != handle)
+        return NO_EVENT;
+    return slot;
+}
+
+// takes a free slot and adds it to the index, returns NO_EVENT when all slots are in use
+static uint16_t alloc_event(task_t task)
+{
+    uint16_t slot = NG(free_slots);
+    if(slot == NO_EVENT)
+        return NO_EVENT;
+
+    NG(free_slots) = NG(slot_next)[slot];
+    NG(timers)[slot].f = task;
+    uint16_t bucket = bucket_of(task);
+    NG(slot_next)[slot] = NG(buckets)[bucket];
+    NG(buckets)[bucket] = slot;
+    return slot;
+}
+
+// removes the event from the heap and the index and returns its slot to the free slots
+static void free_event(uint16_t slot)
+{
+    heap_remove(&NG(fire_heap), slot);
+    if(NG(window_heap).pos[slot] != NOT_IN_HEAP)
+        heap_remove(&NG(window_heap), slot);
+    uint16_t* link = &NG(buckets)[bucket_of(NG(timers)[slot].f)];
+    while(*link != slot)
+        link = &NG(slot_next)[*link];
+    *link = NG(slot_next)[slot];
+
+    NG(timers)[slot].f = 0x0;
+    // generation 0 is skipped, so a valid handle never equals TIMER_HANDLE_NONE
+    if(++NG(generation)[slot] == 0)
+        NG(generation)[slot] = 1;
+    NG(slot_next)[slot] = NG(free_slots);
+    NG(free_slots) = slot;
+}
+
 __LINK_C void timer_init()
 {
     for(uint32_t i = 0; i < FRAMEWORK_TIMER_STACK_SIZE; i++)
-	NG(timers)[i].f = 0x0;
+    {
+        NG(timers)[i].f = 0x0;
+        NG(slot_next)[i] = i + 1; // the last slot links to NO_EVENT
+        NG(generation)[i] = 1;
+    }
+    NG(free_slots) = 0;
+    heap_init(&NG(fire_heap));
+    heap_init(&NG(window_heap));
+    memset(&NG(stats), 0, sizeof(NG(stats)));
+    for(uint32_t i = 0; i < NUM_BUCKETS; i++)
+        NG(buckets)[i] = NO_EVENT;
 
     NG(next_event) = NO_EVENT;
     NG(timer_offset) = 0;
     NG(hw_event_scheduled) = false;
+    timer_busy_programming = false;
+    fired_by_interrupt = true;
 
     error_t err = hw_timer_init(HW_TIMER_ID, TIMER_RESOLUTION, &timer_fired, &timer_overflow);
     assert(err == SUCCESS);
@@ -83,13 +291,29 @@ error_t timer_init_event(timer_event* event, task_t callback)
     event->arg = NULL;
     event->priority = MAX_PRIORITY;
     event->period = 0;
+    event->slack = 0;
+    event->handle = TIMER_HANDLE_NONE;
     return (sched_register_task(callback)); // register the function callback to be called at the end of the timeout
 }
 
+// converts a 32-bit fire time, which is interpreted in a circular fashion wrt. the current time, to the 64-bit timebase
+static uint64_t to_time64(timer_tick_t time)
+{
+    uint64_t now = timer_get_time64();
+    int32_t diff = (int32_t)(time - (timer_tick_t)now);
+    // a fire time in the past which lies before the 64-bit time started is due as well, don't let it wrap around
+    if(diff < 0 && (uint64_t)(-(int64_t)diff) > now)
+        return 0;
+    return now + diff;
+}
+
 static bool configure_next_event();
-__LINK_C error_t timer_post_task_prio(task_t task, timer_tick_t fire_time, uint8_t priority, timer_tick_t period, void *arg)
+__LINK_C error_t timer_post_task_prio_handle(task_t task, timer_tick_t fire_time, uint8_t priority, timer_tick_t period,
+                                             timer_tick_t slack, void *arg, timer_handle_t *handle)
 {
     error_t status = ENOMEM;
+    if (handle)
+        *handle = TIMER_HANDLE_NONE;
     if (priority > MIN_PRIORITY)
         return EINVAL;
 
@@ -103,65 +327,46 @@ __LINK_C error_t timer_post_task_prio(task_t task, timer_tick_t fire_time, uint8
 
     bool conf_atomic_ended = false;
     start_atomic();
-    uint32_t empty_index = FRAMEWORK_TIMER_STACK_SIZE;
-    for (uint32_t i = 0; i < FRAMEWORK_TIMER_STACK_SIZE; i++)
+    uint16_t old_next_event = NG(next_event);
+    uint16_t index = find_event(task, true, arg);
+    if (index != NO_EVENT)
     {
-        if (NG(timers)[i].f == 0x0 && empty_index == FRAMEWORK_TIMER_STACK_SIZE)
-        {
-            empty_index = i;
-        }
-        else if (NG(timers)[i].f == task)
+        // it is allowed to update only the fire time
+        if (NG(timers)[index].priority == priority)
         {
-            // it is allowed to update only the fire time
-            if (NG(timers)[i].priority == priority)
-            {
-                NG(timers)[i].period = period;
-                NG(timers)[i].next_event = fire_time;
-                empty_index = i;
-                goto config;
-            }
-            else
-            //for now: do not allow an event to be scheduled more than once
-            //otherwise we risk having the same task being scheduled twice and only executed once
-            //because the scheduler disallows the same task to be scheduled multiple times
-                status = EALREADY;
-            break;
+            NG(timers)[index].period = period;
+            NG(timers)[index].slack = slack;
+            NG(timers)[index].window_start = to_time64(fire_time);
+            NG(timers)[index].fire_time = NG(timers)[index].window_start + slack;
+            schedule_event(index);
+            goto config;
         }
+        //for now: do not allow an event to be scheduled more than once
+        //otherwise we risk having the same task being scheduled twice and only executed once
+        //because the scheduler disallows the same task to be scheduled multiple times with the same argument
+        status = EALREADY;
+        goto end;
     }
 
-    if (status != EALREADY && empty_index != FRAMEWORK_TIMER_STACK_SIZE)
-    {
-        NG(timers)[empty_index].f = task;
-        NG(timers)[empty_index].next_event = fire_time;
-        NG(timers)[empty_index].priority = priority;
-        NG(timers)[empty_index].arg = arg;
-        NG(timers)[empty_index].period = period;
-    }
-    else
+    index = alloc_event(task);
+    if (index == NO_EVENT)
         goto end;
 
+    NG(timers)[index].window_start = to_time64(fire_time);
+    NG(timers)[index].fire_time = NG(timers)[index].window_start + slack;
+    NG(timers)[index].priority = priority;
+    NG(timers)[index].arg = arg;
+    NG(timers)[index].period = period;
+    NG(timers)[index].slack = slack;
+    schedule_event(index);
+
 config:
 
-    //if there is no event scheduled, this event will run before the next scheduled event
+    //reconfigure when this event is the first to fire now, or when it was the first one before it was updated
     {
-        bool do_config = NG(next_event) == NO_EVENT;
-
-        if (!do_config)
-        {
-            uint32_t counter = timer_get_counter_value();
-
-            DPRINT("timer_post_task_prio counter value <%lu>" , counter);
-
-            //if the new event should fire sooner than the old event --> trigger reconfig
-            //this is done using signed ints (compared to the current counter)
-            //to ensure propper handling of timer overflows
-            int32_t next_fire_delay = ((int32_t)fire_time) - ((int32_t)counter);
-
-            DPRINT("next_fire_delay <%lu>" , next_fire_delay);
-
-            int32_t old_fire_delay = ((int32_t)NG(timers)[NG(next_event)].next_event) - ((int32_t)counter);
-            do_config = (next_fire_delay <= old_fire_delay) || NG(next_event) == empty_index; //when same index is overwritten, also update
-        }
+        bool do_config = NG(fire_heap).slots[0] == index || old_next_event == index;
+        if (handle)
+            *handle = handle_of(index);
 
         if (do_config) {
             conf_atomic_ended = configure_next_event();
@@ -179,117 +384,142 @@ end:
     return status;
 }
 
-__LINK_C error_t timer_cancel_task(task_t task)
+__LINK_C error_t timer_post_task_prio(task_t task, timer_tick_t fire_time, uint8_t priority, timer_tick_t period, timer_tick_t slack, void *arg)
+{
+    return timer_post_task_prio_handle(task, fire_time, priority, period, slack, arg, NULL);
+}
+
+// cancels the events of the task (with the given argument when match_arg is set), or the event with the given handle
+// when task is 0x0
+static error_t cancel_events(task_t task, bool match_arg, void *arg, timer_handle_t handle)
 {
     error_t status = EALREADY;
-    
-    bool conf_atomic_ended = false;
+    bool reconfigure = false;
 
     start_atomic();
 
-    for(uint32_t i = 0; i < FRAMEWORK_TIMER_STACK_SIZE; i++)
+    uint16_t index = task ? find_event(task, match_arg, arg) : find_handle(handle);
+    while(index != NO_EVENT)
     {
-      if(NG(timers)[i].f == task)
-      {
-        NG(timers)[i].f = 0x0;
+        free_event(index);
         //if we were the first event to fire --> trigger a reconfiguration
-        if(NG(next_event) == i) {
-            conf_atomic_ended = configure_next_event();
-        }
-          
+        if(NG(next_event) == index)
+            reconfigure = true;
 
         status = SUCCESS;
-        break;
-      }
+        index = task ? find_event(task, match_arg, arg) : NO_EVENT;
     }
+
+    bool conf_atomic_ended = false;
+    if(reconfigure)
+        conf_atomic_ended = configure_next_event();
     if(!conf_atomic_ended) { //if configure_next_event gets run, then atomic is ended in there. Otherwise we should end it here.
         end_atomic(); 
     }
-    
 
     return status;
 }
 
+__LINK_C error_t timer_cancel_task(task_t task)
+{
+    return cancel_events(task, false, NULL, TIMER_HANDLE_NONE);
+}
+
+__LINK_C error_t timer_cancel_task_with_arg(task_t task, void *arg)
+{
+    return cancel_events(task, true, arg, TIMER_HANDLE_NONE);
+}
+
+__LINK_C error_t timer_cancel_handle(timer_handle_t handle)
+{
+    return cancel_events(0x0, false, NULL, handle);
+}
+
 error_t timer_add_event(timer_event* event)
 {
-    return timer_post_task_prio(event->f, timer_get_counter_value() + event->next_event, event->priority, event->period, event->arg);
+    return timer_post_task_prio_handle(event->f, timer_get_counter_value() + event->next_event, event->priority,
+                                       event->period, event->slack, event->arg, &event->handle);
 }
 
 void timer_cancel_event(timer_event* event)
 {
-    timer_cancel_task(event->f);
-    sched_cancel_task(event->f);
+    // an event without handle was not posted through timer_add_event(), cancel it on its task
+    if(event->handle != TIMER_HANDLE_NONE)
+        timer_cancel_handle(event->handle);
+    else
+        timer_cancel_task(event->f);
+    event->handle = TIMER_HANDLE_NONE;
+    sched_cancel_task_with_arg(event->f, event->arg);
 }
 
 __LINK_C bool timer_is_task_scheduled(task_t task)
 {
-    bool present = false;
-
     start_atomic();
-
-     for (uint32_t i = 0; i < FRAMEWORK_TIMER_STACK_SIZE; i++)
-     {
-       if (NG(timers)[i].f == task)
-       {
-          present = true;
-          break;
-       }
-     }
-     end_atomic();
+    bool present = find_event(task, false, NULL) != NO_EVENT;
+    end_atomic();
 
      return present;
 }
 
-__LINK_C timer_tick_t timer_get_counter_value()
+__LINK_C bool timer_is_handle_scheduled(timer_handle_t handle)
 {
-	timer_tick_t counter;
     start_atomic();
-    timer_tick_t hw_timer_value = hw_timer_getvalue(HW_TIMER_ID);
-	counter = NG(timer_offset) + hw_timer_value;
-	//increase the counter with COUNTER_OVERFLOW_INCREASE
-	//if an overflow is pending. (This is to compensate for the 
-	//fact that NG(timer_offset) is not updated until the overflow
-	//interrupt is actually fired
-    //the overflow can occur between reading out the timer here above
-    //and checking the overflow pending bit. If this occurs, hw_timer_value
-    //contains the max value before overflow and we will add COUNTER_OVERFLOW_INCREASE
-    //bellow as well which mean that the returned time is off by COUNTER_OVERFLOW_INCREASE.
-    //So only add COUNTER_OVERFLOW_INCREASE if hw_timer_value is not to large.
-	if(hw_timer_is_overflow_pending(HW_TIMER_ID) && (hw_timer_value < (COUNTER_OVERFLOW_INCREASE - 10)))
-	    counter += COUNTER_OVERFLOW_INCREASE;
+    bool present = find_handle(handle) != NO_EVENT;
     end_atomic();
-    return counter;
+
+    return present;
 }
 
-static uint32_t get_next_event()
+__LINK_C void timer_get_stats(timer_stats_t* stats)
 {
-    //this function should only be called from an atomic context
-    int32_t min_delay;
-    uint32_t next_fire_event = NO_EVENT;
-    uint32_t counter = timer_get_counter_value();
+    start_atomic();
+    *stats = NG(stats);
+    end_atomic();
+}
 
-    for(uint32_t i = 0; i < FRAMEWORK_TIMER_STACK_SIZE; i++)
+__LINK_C bool timer_get_next_event_time(timer_tick_t* fire_time)
+{
+    bool present = false;
+
+    start_atomic();
+    if(NG(next_event) != NO_EVENT)
     {
-    	if(NG(timers)[i].f == 0x0)
-    		continue;
-    	//trick borrowed from AODV: by using signed integers in this way
-    	//we know that if the event has already passed delay_ticks will be < 0
-    	// --> events are sorted from past -> future regardless of any (pending) overflows
-    	int32_t delay_ticks = ((int32_t)NG(timers)[i].next_event) - ((int32_t)counter);
-    	if(next_fire_event == NO_EVENT || delay_ticks < min_delay)
-		{
-    		min_delay = delay_ticks;
-			next_fire_event = i;
-		}
+        *fire_time = (timer_tick_t)NG(timers)[NG(next_event)].fire_time;
+        present = true;
     }
-    return next_fire_event;
+    end_atomic();
+
+    return present;
+}
+
+__LINK_C uint64_t timer_get_time64()
+{
+    start_atomic();
+    uint64_t time = NG(timer_offset) + hw_timer_getvalue(HW_TIMER_ID);
+    //NG(timer_offset) is not updated until the overflow interrupt is actually fired. When an overflow is pending the
+    //hw timer might have overflowed before or after it was read, so read it again: now it has overflowed for sure.
+    if(hw_timer_is_overflow_pending(HW_TIMER_ID))
+        time = NG(timer_offset) + COUNTER_OVERFLOW_INCREASE + hw_timer_getvalue(HW_TIMER_ID);
+    end_atomic();
+    return time;
+}
+
+__LINK_C timer_tick_t timer_get_counter_value()
+{
+    return (timer_tick_t)timer_get_time64();
+}
+
+static inline uint16_t get_next_event()
+{
+    //this function should only be called from an atomic context
+    return NG(fire_heap).size > 0 ? NG(fire_heap).slots[0] : NO_EVENT;
 }
 
 static bool configure_next_event()
 {
     //this function should only be called from an atomic context
-	timer_tick_t next_fire_time;
-    timer_tick_t current_time = timer_get_counter_value();
+	uint64_t next_fire_time;
+    uint64_t current_time = timer_get_time64();
 
     timer_busy_programming = true;
 
@@ -301,8 +531,8 @@ static bool configure_next_event()
 
 		if(NG(next_event) != NO_EVENT)
 		{
-			next_fire_time = NG(timers)[NG(next_event)].next_event;
-      if ( (((int32_t)next_fire_time) - ((int32_t)current_time) - timer_info->min_delay_ticks) <= 0 )
+			next_fire_time = NG(timers)[NG(next_event)].fire_time;
+			if (next_fire_time <= current_time + timer_info->min_delay_ticks)
 			{
                 DPRINT("will be late, sched immediately\n\n");
                 if(NG(timers)[NG(next_event)].f == 0)
@@ -314,7 +544,7 @@ static bool configure_next_event()
 			}
 		}
     }
-    while(NG(next_event) != NO_EVENT && ( (((int32_t)next_fire_time) - ((int32_t)current_time)  - timer_info->min_delay_ticks) <= 0  ) );
+    while(NG(next_event) != NO_EVENT && next_fire_time <= current_time + timer_info->min_delay_ticks);
 
     // if recursive event was scheduled immediately, don't set hw timer delay until last time in configure next event
     if(!fired_by_interrupt)
@@ -335,7 +565,7 @@ static bool configure_next_event()
 		//latest overflow time, to counteract any delays in updating counter_offset
 		//(eg when we're scheduling an event from an interrupt and thereby delaying
 		//the updating of counter_offset)
-      timer_tick_t fire_delay = (next_fire_time - current_time);
+		uint64_t fire_delay = (next_fire_time - current_time);
 		//if the timer should fire in less ticks than supported by the HW timer --> schedule it
 		//(otherwise it is scheduled from timer_overflow when needed)
 		if((fire_delay + hw_timer_getvalue(HW_TIMER_ID)) < COUNTER_OVERFLOW_INCREASE)
@@ -344,14 +574,6 @@ static bool configure_next_event()
             end_atomic(); //stop atomic when scheduling a new timer because this needs to wait for a interrupt before writing
             called_atomic = true;
 			hw_timer_schedule_delay(HW_TIMER_ID, (hwtimer_tick_t)fire_delay);
-#ifndef NDEBUG	    
-			//check that we didn't try to schedule a timer in the past
-			//normally this shouldn't happen but it IS theoretically possible...
-      fire_delay = (next_fire_time - current_time - timer_info->min_delay_ticks);
-			//fire_delay should be in [0,COUNTER_OVERFLOW_INCREASE]. if this is not the case, it is because timer_get_counter() is
-			//now larger than next_fire_event, which means we 'missed' the event
-			assert(((int32_t)fire_delay) > 0);
-#endif
 		}
 		else
 		{
@@ -385,12 +607,12 @@ static void timer_overflow()
     NG(timer_offset) += COUNTER_OVERFLOW_INCREASE;
     if(NG(next_event) != NO_EVENT && 		//there is an event scheduled at THIS timer level
 	(!NG(hw_event_scheduled)) &&		//but NOT at the hw timer level
-		NG(timers)[NG(next_event)].next_event <= (NG(timer_offset) + COUNTER_OVERFLOW_INCREASE) //and the next trigger will happen before the next overflow
+		NG(timers)[NG(next_event)].fire_time < (NG(timer_offset) + COUNTER_OVERFLOW_INCREASE) //and the next trigger will happen before the next overflow
 	)
     {
 		//normally this shouldn't happen. Put an assert here just to make sure
-		assert(NG(timers)[NG(next_event)].next_event >= NG(timer_offset));
-		timer_tick_t fire_time = (NG(timers)[NG(next_event)].next_event - NG(timer_offset));
+		assert(NG(timers)[NG(next_event)].fire_time >= NG(timer_offset));
+		hwtimer_tick_t fire_time = (hwtimer_tick_t)(NG(timers)[NG(next_event)].fire_time - NG(timer_offset));
 
 		//fire time already passed
 		if(fire_time <= (hw_timer_getvalue(HW_TIMER_ID) + timer_info->min_delay_ticks))
@@ -407,34 +629,65 @@ static void timer_overflow()
     }
 }
 
+// posts the task of the event and reschedules or frees the event
+static void fire_event(uint16_t index, uint64_t current_time)
+{
+    event_t* event = &NG(timers)[index];
+    // check if the current task is the watchdog bump task and if we're not nearly reaching the reset
+    timer_tick_t repost_time_diff = sched_check_software_watchdog(event->f, (timer_tick_t)current_time);
+
+    sched_post_task_prio(event->f, event->priority, event->arg);
+    NG(stats).events_fired++;
+
+    if(repost_time_diff)
+    {
+        // the watchdog has to be fed before repost_time_diff at the latest, this determines the end of the window
+        event->fire_time = current_time + repost_time_diff;
+        event->window_start = event->fire_time - event->slack;
+        if(event->window_start <= current_time)
+            event->window_start = current_time + 1;
+        schedule_event(index);
+    }
+    else if(event->period > 0)
+    {
+        event->window_start = current_time + event->period;
+        event->fire_time = event->window_start + event->slack;
+        schedule_event(index);
+    }
+    else
+        free_event(index);
+}
+
 static void timer_fired()
 {
     if(timer_busy_programming && fired_by_interrupt)
         return;
     assert(NG(next_event) != NO_EVENT);
     assert(NG(timers)[NG(next_event)].f != 0x0);
-    timer_tick_t current_time = timer_get_counter_value();
+    uint64_t current_time = timer_get_time64();
 #ifdef FRAMEWORK_LOG_ENABLED
     // if event got fired to early, show error logging
-    if((current_time + timer_info->min_delay_ticks) < NG(timers)[NG(next_event)].next_event)
+    if((current_time + timer_info->min_delay_ticks) < NG(timers)[NG(next_event)].fire_time)
         log_print_error_string("timer fired too early with current time %i + min delay ticks %i < next event %i: function 0x%X",
-            current_time, timer_info->min_delay_ticks, NG(timers)[NG(next_event)].next_event, NG(timers)[NG(next_event)].f);
-    else if(current_time > (NG(timers)[NG(next_event)].next_event + 5))
+            (timer_tick_t)current_time, timer_info->min_delay_ticks, (timer_tick_t)NG(timers)[NG(next_event)].fire_time, NG(timers)[NG(next_event)].f);
+    else if(current_time > (NG(timers)[NG(next_event)].fire_time + 5))
         log_print_error_string("timer fired too late with current time %i > next event %i + 5: function 0x%X",
-            current_time, timer_info->min_delay_ticks, NG(timers)[NG(next_event)].next_event, NG(timers)[NG(next_event)].f);
+            (timer_tick_t)current_time, (timer_tick_t)NG(timers)[NG(next_event)].fire_time, NG(timers)[NG(next_event)].f);
 #endif
-    // check if the current task is the watchdog bump task and if we're not nearly reaching the reset
-    timer_tick_t repost_time_diff = sched_check_software_watchdog(NG(timers)[NG(next_event)].f, current_time);
+    if(fired_by_interrupt)
+        NG(stats).wakeups++;
 
-    sched_post_task_prio(
-        NG(timers)[NG(next_event)].f, NG(timers)[NG(next_event)].priority, NG(timers)[NG(next_event)].arg);
+    fire_event(NG(next_event), current_time);
 
-    if(repost_time_diff)
-        NG(timers)[NG(next_event)].next_event = current_time + repost_time_diff;
-    else if(NG(timers)[NG(next_event)].period > 0)
-        NG(timers)[NG(next_event)].next_event = current_time + NG(timers)[NG(next_event)].period;
-    else
-        NG(timers)[NG(next_event)].f = 0x0;
+    // fire the events whose window has already started in the same wakeup
+    while(NG(window_heap).size > 0 && NG(timers)[NG(window_heap).slots[0]].window_start <= current_time)
+    {
+        uint16_t index = NG(window_heap).slots[0];
+        // events which are due anyway are fired by configure_next_event() as late events, without a wakeup
+        if(NG(timers)[index].fire_time > current_time + timer_info->min_delay_ticks)
+            NG(stats).wakeups_saved++;
+        fire_event(index, current_time);
+    }
 
     if(fired_by_interrupt)
         configure_next_event();
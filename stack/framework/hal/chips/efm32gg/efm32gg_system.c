@@ -61,6 +61,20 @@ void hw_enter_lowpower_mode(uint8_t mode)
     }
 }
 
+uint32_t hw_get_lowpower_mode_wakeup_latency(uint8_t mode)
+{
+    switch(mode)
+    {
+	case 0: // EM1
+	    return 0;
+	case 1: // EM2
+	case 2: // EM3
+	    return 10; // the HF oscillator is restarted on wakeup
+	default: // EM4 resets the MCU
+	    return HW_LOWPOWER_MODE_UNAVAILABLE;
+    }
+}
+
 uint64_t hw_get_unique_id()
 {
     return SYSTEM_GetUnique();
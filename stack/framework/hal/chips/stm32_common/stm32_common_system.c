@@ -208,6 +208,20 @@ void hw_enter_lowpower_mode(uint8_t mode)
   DPRINT("wake up @ %i", hw_timer_getvalue(0) );
 }
 
+uint32_t hw_get_lowpower_mode_wakeup_latency(uint8_t mode)
+{
+  switch (mode)
+  {
+    case 0: // sleep mode
+    case 255:
+      return 0;
+    case 1: // STOP mode, dominated by restoring the clock configuration in stm32_common_mcu_init()
+      return 1000;
+    default: // STANDBY mode resets the MCU
+      return HW_LOWPOWER_MODE_UNAVAILABLE;
+  }
+}
+
 uint64_t hw_get_unique_id()
 {
     // note we are ignoring WAF_NUM and LOT_NUM[55:32] to reduce the 96 bits UID to 64 bits
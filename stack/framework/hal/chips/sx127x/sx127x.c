@@ -190,6 +190,7 @@ static release_packet_callback_t release_packet_callback;
 static rx_packet_callback_t rx_packet_callback;
 static tx_packet_callback_t tx_packet_callback;
 static rx_packet_header_callback_t rx_packet_header_callback;
+static rx_packet_data_callback_t rx_packet_data_callback;
 static tx_refill_callback_t tx_refill_callback;
 
 static tx_lora_packet_callback_t tx_lora_packet_callback;
@@ -213,6 +214,13 @@ static bool io_inited = false;
 
 static bool lora_mode = false;
 
+// handles of the tasks which are posted from the DIO interrupts
+static sched_task_id_t bg_scan_rx_done_id;
+static sched_task_id_t lora_rxdone_isr_id;
+static sched_task_id_t lora_rxtimeout_isr_id;
+static sched_task_id_t packet_transmitted_isr_id;
+static sched_task_id_t fifo_threshold_isr_id;
+
 static uint32_t current_center_freq = 0;
 static bool rx_type_continuous = true; //if true, use RXCONT, if false use RX_SINGLE
 
@@ -571,11 +579,11 @@ static void dio0_isr(void *arg) {
 
   if(state == STATE_RX) {
     if(lora_mode)
-      sched_post_task(&lora_rxdone_isr);
+      sched_post_task_id_from_isr(lora_rxdone_isr_id, DEFAULT_PRIORITY, NULL);
     else
-      sched_post_task(&bg_scan_rx_done);
+      sched_post_task_id_from_isr(bg_scan_rx_done_id, DEFAULT_PRIORITY, NULL);
   } else {
-    sched_post_task(&packet_transmitted_isr);
+    sched_post_task_id_from_isr(packet_transmitted_isr_id, DEFAULT_PRIORITY, NULL);
   }
 }
 
@@ -733,6 +741,10 @@ static void fifo_threshold_isr() {
    hw_gpio_enable_interrupt(SX127x_DIO1_PIN);
    
    DPRINT("read %i bytes, %i remaining, FLAGS2 %x, time: %i \n", FskPacketHandler_sx127x.NbBytes, remaining_bytes, read_reg(REG_IRQFLAGS2), timer_get_counter_value());
+
+   // let the upper layer process the received bytes while the FIFO fills up again
+   if(rx_packet_data_callback)
+     rx_packet_data_callback(current_packet, FskPacketHandler_sx127x.NbBytes);
 }
 
 static void dio1_isr(void *arg) {
@@ -741,9 +753,9 @@ static void dio1_isr(void *arg) {
 
   if(state == STATE_RX) {
     if(lora_mode && rx_lora_timeout_callback) {
-      sched_post_task(&lora_rxtimeout_isr);
+      sched_post_task_id_from_isr(lora_rxtimeout_isr_id, DEFAULT_PRIORITY, NULL);
     } else {
-      sched_post_task(&fifo_threshold_isr);
+      sched_post_task_id_from_isr(fifo_threshold_isr_id, DEFAULT_PRIORITY, NULL);
     }
   } else {
       fifo_level_irq_triggered = true;
@@ -786,6 +798,7 @@ error_t hw_radio_init(hwradio_init_args_t* init_args) {
   release_packet_callback = init_args->release_packet_cb;
   rx_packet_callback = init_args->rx_packet_cb;
   rx_packet_header_callback = init_args->rx_packet_header_cb;
+  rx_packet_data_callback = init_args->rx_packet_data_cb;
   tx_packet_callback = init_args->tx_packet_cb;
   tx_refill_callback = init_args->tx_refill_cb;
 
@@ -838,6 +851,11 @@ error_t hw_radio_init(hwradio_init_args_t* init_args) {
   sched_register_task(&packet_transmitted_isr);
   sched_register_task(&fifo_threshold_isr);
   sched_register_task(&wait_for_fifo_level_isr);
+  bg_scan_rx_done_id = sched_get_task_id(&bg_scan_rx_done);
+  lora_rxdone_isr_id = sched_get_task_id(&lora_rxdone_isr);
+  lora_rxtimeout_isr_id = sched_get_task_id(&lora_rxtimeout_isr);
+  packet_transmitted_isr_id = sched_get_task_id(&packet_transmitted_isr);
+  fifo_threshold_isr_id = sched_get_task_id(&fifo_threshold_isr);
 
   return SUCCESS; // TODO FAIL return code
 }
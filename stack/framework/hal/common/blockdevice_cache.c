@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This is a write-back page cache on top of another blockdevice, see blockdevice_cache.h
+
+#include "blockdevice_cache.h"
+#include "debug.h"
+#include "log.h"
+#include "string.h"
+#include "framework_defs.h"
+
+
+#if defined(FRAMEWORK_LOG_ENABLED) && defined(HAL_PERIPH_LOG_ENABLED)
+#define DPRINT(...) log_print_stack_string(LOG_STACK_ALP, __VA_ARGS__)
+#else
+#define DPRINT(...)
+#endif
+
+// forward declare driver function pointers
+static error_t init(blockdevice_t* bd);
+static error_t read(blockdevice_t* bd, uint8_t* data, uint32_t addr, uint32_t size);
+static error_t program(blockdevice_t* bd, const uint8_t* data, uint32_t addr, uint32_t size);
+static error_t flush(blockdevice_t* bd);
+static error_t erase_chip(blockdevice_t* bd);
+static error_t erase_block32k(blockdevice_t* bd, uint32_t addr);
+static error_t erase_sector4k(blockdevice_t* bd, uint32_t addr);
+
+blockdevice_driver_t blockdevice_driver_cache = {
+    .init = init,
+    .read = read,
+    .program = program,
+    .flush = flush,
+    .erase_chip = erase_chip,
+    .erase_block32k = erase_block32k,
+    .erase_sector4k = erase_sector4k,
+    .erase_block_size = 0,          //erases are passed to the backing blockdevice
+    .write_block_size = UINT32_MAX  //the pages are split in write blocks when they are written back
+};
+
+
+static inline uint8_t* get_page_data(blockdevice_cache_t* cache, uint8_t index)
+{
+  return cache->buffer + index * cache->page_size;
+}
+
+// the last page of the blockdevice can be partial
+static inline uint32_t get_page_length(blockdevice_cache_t* cache, uint32_t page_addr)
+{
+  uint32_t remaining = cache->base.size - page_addr;
+  return remaining < cache->page_size ? remaining : cache->page_size;
+}
+
+static inline void touch_page(blockdevice_cache_t* cache, uint8_t index)
+{
+  cache->pages[index].last_used = ++cache->access_counter;
+}
+
+static int find_page(blockdevice_cache_t* cache, uint32_t page_addr)
+{
+  for(uint8_t i = 0; i < cache->page_count; i++)
+  {
+    if(cache->pages[i].addr == page_addr)
+      return i;
+  }
+
+  return -1;
+}
+
+static error_t write_back_page(blockdevice_cache_t* cache, uint8_t index)
+{
+  blockdevice_cache_page_t* page = &cache->pages[index];
+  if(!page->dirty)
+    return SUCCESS;
+
+  uint32_t write_block_size = cache->backing->driver->write_block_size;
+  uint32_t current_address = page->addr;
+  uint32_t remaining_length = get_page_length(cache, page->addr);
+  const uint8_t* current_data = get_page_data(cache, index);
+  DPRINT("BD CACHE write back %i @ %x", remaining_length, current_address);
+  while(remaining_length > 0)
+  {
+    // do not cross the write blocks of the backing blockdevice, the same way as fs_write_file()
+    uint32_t bytes_until_end_of_block = write_block_size - ((current_address + cache->backing->offset) % write_block_size);
+    uint32_t bytes_to_program = remaining_length > bytes_until_end_of_block ? bytes_until_end_of_block : remaining_length;
+    error_t err = blockdevice_program(cache->backing, current_data, current_address, bytes_to_program);
+    if(err != SUCCESS)
+      return err;
+
+    cache->stats.programs++;
+    remaining_length -= bytes_to_program;
+    current_data += bytes_to_program;
+    current_address += bytes_to_program;
+  }
+
+  page->dirty = false;
+  return SUCCESS;
+}
+
+// returns the page caching page_addr, when it is not cached yet the least recently used page is reused. The new page
+// is read from the backing blockdevice, unless it is going to be overwritten completely.
+static error_t get_page(blockdevice_cache_t* cache, uint32_t page_addr, bool fill, uint8_t* index)
+{
+  int found = find_page(cache, page_addr);
+  if(found >= 0)
+  {
+    cache->stats.hits++;
+    *index = found;
+    return SUCCESS;
+  }
+
+  cache->stats.misses++;
+  uint8_t victim = 0;
+  for(uint8_t i = 0; i < cache->page_count; i++)
+  {
+    if(cache->pages[i].addr == BLOCKDEVICE_CACHE_PAGE_UNUSED)
+    {
+      victim = i;
+      break;
+    }
+
+    if((int32_t)(cache->pages[i].last_used - cache->pages[victim].last_used) < 0)
+      victim = i;
+  }
+
+  error_t err = write_back_page(cache, victim);
+  if(err != SUCCESS)
+    return err;
+
+  cache->pages[victim].addr = BLOCKDEVICE_CACHE_PAGE_UNUSED;
+  if(fill)
+  {
+    cache->stats.reads++;
+    err = blockdevice_read(cache->backing, get_page_data(cache, victim), page_addr, get_page_length(cache, page_addr));
+    if(err != SUCCESS)
+      return err;
+  }
+
+  cache->pages[victim].addr = page_addr;
+  *index = victim;
+  return SUCCESS;
+}
+
+// drops the cached pages in the given range, pages which are only partly in the range are written back first
+static error_t invalidate(blockdevice_cache_t* cache, uint32_t addr, uint32_t size)
+{
+  for(uint8_t i = 0; i < cache->page_count; i++)
+  {
+    blockdevice_cache_page_t* page = &cache->pages[i];
+    if(page->addr == BLOCKDEVICE_CACHE_PAGE_UNUSED || page->addr >= addr + size
+       || page->addr + cache->page_size <= addr)
+      continue;
+
+    if(page->addr < addr || page->addr + cache->page_size > addr + size)
+    {
+      error_t err = write_back_page(cache, i);
+      if(err != SUCCESS)
+        return err;
+    }
+
+    page->addr = BLOCKDEVICE_CACHE_PAGE_UNUSED;
+    page->dirty = false;
+  }
+
+  return SUCCESS;
+}
+
+static error_t init(blockdevice_t* bd) {
+  blockdevice_cache_t* cache = (blockdevice_cache_t*)bd;
+  assert(cache->backing && cache->buffer && cache->pages && cache->page_size > 0 && cache->page_count > 0);
+  DPRINT("init cache of %i pages of %i bytes\n", cache->page_count, cache->page_size);
+
+  cache->base.size = cache->backing->size;
+  cache->base.offset = cache->backing->offset;
+  for(uint8_t i = 0; i < cache->page_count; i++)
+  {
+    cache->pages[i].addr = BLOCKDEVICE_CACHE_PAGE_UNUSED;
+    cache->pages[i].last_used = 0;
+    cache->pages[i].dirty = false;
+  }
+
+  cache->access_counter = 0;
+  memset(&cache->stats, 0, sizeof(cache->stats));
+  return SUCCESS;
+}
+
+static error_t read(blockdevice_t* bd, uint8_t* data, uint32_t addr, uint32_t size) {
+  blockdevice_cache_t* cache = (blockdevice_cache_t*)bd;
+  DPRINT("BD CACHE READ %i @ %x\n", size, addr);
+
+  if(size == 0) return SUCCESS;
+  if(addr + size > cache->base.size) return -ESIZE;
+
+  // consecutive pages which are not cached are read from the backing blockdevice at once
+  uint32_t uncached_addr = addr;
+  uint32_t uncached_length = 0;
+  uint8_t* uncached_data = data;
+  while(size > 0)
+  {
+    uint32_t page_offset = addr % cache->page_size;
+    uint32_t bytes = cache->page_size - page_offset;
+    if(bytes > size)
+      bytes = size;
+
+    int index = find_page(cache, addr - page_offset);
+    if(index >= 0)
+    {
+      cache->stats.hits++;
+      if(uncached_length > 0)
+      {
+        cache->stats.reads++;
+        error_t err = blockdevice_read(cache->backing, uncached_data, uncached_addr, uncached_length);
+        if(err != SUCCESS)
+          return err;
+
+        uncached_length = 0;
+      }
+
+      memcpy(data, get_page_data(cache, index) + page_offset, bytes);
+      touch_page(cache, index);
+    }
+    else
+    {
+      cache->stats.misses++;
+      if(uncached_length == 0)
+      {
+        uncached_addr = addr;
+        uncached_data = data;
+      }
+
+      uncached_length += bytes;
+    }
+
+    addr += bytes;
+    data += bytes;
+    size -= bytes;
+  }
+
+  if(uncached_length > 0)
+  {
+    cache->stats.reads++;
+    return blockdevice_read(cache->backing, uncached_data, uncached_addr, uncached_length);
+  }
+
+  return SUCCESS;
+}
+
+static error_t program(blockdevice_t* bd, const uint8_t* data, uint32_t addr, uint32_t size) {
+  blockdevice_cache_t* cache = (blockdevice_cache_t*)bd;
+  DPRINT("BD CACHE WRITE %i @ %x\n", size, addr);
+
+  if(size == 0) return SUCCESS;
+  if(addr + size > cache->base.size) return -ESIZE;
+
+  while(size > 0)
+  {
+    uint32_t page_offset = addr % cache->page_size;
+    uint32_t page_addr = addr - page_offset;
+    uint32_t bytes = cache->page_size - page_offset;
+    if(bytes > size)
+      bytes = size;
+
+    uint8_t index;
+    bool overwritten = (page_offset == 0) && (bytes == get_page_length(cache, page_addr));
+    error_t err = get_page(cache, page_addr, !overwritten, &index);
+    if(err != SUCCESS)
+      return err;
+
+    memcpy(get_page_data(cache, index) + page_offset, data, bytes);
+    cache->pages[index].dirty = true;
+    touch_page(cache, index);
+
+    addr += bytes;
+    data += bytes;
+    size -= bytes;
+  }
+
+  return SUCCESS;
+}
+
+static error_t flush(blockdevice_t* bd) {
+  blockdevice_cache_t* cache = (blockdevice_cache_t*)bd;
+
+  for(uint8_t i = 0; i < cache->page_count; i++)
+  {
+    error_t err = write_back_page(cache, i);
+    if(err != SUCCESS)
+      return err;
+  }
+
+  return blockdevice_flush(cache->backing);
+}
+
+static error_t erase_chip(blockdevice_t* bd) {
+  blockdevice_cache_t* cache = (blockdevice_cache_t*)bd;
+  error_t err = invalidate(cache, 0, cache->base.size);
+  if(err != SUCCESS)
+    return err;
+
+  return blockdevice_erase_chip(cache->backing, 0);
+}
+
+static error_t erase_block32k(blockdevice_t* bd, uint32_t addr) {
+  blockdevice_cache_t* cache = (blockdevice_cache_t*)bd;
+  error_t err = invalidate(cache, addr, 32 * 1024);
+  if(err != SUCCESS)
+    return err;
+
+  return blockdevice_erase_block32k(cache->backing, addr);
+}
+
+static error_t erase_sector4k(blockdevice_t* bd, uint32_t addr) {
+  blockdevice_cache_t* cache = (blockdevice_cache_t*)bd;
+  error_t err = invalidate(cache, addr, 4 * 1024);
+  if(err != SUCCESS)
+    return err;
+
+  return blockdevice_erase_sector4k(cache->backing, addr);
+}
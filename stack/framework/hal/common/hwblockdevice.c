@@ -47,4 +47,10 @@ error_t blockdevice_erase_sector4k(blockdevice_t *bd, uint32_t addr){
   assert(bd && bd->driver && bd->driver->erase_sector4k);
   return bd->driver->erase_sector4k(bd, addr);
 }
+error_t blockdevice_flush(blockdevice_t* bd){
+  assert(bd && bd->driver);
+  if(!bd->driver->flush)
+    return SUCCESS; // nothing buffered
 
+  return bd->driver->flush(bd);
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __BLOCKDEVICE_CACHE_H_
+#define __BLOCKDEVICE_CACHE_H_
+
+#include "hwblockdevice.h"
+
+// This is a write-back cache on top of another (non-volatile) blockdevice. Programs are done in RAM pages, which are
+// only written to the backing blockdevice when they are evicted to make room for another page or when the cache is
+// flushed (see blockdevice_flush()), so repeated small writes to the same region cost a single program of the backing
+// blockdevice. Reads are served from the cached pages when possible and read from the backing blockdevice otherwise.
+// Until the cache is flushed, the backing blockdevice may not contain the latest data: it should not be accessed
+// directly and data which is not flushed is lost on a reset.
+
+#define BLOCKDEVICE_CACHE_PAGE_UNUSED UINT32_MAX
+
+typedef struct {
+  uint32_t addr;        // start address of the cached page, BLOCKDEVICE_CACHE_PAGE_UNUSED if not in use
+  uint32_t last_used;   // the access counter on the last access of the page, the least recently used page is evicted
+  bool dirty;           // the page contains data which is not yet programmed to the backing blockdevice
+} blockdevice_cache_page_t;
+
+typedef struct {
+  uint32_t hits;        // accesses to a page which was cached
+  uint32_t misses;      // accesses to a page which was not cached
+  uint32_t reads;       // reads of the backing blockdevice
+  uint32_t programs;    // programs of the backing blockdevice
+} blockdevice_cache_stats_t;
+
+// extend blockdevice_t, size and offset are taken from the backing blockdevice by blockdevice_init()
+typedef struct {
+  blockdevice_t base;
+  blockdevice_t* backing;           // the cached blockdevice, which has to be initialized already
+  uint8_t* buffer;                  // page_count * page_size bytes
+  blockdevice_cache_page_t* pages;  // page_count entries
+  uint32_t page_size;               // preferably a multiple of the write_block_size of the backing blockdevice
+  uint8_t page_count;
+  uint32_t access_counter;
+  blockdevice_cache_stats_t stats;
+} blockdevice_cache_t;
+
+extern blockdevice_driver_t blockdevice_driver_cache;
+#endif //__BLOCKDEVICE_CACHE_H_
@@ -33,6 +33,7 @@ typedef struct {
   error_t (*erase_chip)(blockdevice_t* bd);
   error_t (*erase_block32k)(blockdevice_t* bd, uint32_t addr);
   error_t (*erase_sector4k)(blockdevice_t* bd, uint32_t addr);
+  error_t (*flush)(blockdevice_t* bd); // optional, writes back data which is buffered by the driver
   uint32_t erase_block_size;
   uint32_t write_block_size;
 } blockdevice_driver_t;
@@ -51,6 +52,7 @@ error_t blockdevice_program(blockdevice_t* bd, const uint8_t* data, uint32_t add
 error_t blockdevice_erase_chip(blockdevice_t* bd, uint32_t addr);
 error_t blockdevice_erase_block32k(blockdevice_t* bd, uint32_t addr);
 error_t blockdevice_erase_sector4k(blockdevice_t* bd, uint32_t addr);
+error_t blockdevice_flush(blockdevice_t* bd);
 
 #endif
 
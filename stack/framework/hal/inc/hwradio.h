@@ -227,6 +227,23 @@ typedef void (*rx_packet_callback_t)(hw_radio_packet_t* packet);
 typedef void (*rx_packet_header_callback_t)(uint8_t* data, uint8_t len);
 
 
+/** \brief Type definition for the rx data callback function
+ *
+ * The rx_packet_data_callback_t function is optional. Radio drivers which drain their FIFO while a packet is being
+ * received call it every time new bytes have been appended to the packet, so the upper layer can already start
+ * decoding them instead of processing the whole packet when rx_packet_callback_t is called. The callback is not
+ * called anymore for the last part of the packet, which is passed to rx_packet_callback_t.
+ *
+ * As with rx_packet_callback_t, this function is called from an interrupt context and should therefore do
+ * as little processing as possible. It must not modify the bytes after the given length.
+ *
+ * \param    packet  The packet which is being received, the length field contains the expected length
+ * \param    length  The number of bytes of packet->data which have been received so far
+ *
+ */
+typedef void (*rx_packet_data_callback_t)(hw_radio_packet_t* packet, uint16_t length);
+
+
 /** \brief Type definition for the tx callback function
  *
  * The tx_packet_callback_t function is called by the radio driver upon completion of a packet transmission. 
@@ -321,6 +338,7 @@ typedef struct hwradio_init_args
     release_packet_callback_t release_packet_cb;
     rx_packet_callback_t rx_packet_cb;
     rx_packet_header_callback_t rx_packet_header_cb;
+    rx_packet_data_callback_t rx_packet_data_cb; // optional, can be NULL
     tx_packet_callback_t tx_packet_cb;
     tx_refill_callback_t tx_refill_cb;
     tx_lora_packet_callback_t tx_lora_packet_cb;
@@ -66,6 +66,23 @@ void hw_system_save_reboot_reason(void);
  */
 __LINK_C void hw_enter_lowpower_mode(uint8_t mode);
 
+/*! \brief Returned by hw_get_lowpower_mode_wakeup_latency() for modes which are not supported or which the MCU does
+ * not resume from (it is reset instead)
+ */
+#define HW_LOWPOWER_MODE_UNAVAILABLE UINT32_MAX
+
+/*! \brief Returns the time it takes to resume from the given low power mode.
+ *
+ * This is the worst case time between the wakeup interrupt and the moment the CPU continues executing after
+ * hw_enter_lowpower_mode(), including restoring the clock configuration. The scheduler uses this to select the deepest
+ * low power mode which still allows it to resume before the next timer event (see FRAMEWORK_SCHEDULER_TICKLESS_IDLE).
+ *
+ * \param mode  The low power mode, as passed to hw_enter_lowpower_mode()
+ *
+ * \return      The wakeup latency in microseconds or HW_LOWPOWER_MODE_UNAVAILABLE
+ */
+__LINK_C uint32_t hw_get_lowpower_mode_wakeup_latency(uint8_t mode);
+
 
 /** \brief Deinitializes all pheriperals before going to low power mode.
  * This is a weak symbol which can be implemented in the platform if you want to use this
@@ -77,6 +94,13 @@ __LINK_C __attribute__((weak)) void hw_deinit_pheriperals(void);
  */
 __LINK_C __attribute__((weak)) void hw_reinit_pheriperals(void);
 
+/** \brief Called by the platform when its supply voltage monitor detects a brownout, while the supply is still high
+ * enough to program the non-volatile memory. The framework implements this to write back the data it buffers (see
+ * FRAMEWORK_FS_WRITE_BACK_CACHE), from a task with MAX_PRIORITY so this can be called from interrupt context.
+ * This is a weak symbol, the platform has to check it is defined before calling it.
+ */
+__LINK_C __attribute__((weak)) void hw_brownout_detected(void);
+
 /*! \brief Get a 64-bit identifier that is unique to the device on which this function is called.
  *
  * The exact manner in which this ID is generated depends on the specific platform. In general however,
@@ -25,18 +25,19 @@
 #include "fs.h"
 #include "hwblockdevice.h"
 #include "blockdevice_ram.h"
+#include "ng.h"
 
 #ifndef PLATFORM_NATIVE
     #error Mismatch between the configured platform and the actual platform. Expected PLATFORM_NATIVE to be defined
 #endif
 
-/** Platform BD drivers*/
-extern blockdevice_t * const metadata_blockdevice;
-extern blockdevice_t * const persistent_files_blockdevice;
-extern blockdevice_t * const volatile_blockdevice;
-#define PLATFORM_METADATA_BLOCKDEVICE metadata_blockdevice
-#define PLATFORM_PERMANENT_BLOCKDEVICE persistent_files_blockdevice
-#define PLATFORM_VOLATILE_BLOCKDEVICE volatile_blockdevice
+/** Platform BD drivers, every simulated node has its own RAM blockdevices */
+extern blockdevice_ram_t NGDEF(_metadata_bd);
+extern blockdevice_ram_t NGDEF(_permanent_bd);
+extern blockdevice_ram_t NGDEF(_volatile_bd);
+#define PLATFORM_METADATA_BLOCKDEVICE ((blockdevice_t*)&NG(_metadata_bd))
+#define PLATFORM_PERMANENT_BLOCKDEVICE ((blockdevice_t*)&NG(_permanent_bd))
+#define PLATFORM_VOLATILE_BLOCKDEVICE ((blockdevice_t*)&NG(_volatile_bd))
 
 #endif
 
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*! \file sim.h
+ * \addtogroup sim
+ * \ingroup NATIVE
+ * @{
+ * \brief Discrete event simulator for the NATIVE platform
+ *
+ * The simulator runs a number of node instances inside a single process. Every node has its own copy of the
+ * framework and stack state (using NODE_GLOBALS, see ng.h) and its own RAM blockdevices, while all nodes share
+ * a single virtual clock. Time only advances when the next event is popped from the event queue, so simulating
+ * hours of network activity does not take hours of wall clock time.
+ *
+ * Events are always executed in the context of a specific node: before the callback is invoked the node
+ * global id is switched to the node the event belongs to, and afterwards all tasks which are pending on
+ * that node are executed before the next event is handled.
+ *
+ * Without PLATFORM_NATIVE_SIMULATOR a NATIVE build runs as a single node on the same virtual clock: the hw timer
+ * is backed by simulator events and hw_enter_lowpower_mode() executes the next event, so the clock jumps
+ * straight to the next compare or overflow instead of waiting for it.
+ */
+
+#ifndef __SIM_H_
+#define __SIM_H_
+
+#include "types.h"
+#include "link_c.h"
+
+/*! \brief The resolution of the virtual clock, in ticks per second. This is a multiple of the hw timer frequencies
+ * and fine enough to resolve single bytes on air at the D7A high rate channel class. */
+#define SIM_TICKS_PER_SEC (UINT64_C(1) << 20)
+
+typedef uint64_t sim_time_t;
+
+typedef void (*sim_event_callback_t)(void* arg);
+
+typedef struct
+{
+    uint64_t events_executed;
+    uint64_t events_peak;
+    double wall_time_sec;
+} sim_stats_t;
+
+/*! \brief Initialise the simulator for the given number of nodes
+ *
+ * \param node_count    the number of nodes to simulate, can not be larger than PLATFORM_NATIVE_SIMULATOR_MAX_NODES
+ */
+__LINK_C void sim_init(uint32_t node_count);
+
+/*! \brief Returns the number of simulated nodes */
+__LINK_C uint32_t sim_get_node_count();
+
+/*! \brief Returns the current virtual time, in SIM_TICKS_PER_SEC */
+__LINK_C sim_time_t sim_get_time();
+
+/*! \brief Schedule a callback to be executed at the given virtual time, in the context of the given node
+ *
+ * Events which are scheduled for the same time are executed in the order in which they were scheduled.
+ * There is no way to cancel an event, callers which need this should ignore stale events themselves
+ * (for example by passing a generation counter as argument).
+ *
+ * \param node      the node in whose context the callback is executed
+ * \param time      the absolute virtual time, must not be in the past
+ * \param callback  the callback
+ * \param arg       the argument passed to the callback
+ */
+__LINK_C void sim_schedule(uint32_t node, sim_time_t time, sim_event_callback_t callback, void* arg);
+
+/*! \brief Execute the next event, if it is due at or before the given time
+ *
+ * \return true when an event was executed, false when the event queue holds no event before 'until'
+ */
+__LINK_C bool sim_step(sim_time_t until);
+
+/*! \brief Keep the current node busy for the given duration, like a busy wait on real hardware
+ *
+ * Meanwhile the other nodes keep running: their events which are due within the duration are executed.
+ * The events of the waiting node itself (its 'interrupts') are postponed until the wait is over, since the
+ * node can not be re-entered. Afterwards the virtual clock is (at least) the start time + duration.
+ */
+__LINK_C void sim_busy_wait(sim_time_t duration);
+
+/*! \brief Run the simulation for the given duration
+ *
+ * All events which are due within the duration are executed. Afterwards the virtual clock equals
+ * the start time + duration.
+ */
+__LINK_C void sim_run(sim_time_t duration);
+
+/*! \brief Returns the statistics gathered since sim_init() */
+__LINK_C const sim_stats_t* sim_get_stats();
+
+/*! \brief Print the simulator statistics to stdout */
+__LINK_C void sim_print_stats();
+
+/*! \brief Returns a pseudo random number
+ *
+ * The sequence only depends on the seed passed to sim_set_seed(), so simulations are reproducible.
+ */
+__LINK_C uint32_t sim_rand();
+
+/*! \brief Seed the pseudo random generator used by sim_rand() */
+__LINK_C void sim_set_seed(uint64_t seed);
+
+/*! \brief Configure the radio link from one node to another
+ *
+ * The virtual radio medium (platf_radio.c) calculates the received power as the transmit power minus
+ * the path loss of the link. Frames which arrive above the sensitivity are additionally lost with the given
+ * packet error rate. Links are directional, by default every link has a path loss of 80 dB and a PER of 0.
+ *
+ * \param from             the transmitting node
+ * \param to               the receiving node
+ * \param path_loss_db     the path loss in dB
+ * \param per              the packet error rate, between 0 and 1
+ */
+__LINK_C void sim_radio_set_link(uint32_t from, uint32_t to, float path_loss_db, float per);
+
+typedef struct
+{
+    uint64_t frames_transmitted;
+    uint64_t frames_received;
+    uint64_t frames_collided;
+    uint64_t frames_lost;
+    uint64_t frames_dropped; // no packet could be allocated by the receiver
+} sim_radio_stats_t;
+
+/*! \brief Returns the statistics of the virtual radio medium */
+__LINK_C const sim_radio_stats_t* sim_radio_get_stats();
+
+/*! \brief Print the statistics of the virtual radio medium to stdout */
+__LINK_C void sim_radio_print_stats();
+
+#endif
+
+/** @}*/
@@ -29,42 +29,66 @@
 #include "error_event_file.h"
 #include "blockdevice_ram.h"
 #include "framework_defs.h"
+#include "platform_defs.h"
+#include "platform.h"
+#include "scheduler.h"
+#include "ng.h"
 
-#define METADATA_SIZE (4 + 4 + (12 * FRAMEWORK_FS_FILE_COUNT))
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
 
-// on native we use a RAM blockdevice as NVM as well for now
-uint8_t d7ap_fs_metadata[METADATA_SIZE];
-uint8_t d7ap_files_data[FRAMEWORK_FS_PERMANENT_STORAGE_SIZE];
-uint8_t d7ap_volatile_files_data[FRAMEWORK_FS_VOLATILE_STORAGE_SIZE];
+#define METADATA_SIZE (4 + 4 + (12 * FRAMEWORK_FS_FILE_COUNT))
 
-static blockdevice_ram_t metadata_bd = (blockdevice_ram_t){
-    .base.driver = &blockdevice_driver_ram,
-    .base.size = METADATA_SIZE,
-    .buffer = d7ap_fs_metadata
-};
+// on native we use a RAM blockdevice as NVM as well for now. Every simulated node has its own storage, which starts
+// out with the default D7AP systemfiles when the d7ap_fs module provides them (see d7ap_fs_data.c).
+static uint8_t NGDEF(_metadata)[METADATA_SIZE];
+#define metadata NG(_metadata)
 
-static blockdevice_ram_t permanent_bd = (blockdevice_ram_t){
-    .base.driver = &blockdevice_driver_ram,
-    .base.size = FRAMEWORK_FS_PERMANENT_STORAGE_SIZE,
-    .buffer = d7ap_files_data
-};
+static uint8_t NGDEF(_permanent_files_data)[FRAMEWORK_FS_PERMANENT_STORAGE_SIZE];
+#define permanent_files_data NG(_permanent_files_data)
 
-static blockdevice_ram_t volatile_bd = (blockdevice_ram_t){
-    .base.driver = &blockdevice_driver_ram,
-    .base.size = FRAMEWORK_FS_VOLATILE_STORAGE_SIZE,
-    .buffer = d7ap_volatile_files_data
-};
+static uint8_t NGDEF(_volatile_files_data)[FRAMEWORK_FS_VOLATILE_STORAGE_SIZE];
+#define volatile_files_data NG(_volatile_files_data)
 
-blockdevice_t * const metadata_blockdevice = (blockdevice_t* const) &metadata_bd;
-blockdevice_t * const persistent_files_blockdevice = (blockdevice_t* const) &permanent_bd;
-blockdevice_t * const volatile_blockdevice = (blockdevice_t* const) &volatile_bd;
+blockdevice_ram_t NGDEF(_metadata_bd);
+blockdevice_ram_t NGDEF(_permanent_bd);
+blockdevice_ram_t NGDEF(_volatile_bd);
 
+// weak, so applications without the d7ap_fs module start with an empty filesystem
+extern uint8_t d7ap_fs_metadata[] __attribute__((weak));
+extern uint8_t d7ap_files_data[] __attribute__((weak));
 
 void __platform_init()
 {
-    blockdevice_init(metadata_blockdevice);
-    blockdevice_init(persistent_files_blockdevice);
-    blockdevice_init(volatile_blockdevice);
+    NG(_metadata_bd) = (blockdevice_ram_t){
+        .base.driver = &blockdevice_driver_ram,
+        .base.size = METADATA_SIZE,
+        .buffer = metadata
+    };
+
+    NG(_permanent_bd) = (blockdevice_ram_t){
+        .base.driver = &blockdevice_driver_ram,
+        .base.size = FRAMEWORK_FS_PERMANENT_STORAGE_SIZE,
+        .buffer = permanent_files_data
+    };
+
+    NG(_volatile_bd) = (blockdevice_ram_t){
+        .base.driver = &blockdevice_driver_ram,
+        .base.size = FRAMEWORK_FS_VOLATILE_STORAGE_SIZE,
+        .buffer = volatile_files_data
+    };
+
+    if(d7ap_fs_metadata && d7ap_files_data)
+    {
+        memcpy(metadata, d7ap_fs_metadata, METADATA_SIZE);
+        memcpy(permanent_files_data, d7ap_files_data, FRAMEWORK_FS_PERMANENT_STORAGE_SIZE);
+    }
+
+    blockdevice_init(PLATFORM_METADATA_BLOCKDEVICE);
+    blockdevice_init(PLATFORM_PERMANENT_BLOCKDEVICE);
+    blockdevice_init(PLATFORM_VOLATILE_BLOCKDEVICE);
 }
 
 void __platform_post_framework_init()
@@ -73,16 +97,46 @@ void __platform_post_framework_init()
 
 error_t low_level_read_cb(uint32_t address, uint8_t *data, uint8_t size)
 {
-    return blockdevice_driver_ram.read(persistent_files_blockdevice, data, address, size);
+    return blockdevice_driver_ram.read(PLATFORM_PERMANENT_BLOCKDEVICE, data, address, size);
 }
 
 error_t low_level_write_cb(uint32_t address, const uint8_t *data, uint8_t size)
 {
-    return blockdevice_driver_ram.program(persistent_files_blockdevice, data, address, size);
+    return blockdevice_driver_ram.program(PLATFORM_PERMANENT_BLOCKDEVICE, data, address, size);
 }
 
+#ifdef PLATFORM_NATIVE_SIMULATOR
+// usage: <app> [node count] [duration in seconds]
+int main(int argc, char** argv)
+{
+    uint32_t node_count = PLATFORM_NATIVE_SIMULATOR_NODES;
+    uint32_t duration = PLATFORM_NATIVE_SIMULATOR_DURATION;
+    if(argc > 1)
+        node_count = strtoul(argv[1], NULL, 0);
+    if(argc > 2)
+        duration = strtoul(argv[2], NULL, 0);
+
+    sim_init(node_count);
+    for(uint32_t node = 0; node < node_count; node++)
+    {
+        set_node_global_id(node);
+        __platform_init();
+        __framework_bootstrap();
+        __platform_post_framework_init();
+        //run the bootstrap task of this node, later tasks are executed from the simulator event loop
+        scheduler_run_pending_tasks();
+    }
+
+    sim_run((sim_time_t)duration * SIM_TICKS_PER_SEC);
+    sim_print_stats();
+    sim_radio_print_stats();
+    return 0;
+}
+#else
 int main()
 {
+    //a single node on the virtual clock, time only advances when the scheduler enters low power mode
+    sim_init(1);
     //initialise the platform itself
     __platform_init();
     //do not initialise the scheduler, this is done by __framework_bootstrap()
@@ -93,6 +147,7 @@ int main()
     scheduler_run();
     return 0;
 }
+#endif
 
 // empty stubs
 __LINK_C uart_handle_t* uart_init(uint8_t port_idx, uint32_t baudrate, uint8_t pins) {}
@@ -102,16 +157,44 @@ __LINK_C void uart_send_bytes(uart_handle_t* uart, void const *data, size_t leng
 __LINK_C error_t uart_rx_interrupt_enable(uart_handle_t* uart) {}
 __LINK_C void uart_set_rx_interrupt_callback(uart_handle_t* uart, uart_rx_inthandler_t rx_handler) {}
 __LINK_C void uart_set_error_callback(uart_handle_t* uart, uart_error_handler_t error_handler) {}
+__LINK_C void uart_pull_down_rx(uart_handle_t* uart) {}
+__LINK_C void uart_rx_interrupt_disable(uart_handle_t* uart) {}
 __LINK_C error_t hw_gpio_set(pin_id_t pin_id) {}
+__LINK_C error_t hw_gpio_clr(pin_id_t pin_id) {}
+__LINK_C void hw_reset(void) { exit(0); }
 system_reboot_reason_t hw_system_reboot_reason(void) {}
-__LINK_C void hw_enter_lowpower_mode(uint8_t mode) {}
-__LINK_C hwtimer_tick_t hw_timer_getvalue(hwtimer_id_t timer_id) {}
-__LINK_C const hwtimer_info_t* hw_timer_get_info(hwtimer_id_t timer_id) {}
-__LINK_C error_t hw_timer_schedule(hwtimer_id_t timer_id, hwtimer_tick_t tick ) {}
-__LINK_C error_t hw_timer_init(hwtimer_id_t timer_id, uint8_t frequency, timer_callback_t compare_callback, timer_callback_t overflow_callback) {}
-__LINK_C bool hw_timer_is_overflow_pending(hwtimer_id_t id) {}
-__LINK_C error_t hw_timer_cancel(hwtimer_id_t timer_id) {}
+
+__LINK_C void hw_busy_wait(int16_t microseconds)
+{
+    //time passes on the virtual clock as well, so for example the CCA1 to CCA2 gap of the DLL is respected
+    sim_busy_wait((sim_time_t)microseconds * SIM_TICKS_PER_SEC / 1000000);
+}
+
+__LINK_C void hw_enter_lowpower_mode(uint8_t mode)
+{
+    //the only 'interrupts' on NATIVE are simulator events, so sleeping means jumping the virtual clock straight
+    //to the next one. The hw timer always has an overflow event queued, so this never runs dry.
+    sim_step(UINT64_MAX);
+}
+
+__LINK_C uint32_t hw_get_lowpower_mode_wakeup_latency(uint8_t mode)
+{
+    //the virtual clock does not advance while waking up, these latencies only exist to exercise the tickless idle planner
+    switch(mode)
+    {
+        case 0: return 0;
+        case 1: return 1000;
+        case 2: return 10000;
+        default: return HW_LOWPOWER_MODE_UNAVAILABLE;
+    }
+}
+
+#ifndef PLATFORM_NATIVE_SIMULATOR
 __LINK_C uint64_t hw_get_unique_id(void) { return 0xFFFFFFFFFFFFFF;}
+#else
+// every simulated node needs a distinct UID
+__LINK_C uint64_t hw_get_unique_id(void) { return 0xFFFFFFFF00000000 + get_node_global_id(); }
+#endif
 __LINK_C void hw_watchdog_feed(void) {};
 __LINK_C void __watchdog_init(void) {};
-__LINK_C void hw_watchdog_get_timeout(void) {};
+__LINK_C uint8_t hw_watchdog_get_timeout(void) { return 20; };
@@ -0,0 +1,768 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Virtual radio medium for the NATIVE simulator.
+ *
+ * Every node has its own (FSK) transceiver which behaves like the sx127x driver towards the upper layers:
+ * - TX: the radio prepends preamble and sync word, hw_radio_send_payload() calls made while transmitting with
+ *   refill enabled are appended to the ongoing transmission. Chunks starting with preamble bytes (0xAA) followed by a
+ *   sync word start a new frame on air, which is how the PHY floods background frames.
+ * - RX: in unlimited length mode the first 4 bytes are passed to rx_packet_header_cb, after which the length set using
+ *   hw_radio_set_payload_length() is received. In fixed length mode the configured length is received immediately.
+ *   Like the sx127x FIFO threshold interrupt, the received bytes are passed to rx_packet_data_cb every RX_CHUNK_SIZE
+ *   bytes while the rest of the packet is still on air.
+ *
+ * The airtime of every byte follows from the configured bitrate. A receiver locks on a frame when it is in RX on the
+ * same frequency, bitrate and sync word at the moment the sync word was transmitted and the received power is above
+ * the sensitivity. The frame is corrupted when another transmission on the same frequency overlaps with it and is
+ * received less than CAPTURE_THRESHOLD_DB weaker, or when the packet error rate of the link triggers.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hwradio.h"
+#include "errors.h"
+#include "debug.h"
+#include "ng.h"
+#include "sim.h"
+#include "timer.h"
+
+#define NOISE_FLOOR_DBM (-120.0)
+#define CAPTURE_THRESHOLD_DB 6.0
+#define DEFAULT_PATH_LOSS_DB 80.0
+#define SYNC_WORD_SIZE 2
+#define HEADER_SIZE 4
+#define RX_CHUNK_SIZE 32
+#define PREAMBLE_BYTE 0xAA
+#define FRAME_MAX_SIZE 600
+#define TX_HISTORY (2 * SIM_TICKS_PER_SEC)
+#define RSSI_MEASUREMENT_TIME (SIM_TICKS_PER_SEC / 2000) // 500 us, the rssi is averaged over a number of samples
+#define SIM_TIME_NEVER UINT64_MAX
+
+typedef struct
+{
+    uint32_t node;
+    uint32_t center_freq;
+    double tx_power_dbm;
+    sim_time_t start;
+    sim_time_t end;
+} transmission_t;
+
+typedef struct
+{
+    uint32_t node;
+    uint32_t center_freq;
+    uint32_t bitrate;
+    uint16_t sync_word;
+    double tx_power_dbm;
+    sim_time_t start; // start of the preamble
+    sim_time_t data_start; // end of the sync word
+    uint16_t length;
+    uint8_t refcount;
+    uint8_t data[FRAME_MAX_SIZE];
+} frame_t;
+
+typedef struct
+{
+    hwradio_init_args_t callbacks;
+    hw_radio_state_t opmode;
+    uint32_t center_freq;
+    uint32_t bitrate;
+    uint16_t preamble_size;
+    uint16_t sync_word;
+    uint16_t payload_length;
+    int8_t tx_power;
+    bool refill;
+    bool preloading;
+    // TX
+    uint8_t pending[FRAME_MAX_SIZE]; // data queued before the transmission starts
+    uint16_t pending_length;
+    transmission_t* transmission;
+    frame_t* tx_frame;
+    sim_time_t tx_end;
+    uintptr_t tx_generation;
+    // RX
+    frame_t* rx_frame;
+    hw_radio_packet_t* rx_packet;
+    uint16_t rx_received; // the number of bytes copied to rx_packet
+    double rx_power_dbm;
+    bool rx_unlimited_length;
+    uintptr_t rx_generation;
+    uintptr_t rx_timeout_generation;
+    bool rx_irq_disabled; // like the sx127x no frames are received while measuring the RSSI, until RX is restarted
+} virtual_radio_t;
+
+static virtual_radio_t NGDEF(_vradio);
+#define vradio NG(_vradio)
+
+static transmission_t** transmissions = NULL;
+static size_t transmissions_count = 0;
+static size_t transmissions_capacity = 0;
+
+static float* path_loss = NULL;
+static float* per = NULL;
+static uint32_t link_nodes = 0;
+
+static sim_radio_stats_t stats;
+
+static void init_links()
+{
+    if(path_loss != NULL)
+        return;
+
+    link_nodes = sim_get_node_count();
+    path_loss = malloc(link_nodes * link_nodes * sizeof(float));
+    per = calloc(link_nodes * link_nodes, sizeof(float));
+    assert(path_loss != NULL && per != NULL);
+    for(uint32_t i = 0; i < link_nodes * link_nodes; i++)
+        path_loss[i] = DEFAULT_PATH_LOSS_DB;
+}
+
+void sim_radio_set_link(uint32_t from, uint32_t to, float path_loss_db, float packet_error_rate)
+{
+    init_links();
+    assert(from < link_nodes && to < link_nodes);
+    path_loss[from * link_nodes + to] = path_loss_db;
+    per[from * link_nodes + to] = packet_error_rate;
+}
+
+const sim_radio_stats_t* sim_radio_get_stats()
+{
+    return &stats;
+}
+
+void sim_radio_print_stats()
+{
+    printf("SIM radio: %llu frames transmitted, %llu received, %llu collided, %llu lost, %llu dropped\n",
+           (unsigned long long)stats.frames_transmitted, (unsigned long long)stats.frames_received,
+           (unsigned long long)stats.frames_collided, (unsigned long long)stats.frames_lost,
+           (unsigned long long)stats.frames_dropped);
+}
+
+static inline size_t switch_node(size_t node)
+{
+    size_t previous = get_node_global_id();
+    set_node_global_id(node);
+    return previous;
+}
+
+static inline double rx_power(uint32_t from, uint32_t to, double tx_power_dbm)
+{
+    return tx_power_dbm - path_loss[from * link_nodes + to];
+}
+
+static inline double sensitivity(uint32_t bitrate)
+{
+    // -123 dBm at 9.6 kbps, decreasing with the bandwidth needed for higher bitrates
+    return -123.0 + 10.0 * log10(bitrate / 9600.0);
+}
+
+static inline sim_time_t airtime(uint32_t bitrate, uint32_t bytes)
+{
+    return (sim_time_t)bytes * 8 * SIM_TICKS_PER_SEC / bitrate;
+}
+
+static void release_frame(frame_t* frame)
+{
+    assert(frame->refcount > 0);
+    if(--frame->refcount == 0)
+        free(frame);
+}
+
+static void prune_transmissions()
+{
+    sim_time_t now = sim_get_time();
+    for(size_t i = 0; i < transmissions_count;)
+    {
+        transmission_t* t = transmissions[i];
+        if(t->end != SIM_TIME_NEVER && t->end + TX_HISTORY < now)
+        {
+            free(t);
+            transmissions[i] = transmissions[--transmissions_count];
+        }
+        else
+            i++;
+    }
+}
+
+static transmission_t* add_transmission()
+{
+    prune_transmissions();
+    if(transmissions_count == transmissions_capacity)
+    {
+        transmissions_capacity = transmissions_capacity ? transmissions_capacity * 2 : 16;
+        transmissions = realloc(transmissions, transmissions_capacity * sizeof(transmission_t*));
+        assert(transmissions != NULL);
+    }
+
+    transmission_t* t = malloc(sizeof(transmission_t));
+    assert(t != NULL);
+    t->node = get_node_global_id();
+    t->center_freq = vradio.center_freq;
+    t->tx_power_dbm = vradio.tx_power;
+    t->start = sim_get_time();
+    t->end = SIM_TIME_NEVER;
+    transmissions[transmissions_count++] = t;
+    return t;
+}
+
+static bool is_collided(const frame_t* frame, uint32_t receiver, double signal_dbm)
+{
+    sim_time_t now = sim_get_time();
+    for(size_t i = 0; i < transmissions_count; i++)
+    {
+        transmission_t* t = transmissions[i];
+        if(t->node == frame->node || t->node == receiver || t->center_freq != frame->center_freq)
+            continue;
+
+        if(t->start >= now || t->end <= frame->start)
+            continue;
+
+        if(rx_power(t->node, receiver, t->tx_power_dbm) > signal_dbm - CAPTURE_THRESHOLD_DB)
+            return true;
+    }
+
+    return false;
+}
+
+/*
+ * RX
+ */
+
+static void rx_unlock()
+{
+    if(vradio.rx_frame != NULL)
+    {
+        release_frame(vradio.rx_frame);
+        vradio.rx_frame = NULL;
+    }
+
+    // the reception was aborted
+    if(vradio.rx_packet != NULL)
+    {
+        vradio.callbacks.release_packet_cb(vradio.rx_packet);
+        vradio.rx_packet = NULL;
+    }
+
+    vradio.rx_generation++;
+}
+
+static bool rx_alloc_packet()
+{
+    if(vradio.rx_packet == NULL)
+    {
+        vradio.rx_packet = vradio.callbacks.alloc_packet_cb(vradio.payload_length);
+        vradio.rx_received = 0;
+    }
+
+    return vradio.rx_packet != NULL;
+}
+
+// copy the bytes received up to the given length from the frame on air
+static void rx_copy(uint16_t length)
+{
+    frame_t* frame = vradio.rx_frame;
+    for(uint16_t i = vradio.rx_received; i < length; i++)
+        vradio.rx_packet->data[i] = i < frame->length ? frame->data[i] : 0;
+
+    vradio.rx_received = length;
+}
+
+static void rx_end_event(void* arg);
+
+static void rx_data_event(void* arg);
+
+static void rx_schedule_next()
+{
+    frame_t* frame = vradio.rx_frame;
+    uint32_t next = vradio.rx_received + RX_CHUNK_SIZE;
+    if(vradio.callbacks.rx_packet_data_cb != NULL && next < vradio.payload_length)
+        sim_schedule(get_node_global_id(), frame->data_start + airtime(frame->bitrate, next), &rx_data_event,
+                     (void*)vradio.rx_generation);
+    else
+        sim_schedule(get_node_global_id(), frame->data_start + airtime(frame->bitrate, vradio.payload_length),
+                     &rx_end_event, (void*)vradio.rx_generation);
+}
+
+static void rx_drop()
+{
+    stats.frames_dropped++;
+    rx_unlock();
+    if(vradio.rx_unlimited_length)
+        vradio.payload_length = 0;
+}
+
+static void rx_data_event(void* arg)
+{
+    if((uintptr_t)arg != vradio.rx_generation)
+        return;
+
+    if(!rx_alloc_packet())
+    {
+        rx_drop();
+        return;
+    }
+
+    vradio.rx_packet->length = vradio.payload_length;
+    rx_copy(vradio.rx_received + RX_CHUNK_SIZE);
+    rx_schedule_next();
+    vradio.callbacks.rx_packet_data_cb(vradio.rx_packet, vradio.rx_received);
+}
+
+static void rx_end_event(void* arg)
+{
+    if((uintptr_t)arg != vradio.rx_generation)
+        return;
+
+    if(!rx_alloc_packet())
+    {
+        rx_drop();
+        return;
+    }
+
+    frame_t* frame = vradio.rx_frame;
+    hw_radio_packet_t* packet = vradio.rx_packet;
+    uint16_t length = vradio.payload_length;
+    uint16_t delivered = vradio.rx_received;
+    uint32_t node = get_node_global_id();
+    bool corrupted = false;
+    if(is_collided(frame, node, vradio.rx_power_dbm))
+    {
+        stats.frames_collided++;
+        corrupted = true;
+    }
+    else if((sim_rand() + 0.5) / 4294967296.0 < per[frame->node * link_nodes + node])
+    {
+        stats.frames_lost++;
+        corrupted = true;
+    }
+
+    rx_copy(length);
+    // the bytes passed to rx_packet_data_cb can not change anymore, so corrupt the part received last if needed
+    if(corrupted)
+        packet->data[length / 2 > delivered ? length / 2 : delivered] ^= 0xFF;
+    else
+        stats.frames_received++;
+
+    packet->length = length;
+    packet->rx_meta.timestamp = timer_get_counter_value();
+    packet->rx_meta.rssi = (int16_t)lround(vradio.rx_power_dbm);
+    packet->rx_meta.lqi = 0;
+    packet->rx_meta.crc_status = HW_CRC_UNAVAILABLE;
+
+    // like the sx127x the reception is restarted until the upper layer decides to stop it
+    vradio.rx_packet = NULL;
+    rx_unlock();
+    if(vradio.rx_unlimited_length)
+        vradio.payload_length = 0;
+
+    vradio.callbacks.rx_packet_cb(packet);
+}
+
+static void rx_header_event(void* arg)
+{
+    if((uintptr_t)arg != vradio.rx_generation)
+        return;
+
+    frame_t* frame = vradio.rx_frame;
+    uint8_t header[HEADER_SIZE];
+    memcpy(header, frame->data, HEADER_SIZE);
+    vradio.callbacks.rx_packet_header_cb(header, HEADER_SIZE);
+    if(vradio.payload_length == 0)
+    {
+        // length was invalid, discard
+        rx_unlock();
+        return;
+    }
+
+    rx_schedule_next();
+}
+
+// executed in the context of the transmitting node, at the moment the sync word of the frame was transmitted
+static void frame_sync_event(void* arg)
+{
+    frame_t* frame = arg;
+    for(uint32_t node = 0; node < sim_get_node_count(); node++)
+    {
+        if(node == frame->node)
+            continue;
+
+        size_t previous = switch_node(node);
+        double power = rx_power(frame->node, node, frame->tx_power_dbm);
+        if(vradio.opmode == HW_STATE_RX && !vradio.rx_irq_disabled && vradio.rx_frame == NULL
+           && vradio.center_freq == frame->center_freq && vradio.bitrate == frame->bitrate && vradio.sync_word == frame->sync_word
+           && power >= sensitivity(frame->bitrate))
+        {
+            frame->refcount++;
+            vradio.rx_frame = frame;
+            vradio.rx_power_dbm = power;
+            vradio.rx_generation++;
+            vradio.rx_unlimited_length = vradio.payload_length == 0;
+            vradio.rx_received = 0;
+            if(vradio.rx_unlimited_length)
+                sim_schedule(node, frame->data_start + airtime(frame->bitrate, HEADER_SIZE), &rx_header_event,
+                             (void*)vradio.rx_generation);
+            else
+                rx_schedule_next();
+        }
+
+        switch_node(previous);
+    }
+
+    release_frame(frame);
+}
+
+static void rx_timeout_event(void* arg)
+{
+    if((uintptr_t)arg != vradio.rx_timeout_generation)
+        return;
+
+    hw_radio_set_idle();
+}
+
+/*
+ * TX
+ */
+
+static void tx_end_frame()
+{
+    if(vradio.tx_frame != NULL)
+    {
+        release_frame(vradio.tx_frame);
+        vradio.tx_frame = NULL;
+    }
+}
+
+static void tx_start_frame(uint16_t sync_word, sim_time_t start, const uint8_t* data, uint16_t length)
+{
+    tx_end_frame();
+    frame_t* frame = malloc(sizeof(frame_t));
+    assert(frame != NULL);
+    frame->node = get_node_global_id();
+    frame->center_freq = vradio.center_freq;
+    frame->bitrate = vradio.bitrate;
+    frame->sync_word = sync_word;
+    frame->tx_power_dbm = vradio.tx_power;
+    frame->start = start;
+    frame->data_start = vradio.tx_end;
+    frame->length = length < FRAME_MAX_SIZE ? length : FRAME_MAX_SIZE;
+    memcpy(frame->data, data, frame->length);
+    frame->refcount = 2; // the transmitter and the sync event
+    vradio.tx_frame = frame;
+    stats.frames_transmitted++;
+    sim_schedule(frame->node, frame->data_start, &frame_sync_event, frame);
+}
+
+static void tx_stop()
+{
+    tx_end_frame();
+    if(vradio.transmission != NULL)
+    {
+        vradio.transmission->end = sim_get_time();
+        vradio.transmission = NULL;
+    }
+
+    vradio.tx_generation++;
+}
+
+static void tx_end_event(void* arg);
+
+static void tx_schedule_end()
+{
+    vradio.tx_generation++;
+    sim_schedule(get_node_global_id(), vradio.tx_end, &tx_end_event, (void*)vradio.tx_generation);
+}
+
+// append a chunk to an ongoing transmission
+static void tx_append(uint8_t* data, uint16_t length)
+{
+    uint16_t preamble = 0;
+    while(preamble < length && data[preamble] == PREAMBLE_BYTE)
+        preamble++;
+
+    sim_time_t chunk_start = vradio.tx_end;
+    if(preamble > 0 && preamble == length)
+    {
+        // padding, which ends the current frame
+        tx_end_frame();
+        vradio.tx_end += airtime(vradio.bitrate, length);
+    }
+    else if(preamble > 0 && length >= preamble + SYNC_WORD_SIZE)
+    {
+        uint16_t sync_word = (data[preamble] << 8) | data[preamble + 1];
+        vradio.tx_end += airtime(vradio.bitrate, preamble + SYNC_WORD_SIZE);
+        tx_start_frame(sync_word, chunk_start, data + preamble + SYNC_WORD_SIZE, length - preamble - SYNC_WORD_SIZE);
+        vradio.tx_end += airtime(vradio.bitrate, length - preamble - SYNC_WORD_SIZE);
+    }
+    else
+    {
+        // continuation of the current frame
+        frame_t* frame = vradio.tx_frame;
+        if(frame != NULL)
+        {
+            uint16_t copy = length;
+            if(frame->length + copy > FRAME_MAX_SIZE)
+                copy = FRAME_MAX_SIZE - frame->length;
+
+            memcpy(frame->data + frame->length, data, copy);
+            frame->length += copy;
+        }
+
+        vradio.tx_end += airtime(vradio.bitrate, length);
+    }
+}
+
+static void tx_start()
+{
+    assert(vradio.transmission == NULL);
+    vradio.transmission = add_transmission();
+    sim_time_t start = sim_get_time();
+    vradio.tx_end = start + airtime(vradio.bitrate, vradio.preamble_size + SYNC_WORD_SIZE);
+    tx_start_frame(vradio.sync_word, start, vradio.pending, vradio.pending_length);
+    vradio.tx_end += airtime(vradio.bitrate, vradio.pending_length);
+    vradio.pending_length = 0;
+    tx_schedule_end();
+}
+
+static void tx_end_event(void* arg)
+{
+    if((uintptr_t)arg != vradio.tx_generation)
+        return;
+
+    if(vradio.refill && vradio.callbacks.tx_refill_cb)
+    {
+        sim_time_t previous_end = vradio.tx_end;
+        vradio.callbacks.tx_refill_cb(0);
+        if(vradio.transmission != NULL && vradio.tx_end != previous_end)
+        {
+            tx_schedule_end();
+            return;
+        }
+    }
+
+    if(vradio.transmission == NULL)
+        return; // stopped from the refill callback
+
+    tx_stop();
+    vradio.opmode = HW_STATE_STANDBY;
+    if(vradio.callbacks.tx_packet_cb)
+        vradio.callbacks.tx_packet_cb(timer_get_counter_value());
+}
+
+/*
+ * hwradio.h API
+ */
+
+error_t hw_radio_init(hwradio_init_args_t* init_args)
+{
+    init_links();
+    if(vradio.transmission != NULL)
+        tx_stop();
+
+    rx_unlock();
+    vradio.callbacks = *init_args;
+    vradio.opmode = HW_STATE_SLEEP;
+    vradio.bitrate = 55555;
+    vradio.preamble_size = 4;
+    vradio.sync_word = 0;
+    vradio.payload_length = 0;
+    vradio.tx_power = 10;
+    vradio.refill = false;
+    vradio.preloading = false;
+    vradio.pending_length = 0;
+    return SUCCESS;
+}
+
+void hw_radio_stop(void)
+{
+    hw_radio_set_idle();
+}
+
+hw_radio_state_t hw_radio_get_opmode(void)
+{
+    return vradio.opmode;
+}
+
+void hw_radio_set_opmode(hw_radio_state_t opmode)
+{
+    if(opmode == HW_STATE_IDLE)
+        opmode = HW_STATE_RX; // same as the sx127x driver
+
+    if(opmode == HW_STATE_RESET)
+        opmode = HW_STATE_STANDBY;
+
+    if(opmode != HW_STATE_TX && vradio.transmission != NULL)
+        tx_stop();
+
+    if(opmode != HW_STATE_RX || vradio.opmode != HW_STATE_RX)
+        rx_unlock();
+
+    vradio.opmode = opmode;
+    vradio.rx_irq_disabled = false;
+    if(opmode == HW_STATE_TX && vradio.transmission == NULL && vradio.pending_length > 0)
+        tx_start();
+}
+
+error_t hw_radio_set_idle(void)
+{
+    hw_radio_set_opmode(HW_STATE_SLEEP);
+    vradio.rx_timeout_generation++;
+    return SUCCESS;
+}
+
+bool hw_radio_is_idle(void)
+{
+    return vradio.opmode == HW_STATE_SLEEP || vradio.opmode == HW_STATE_OFF;
+}
+
+bool hw_radio_is_rx(void)
+{
+    return vradio.opmode == HW_STATE_RX;
+}
+
+bool hw_radio_tx_busy(void)
+{
+    return vradio.transmission != NULL;
+}
+
+bool hw_radio_rx_busy(void)
+{
+    return vradio.rx_frame != NULL;
+}
+
+bool hw_radio_rssi_valid(void)
+{
+    return vradio.opmode == HW_STATE_RX;
+}
+
+int16_t hw_radio_get_rssi(void)
+{
+    if(vradio.opmode != HW_STATE_RX)
+        hw_radio_set_opmode(HW_STATE_RX);
+
+    rx_unlock();
+    vradio.rx_irq_disabled = true;
+    // the measurement takes time, which also keeps a CSMA-CA retry loop from spinning on a frozen clock
+    sim_busy_wait(RSSI_MEASUREMENT_TIME);
+
+    uint32_t node = get_node_global_id();
+    sim_time_t now = sim_get_time();
+    double power_mw = pow(10.0, NOISE_FLOOR_DBM / 10.0);
+    for(size_t i = 0; i < transmissions_count; i++)
+    {
+        transmission_t* t = transmissions[i];
+        if(t->node == node || t->center_freq != vradio.center_freq || t->start > now || t->end <= now)
+            continue;
+
+        power_mw += pow(10.0, rx_power(t->node, node, t->tx_power_dbm) / 10.0);
+    }
+
+    return (int16_t)lround(10.0 * log10(power_mw));
+}
+
+error_t hw_radio_send_payload(uint8_t* data, uint16_t len)
+{
+    if(len == 0)
+        return ESIZE;
+
+    if(vradio.transmission != NULL)
+    {
+        tx_append(data, len);
+        tx_schedule_end();
+        return SUCCESS;
+    }
+
+    if(vradio.opmode == HW_STATE_RX)
+        hw_radio_set_opmode(HW_STATE_STANDBY);
+
+    if(vradio.pending_length + len > FRAME_MAX_SIZE)
+        return ESIZE;
+
+    memcpy(vradio.pending + vradio.pending_length, data, len);
+    vradio.pending_length += len;
+    if(!vradio.preloading)
+        hw_radio_set_opmode(HW_STATE_TX);
+    else
+        vradio.preloading = false;
+
+    return SUCCESS;
+}
+
+void hw_radio_set_center_freq(uint32_t center_freq)
+{
+    vradio.center_freq = center_freq;
+}
+
+void hw_radio_set_bitrate(uint32_t bps)
+{
+    assert(bps > 0);
+    vradio.bitrate = bps;
+}
+
+void hw_radio_set_preamble_size(uint16_t size)
+{
+    vradio.preamble_size = size;
+}
+
+void hw_radio_set_sync_word(uint8_t* sync_word, uint8_t sync_size)
+{
+    // the same byte order as the sx127x, the first byte on air is the MSB
+    vradio.sync_word = sync_word[0];
+    if(sync_size > 1)
+        vradio.sync_word |= ((uint16_t)sync_word[1]) << 8;
+}
+
+void hw_radio_set_payload_length(uint16_t length)
+{
+    vradio.payload_length = length;
+}
+
+void hw_radio_set_tx_power(int8_t eirp)
+{
+    vradio.tx_power = eirp;
+}
+
+void hw_radio_enable_refill(bool enable)
+{
+    vradio.refill = enable;
+}
+
+void hw_radio_enable_preloading(bool enable)
+{
+    vradio.preloading = enable;
+}
+
+void hw_radio_set_rx_timeout(uint32_t timeout)
+{
+    vradio.rx_timeout_generation++;
+    sim_schedule(get_node_global_id(), sim_get_time() + (sim_time_t)timeout * SIM_TICKS_PER_SEC / TIMER_TICKS_PER_SEC,
+                 &rx_timeout_event, (void*)vradio.rx_timeout_generation);
+}
+
+// settings without influence on the medium model
+void hw_radio_set_rx_bw_hz(uint32_t bw_hz) {}
+void hw_radio_set_tx_fdev(uint32_t fdev) {}
+void hw_radio_set_preamble_detector(uint8_t preamble_detector_size, uint8_t preamble_tol) {}
+void hw_radio_set_rssi_config(uint8_t rssi_smoothing, uint8_t rssi_offset) {}
+void hw_radio_set_dc_free(uint8_t scheme) {}
+void hw_radio_set_crc_on(uint8_t enable) {}
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Virtual hardware timer for the NATIVE platform. The 16 bit counter is derived from the simulator clock,
+ * compare and overflow 'interrupts' are events in the simulator event queue, executed in the context of the
+ * node which owns the timer.
+ */
+
+#include "hwtimer.h"
+#include "errors.h"
+#include "ng.h"
+#include "debug.h"
+#include "sim.h"
+
+#define HWTIMER_NUM 1
+#define COUNTER_PERIOD (UINT32_C(1) << (8 * sizeof(hwtimer_tick_t)))
+
+typedef struct
+{
+    timer_callback_t compare_callback;
+    timer_callback_t overflow_callback;
+    uint32_t sim_ticks_per_tick;
+    sim_time_t origin; // virtual time at which the counter was (last) reset to 0
+    sim_time_t next_overflow;
+    uintptr_t compare_generation;
+    uintptr_t overflow_generation;
+    bool initialised;
+} virtual_timer_t;
+
+static virtual_timer_t NGDEF(_vtimer);
+#define vtimer NG(_vtimer)
+
+static const hwtimer_info_t timer_info = {
+    .min_delay_ticks = 0,
+};
+
+static void overflow_event(void* arg);
+
+static inline uint64_t ticks_now()
+{
+    return (sim_get_time() - vtimer.origin) / vtimer.sim_ticks_per_tick;
+}
+
+static void schedule_overflow()
+{
+    uint64_t period = (uint64_t)COUNTER_PERIOD * vtimer.sim_ticks_per_tick;
+    vtimer.overflow_generation++;
+    vtimer.next_overflow = vtimer.origin + (ticks_now() / COUNTER_PERIOD + 1) * period;
+    sim_schedule(get_node_global_id(), vtimer.next_overflow, &overflow_event, (void*)vtimer.overflow_generation);
+}
+
+static void overflow_event(void* arg)
+{
+    if((uintptr_t)arg != vtimer.overflow_generation)
+        return;
+
+    vtimer.next_overflow += (sim_time_t)COUNTER_PERIOD * vtimer.sim_ticks_per_tick;
+    sim_schedule(get_node_global_id(), vtimer.next_overflow, &overflow_event, arg);
+    if(vtimer.overflow_callback)
+        vtimer.overflow_callback();
+}
+
+static void compare_event(void* arg)
+{
+    if((uintptr_t)arg != vtimer.compare_generation)
+        return;
+
+    // the compare interrupt fires only once
+    vtimer.compare_generation++;
+    if(vtimer.compare_callback)
+        vtimer.compare_callback();
+}
+
+error_t hw_timer_init(hwtimer_id_t timer_id, uint8_t frequency, timer_callback_t compare_callback, timer_callback_t overflow_callback)
+{
+    if(timer_id >= HWTIMER_NUM)
+        return ESIZE;
+
+    if(vtimer.initialised)
+        return EALREADY;
+
+    if(frequency == HWTIMER_FREQ_1MS)
+        vtimer.sim_ticks_per_tick = SIM_TICKS_PER_SEC / HWTIMER_TICKS_1MS;
+    else if(frequency == HWTIMER_FREQ_32K)
+        vtimer.sim_ticks_per_tick = SIM_TICKS_PER_SEC / HWTIMER_TICKS_32K;
+    else
+        return EINVAL;
+
+    vtimer.compare_callback = compare_callback;
+    vtimer.overflow_callback = overflow_callback;
+    vtimer.origin = 0;
+    vtimer.compare_generation++;
+    vtimer.initialised = true;
+    schedule_overflow();
+    return SUCCESS;
+}
+
+const hwtimer_info_t* hw_timer_get_info(hwtimer_id_t timer_id)
+{
+    if(timer_id >= HWTIMER_NUM)
+        return NULL;
+
+    return &timer_info;
+}
+
+hwtimer_tick_t hw_timer_getvalue(hwtimer_id_t timer_id)
+{
+    if(timer_id >= HWTIMER_NUM || !vtimer.initialised)
+        return 0;
+
+    return (hwtimer_tick_t)ticks_now();
+}
+
+error_t hw_timer_schedule(hwtimer_id_t timer_id, hwtimer_tick_t tick)
+{
+    if(timer_id >= HWTIMER_NUM)
+        return ESIZE;
+
+    if(!vtimer.initialised)
+        return EOFF;
+
+    uint64_t now = ticks_now();
+    uint32_t delay = (hwtimer_tick_t)(tick - (hwtimer_tick_t)now);
+    // like the hardware comparator a tick equal to the current counter value only matches after a full period
+    if(delay == 0)
+        delay = COUNTER_PERIOD;
+
+    vtimer.compare_generation++;
+    sim_schedule(get_node_global_id(), vtimer.origin + (now + delay) * vtimer.sim_ticks_per_tick, &compare_event,
+                 (void*)vtimer.compare_generation);
+    return SUCCESS;
+}
+
+error_t hw_timer_cancel(hwtimer_id_t timer_id)
+{
+    if(timer_id >= HWTIMER_NUM)
+        return ESIZE;
+
+    if(!vtimer.initialised)
+        return EOFF;
+
+    // pending compare events are ignored once the generation changed
+    vtimer.compare_generation++;
+    return SUCCESS;
+}
+
+error_t hw_timer_counter_reset(hwtimer_id_t timer_id)
+{
+    if(timer_id >= HWTIMER_NUM)
+        return ESIZE;
+
+    if(!vtimer.initialised)
+        return EOFF;
+
+    // align the origin on the tick boundary so the counter reads 0 from now on
+    sim_time_t now = sim_get_time();
+    vtimer.origin = now - (now % vtimer.sim_ticks_per_tick);
+    vtimer.compare_generation++;
+    schedule_overflow();
+    return SUCCESS;
+}
+
+bool hw_timer_is_overflow_pending(hwtimer_id_t timer_id)
+{
+    if(timer_id >= HWTIMER_NUM || !vtimer.initialised)
+        return false;
+
+    // the overflow event is due but was not yet executed
+    return sim_get_time() >= vtimer.next_overflow;
+}
+
+bool hw_timer_is_interrupt_pending(hwtimer_id_t timer_id)
+{
+    return false;
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "sim.h"
+#include "ng.h"
+#include "debug.h"
+#include "scheduler.h"
+
+typedef struct
+{
+    sim_time_t time;
+    uint64_t seq; // keeps events which are due at the same time in FIFO order
+    uint32_t node;
+    sim_event_callback_t callback;
+    void* arg;
+} sim_event_t;
+
+// binary min-heap, ordered on (time, seq)
+static sim_event_t* events = NULL;
+static size_t events_count = 0;
+static size_t events_capacity = 0;
+
+// the nodes which are executing sim_busy_wait(), these can be nested
+#ifdef NODE_GLOBALS
+static bool busy[NODE_GLOBALS_MAX_NODES];
+#else
+static bool busy[1];
+#endif
+
+static sim_time_t current_time = 0;
+static uint64_t next_seq = 0;
+static uint32_t nodes = 0;
+static sim_stats_t stats;
+static uint64_t rand_state = 0x9E3779B97F4A7C15;
+
+static inline bool event_before(const sim_event_t* a, const sim_event_t* b)
+{
+    return (a->time < b->time) || (a->time == b->time && a->seq < b->seq);
+}
+
+static void heap_push(const sim_event_t* event)
+{
+    if(events_count == events_capacity)
+    {
+        events_capacity = events_capacity ? events_capacity * 2 : 64;
+        events = realloc(events, events_capacity * sizeof(sim_event_t));
+        assert(events != NULL);
+    }
+
+    size_t i = events_count++;
+    while(i > 0)
+    {
+        size_t parent = (i - 1) / 2;
+        if(!event_before(event, &events[parent]))
+            break;
+
+        events[i] = events[parent];
+        i = parent;
+    }
+
+    events[i] = *event;
+    if(events_count > stats.events_peak)
+        stats.events_peak = events_count;
+}
+
+static void heap_pop(sim_event_t* event)
+{
+    assert(events_count > 0);
+    *event = events[0];
+    sim_event_t last = events[--events_count];
+    size_t i = 0;
+    while(true)
+    {
+        size_t child = 2 * i + 1;
+        if(child >= events_count)
+            break;
+
+        if(child + 1 < events_count && event_before(&events[child + 1], &events[child]))
+            child++;
+
+        if(!event_before(&events[child], &last))
+            break;
+
+        events[i] = events[child];
+        i = child;
+    }
+
+    events[i] = last;
+}
+
+static double wall_clock()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void sim_init(uint32_t node_count)
+{
+#ifdef NODE_GLOBALS
+    assert(node_count > 0 && node_count <= NODE_GLOBALS_MAX_NODES);
+#else
+    assert(node_count == 1);
+#endif
+    nodes = node_count;
+    events_count = 0;
+    current_time = 0;
+    next_seq = 0;
+    stats = (sim_stats_t){ 0 };
+}
+
+uint32_t sim_get_node_count()
+{
+    return nodes;
+}
+
+sim_time_t sim_get_time()
+{
+    return current_time;
+}
+
+void sim_schedule(uint32_t node, sim_time_t time, sim_event_callback_t callback, void* arg)
+{
+    assert(node < nodes);
+    assert(time >= current_time);
+    sim_event_t event = {
+        .time = time,
+        .seq = next_seq++,
+        .node = node,
+        .callback = callback,
+        .arg = arg
+    };
+
+    heap_push(&event);
+}
+
+bool sim_step(sim_time_t until)
+{
+    if(events_count == 0 || events[0].time > until)
+        return false;
+
+    sim_event_t event;
+    heap_pop(&event);
+    // events which were postponed by sim_busy_wait() are late
+    if(event.time > current_time)
+        current_time = event.time;
+
+    stats.events_executed++;
+
+#ifdef NODE_GLOBALS
+    size_t previous_node = __ng_node_id__;
+    set_node_global_id(event.node);
+#endif
+    event.callback(event.arg);
+    scheduler_run_pending_tasks();
+#ifdef NODE_GLOBALS
+    __ng_node_id__ = previous_node;
+#endif
+    return true;
+}
+
+void sim_busy_wait(sim_time_t duration)
+{
+    sim_time_t until = current_time + duration;
+    sim_event_t* postponed = NULL;
+    size_t postponed_count = 0;
+
+    uint32_t node = get_node_global_id();
+    busy[node] = true;
+    while(events_count > 0 && events[0].time <= until)
+    {
+        if(busy[events[0].node])
+        {
+            postponed = realloc(postponed, (postponed_count + 1) * sizeof(sim_event_t));
+            assert(postponed != NULL);
+            heap_pop(&postponed[postponed_count++]);
+        }
+        else
+            sim_step(until);
+    }
+
+    busy[node] = false;
+    for(size_t i = 0; i < postponed_count; i++)
+        heap_push(&postponed[i]);
+
+    free(postponed);
+    // a nested busy wait of another node can already have moved the clock beyond 'until'
+    if(until > current_time)
+        current_time = until;
+}
+
+void sim_run(sim_time_t duration)
+{
+    double start = wall_clock();
+    sim_time_t end = current_time + duration;
+    while(sim_step(end));
+
+    current_time = end;
+    stats.wall_time_sec += wall_clock() - start;
+}
+
+const sim_stats_t* sim_get_stats()
+{
+    return &stats;
+}
+
+void sim_print_stats()
+{
+    double virtual_sec = (double)current_time / SIM_TICKS_PER_SEC;
+    printf("SIM: %u nodes, %.3f s virtual time in %.3f s wall time (x%.1f)\n", nodes, virtual_sec, stats.wall_time_sec,
+           stats.wall_time_sec > 0 ? virtual_sec / stats.wall_time_sec : 0.0);
+    printf("SIM: %llu events executed, %llu events queued at peak\n",
+           (unsigned long long)stats.events_executed, (unsigned long long)stats.events_peak);
+}
+
+uint32_t sim_rand()
+{
+    // xorshift64*
+    rand_state ^= rand_state >> 12;
+    rand_state ^= rand_state << 25;
+    rand_state ^= rand_state >> 27;
+    return (uint32_t)((rand_state * UINT64_C(0x2545F4914F6CDD1D)) >> 32);
+}
+
+void sim_set_seed(uint64_t seed)
+{
+    rand_state = seed ? seed : 0x9E3779B97F4A7C15;
+}
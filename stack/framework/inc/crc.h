@@ -25,6 +25,20 @@
  * \ingroup framework
  * @{
  * \brief Implements the CRC calculation according the CCITT CRC16 polynomial
+ *
+ * The CRC can be calculated in one go using crc_calculate(), or incrementally while the data comes in:
+ * \code{.c}
+ * uint16_t crc = crc_init();
+ * crc = crc_update(crc, header, header_length);
+ * crc = crc_update(crc, payload, payload_length);
+ * crc = crc_final(crc);
+ * \endcode
+ * All state is kept by the caller, so the functions are reentrant. crc_update_xor_input() and crc_update_xor_output()
+ * combine the calculation with an XOR of the data, which the PN9 whitening uses to touch every byte only once.
+ *
+ * The implementation is selected with the FRAMEWORK_CRC_SLICES option, trading ROM for speed: 0 computes
+ * the CRC bitwise without lookup table, 1 uses a 512 byte table and 4 or 8 process 4 or 8 bytes per step
+ * using 2 or 4 KiB of tables (slice-by-N).
  * \author maarten.weyn@uantwerpen.be
  */
 
@@ -34,7 +48,45 @@
 
 #include <stdint.h>
 
-uint16_t crc_calculate(uint8_t* data, uint8_t length);
+#define CRC_INITIALIZER 0xFFFF
+
+/*! \brief Returns the initial value of an incremental CRC calculation */
+static inline uint16_t crc_init(void) { return CRC_INITIALIZER; }
+
+/*! \brief Update a CRC with the given data
+ *
+ * \param crc      The CRC calculated over the preceding data, or crc_init() for the first block
+ * \param data     The data
+ * \param length   The length of the data
+ * \return         The updated CRC
+ */
+uint16_t crc_update(uint16_t crc, const uint8_t* data, uint16_t length);
+
+/*! \brief XOR data with a key and update the CRC with the data before the XOR, in a single pass
+ *
+ * This is the transmit side of data whitening: the CRC is calculated over the frame while it is whitened.
+ *
+ * \param crc      The CRC calculated over the preceding data, or crc_init() for the first block
+ * \param dst      Receives src XOR key, can be equal to src
+ * \param src      The data
+ * \param key      The bytes to XOR the data with
+ * \param length   The length of the data
+ * \return         The updated CRC
+ */
+uint16_t crc_update_xor_input(uint16_t crc, uint8_t* dst, const uint8_t* src, const uint8_t* key, uint16_t length);
+
+/*! \brief XOR data with a key and update the CRC with the result, in a single pass
+ *
+ * This is the receive side of data whitening: the CRC is calculated over the frame while it is de-whitened.
+ * The parameters are the same as for crc_update_xor_input().
+ */
+uint16_t crc_update_xor_output(uint16_t crc, uint8_t* dst, const uint8_t* src, const uint8_t* key, uint16_t length);
+
+/*! \brief Returns the CRC after all data is processed by crc_update() */
+static inline uint16_t crc_final(uint16_t crc) { return crc; }
+
+/*! \brief Calculate the CRC of the given data in one go */
+uint16_t crc_calculate(const uint8_t* data, uint16_t length);
 
 #endif /* CRC_H_ */
 
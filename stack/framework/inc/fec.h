@@ -46,18 +46,17 @@ extern "C" {
 #include <stdbool.h>
 #include <stdint.h>
 
-typedef struct {
-	uint8_t cost;
-	uint16_t path;
-} VITERBIPATH;
+#define FEC_DECODER_STATES 8
+
+/*! \brief The soft decision value of a bit which is certainly 1, a certain 0 has value 0 */
+#define FEC_SOFT_ONE 255
 
+/*! \brief The state of a Viterbi decoder, allocated by the caller so multiple frames can be decoded concurrently */
 typedef struct {
-	uint8_t path_size;
-	VITERBIPATH* old;
-	VITERBIPATH* new;
-	VITERBIPATH states1[8];
-	VITERBIPATH states2[8];
-} VITERBISTATE;
+	uint16_t cost[FEC_DECODER_STATES]; // the path metric of every state
+	uint16_t path[FEC_DECODER_STATES]; // the last 16 decoded bits of the surviving path into every state
+	uint8_t path_size; // the number of decoded bytes in the path which are not yet output
+} fec_decoder_t;
 
 //void print_array(uint8_t* buffer, uint8_t length);
 
@@ -65,6 +64,46 @@ uint16_t fec_encode(uint8_t *data, uint16_t nbytes);
 uint16_t fec_decode_packet(uint8_t* data, uint16_t packet_length, uint16_t output_length);
 uint16_t fec_calculated_decoded_length(uint16_t packet_length);
 
+/*! \brief Decode a packet from soft decisions
+ *
+ * \param soft_input     The confidence of every received bit, 8 values per byte with the MSB first,
+ *                       from 0 (certainly 0) to FEC_SOFT_ONE (certainly 1)
+ * \param packet_length  The length of the received packet in bytes, a multiple of 4
+ * \param output         The buffer for the decoded data
+ * \param output_length  The size of the output buffer, at least packet_length / 2
+ * \return               The number of decoded bytes, 0 on error
+ */
+uint16_t fec_decode_packet_soft(const uint8_t* soft_input, uint16_t packet_length, uint8_t* output, uint16_t output_length);
+
+/*! \brief Prepare a decoder to decode a new packet */
+void fec_decoder_init(fec_decoder_t *decoder);
+
+/*! \brief Decode the next 4 byte block of a packet
+ *
+ * A block holds 2 bytes of encoded data, which are output with a delay of one byte.
+ *
+ * \param decoder  The decoder
+ * \param input    The 4 received bytes
+ * \param output   Buffer for up to 2 decoded bytes, can overlap with the input
+ * \return         The number of bytes written to output
+ */
+uint8_t fec_decode_block(fec_decoder_t *decoder, const uint8_t *input, uint8_t *output);
+
+/*! \brief Decode the next 4 byte block of a packet from soft decisions
+ *
+ * \param decoder     The decoder
+ * \param soft_input  32 soft decisions, see fec_decode_packet_soft()
+ * \param output      Buffer for up to 2 decoded bytes
+ * \return            The number of bytes written to output
+ */
+uint8_t fec_decode_block_soft(fec_decoder_t *decoder, const uint8_t *soft_input, uint8_t *output);
+
+/*! \brief Output the last decoded byte still held by the decoder, after the last block of a packet
+ *
+ * \return  The number of bytes written to output (0 or 1)
+ */
+uint8_t fec_decoder_flush(fec_decoder_t *decoder, uint8_t *output);
+
 #ifdef __cplusplus
 }
 #endif
@@ -31,6 +31,7 @@
 #define FIFO_H
 
 #include "types.h"
+#include "errors.h"
 
 /**
  * @brief This struct contains the FIFO state variables
@@ -41,11 +42,20 @@ typedef struct {
     uint16_t head_idx;      /**< The index in buffer to first data byte of the FIFO */
     uint16_t tail_idx;      /**< The index in buffer to first empty byte of the FIFO */
     uint16_t max_size;      /**< The maximum number of bytes contained in the FIFO */
+    uint16_t mask;          /**< max_size - 1 when max_size is a power of two, used instead of a modulo. 0 otherwise */
     uint8_t* buffer;        /**< The buffer where the data is stored*/
     bool is_full;          /**< Used to discern between full and empty when tail_idx == head_idx */
     bool is_subview;
 } fifo_t;
 
+/**
+ * @brief A contiguous span of bytes inside the buffer of a FIFO
+ **/
+typedef struct {
+    uint8_t* data;          /**< The first byte of the span */
+    uint16_t len;           /**< The number of bytes in the span, 0 when the span is not used */
+} fifo_segment_t;
+
 /**
  * @brief Initializes the fifo.
  * @param fifo          Fifo state, initialized by this function
@@ -88,7 +98,19 @@ error_t fifo_put(fifo_t* fifo, uint8_t* data, uint16_t len);
  * @param byte  Byte to be put in the FIFO
  * @returns SUCCESS or ESIZE when data would overwrite head of FIFO
  */
-error_t fifo_put_byte(fifo_t* fifo, uint8_t byte);
+static inline error_t fifo_put_byte(fifo_t* fifo, uint8_t byte)
+{
+    if(fifo->is_subview)
+        return EINVAL;
+
+    if(fifo->is_full)
+        return ESIZE;
+
+    fifo->buffer[fifo->tail_idx] = byte;
+    fifo->tail_idx = (fifo->tail_idx + 1 == fifo->max_size) ? 0 : fifo->tail_idx + 1;
+    fifo->is_full = (fifo->tail_idx == fifo->head_idx);
+    return SUCCESS;
+}
 
 /**
  * @brief Peek at the FIFO contents without popping. Fills buffer with the data in the FIFO starting from head_idx + offset for len bytes
@@ -109,6 +131,23 @@ error_t fifo_peek(fifo_t* fifo, uint8_t* buffer, uint16_t offset, uint16_t len);
  */
 error_t fifo_pop(fifo_t* fifo, uint8_t* buffer, uint16_t len);
 
+/**
+ * @brief Read and pop a single byte from the FIFO
+ * @param fifo      Pointer to the fifo object
+ * @param byte      Pointer to the byte which is read
+ * @returns SUCCESS or ESIZE when FIFO empty
+ */
+static inline error_t fifo_pop_byte(fifo_t* fifo, uint8_t* byte)
+{
+    if(fifo->head_idx == fifo->tail_idx && !fifo->is_full)
+        return ESIZE;
+
+    *byte = fifo->buffer[fifo->head_idx];
+    fifo->head_idx = (fifo->head_idx + 1 == fifo->max_size) ? 0 : fifo->head_idx + 1;
+    fifo->is_full = false;
+    return SUCCESS;
+}
+
 /**
  * @brief Skips bytes from the FIFO
  * @param fifo      Pointer to the fifo object
@@ -138,6 +177,37 @@ uint16_t fifo_get_size(fifo_t* fifo);
  */
 void fifo_get_continuos_raw_data(fifo_t* fifo, uint8_t** pdata, uint16_t* plen);
 
+/**
+ * @brief Gives access to bytes in the FIFO without copying them. Because of the circular buffer the bytes starting from
+ * head_idx + offset for len bytes are returned as up to two spans: the second span is only used when the bytes wrap around
+ * the end of the buffer. The bytes are not popped, use fifo_skip() after they are consumed.
+ * @param fifo      Pointer to the fifo object
+ * @param offset    offset starting from head
+ * @param len       length in number of bytes
+ * @param segments  The two spans which are filled in, segments[1].len is 0 when the bytes do not wrap
+ * @returns SUCCESS or ESIZE when offset + len > current size
+ */
+error_t fifo_peek_segments(fifo_t* fifo, uint16_t offset, uint16_t len, fifo_segment_t segments[2]);
+
+/**
+ * @brief Reserves free space at the tail of the FIFO, so data can be written directly into the buffer instead of being
+ * copied in by fifo_put(). The space is returned as up to two spans, like fifo_peek_segments(). The written bytes are only
+ * added to the FIFO by fifo_commit(), until then the FIFO is not modified.
+ * @param fifo      Pointer to the fifo object
+ * @param len       number of bytes to reserve
+ * @param segments  The two spans which are filled in, segments[1].len is 0 when the space does not wrap
+ * @returns SUCCESS, ESIZE when there is less than len bytes of free space, or EINVAL when fifo is a subview
+ */
+error_t fifo_reserve(fifo_t* fifo, uint16_t len, fifo_segment_t segments[2]);
+
+/**
+ * @brief Adds bytes which were written in the space returned by fifo_reserve() to the FIFO
+ * @param fifo      Pointer to the fifo object
+ * @param len       number of bytes written, this can be less than the number of bytes reserved
+ * @returns SUCCESS, ESIZE when there is less than len bytes of free space, or EINVAL when fifo is a subview
+ */
+error_t fifo_commit(fifo_t* fifo, uint16_t len);
+
 /**
  * @brief Returns if the FIFO is completely full or if there is still space left
  * @param fifo      Pointer to the fifo object
@@ -152,6 +222,93 @@ bool fifo_is_full(fifo_t* fifo);
  */
 error_t fifo_remove_last_byte(fifo_t* fifo);
 
+/**
+ * @brief A FIFO which is shared between a single producer and a single consumer, for example an interrupt handler which
+ * receives bytes and a task which processes them, without a critical section on either side.
+ *
+ * The producer only writes tail and the consumer only writes head, so unlike fifo_t no state is written by both sides.
+ * Both indices run freely and are only masked when the buffer is accessed, the number of bytes in the FIFO is the
+ * difference between them. This requires the size of the buffer to be a power of two.
+ * The indices are published with release semantics and read with acquire semantics, so the bytes are written to
+ * (or read from) the buffer before the other side can see the updated index.
+ *
+ * The producer uses fifo_put_from_isr(), all other functions are for the consumer, except for the initialisation
+ * functions which may only be called while neither side accesses the FIFO.
+ **/
+typedef struct {
+    uint8_t* buffer;        /**< The buffer where the data is stored*/
+    uint16_t mask;          /**< The size of the buffer - 1 */
+    volatile uint16_t head; /**< The number of bytes popped, only written by the consumer */
+    volatile uint16_t tail; /**< The number of bytes put, only written by the producer */
+} fifo_spsc_t;
+
+/**
+ * @brief Initializes the single producer single consumer fifo.
+ * @param fifo          Fifo state, initialized by this function
+ * @param buffer        The buffer used for the fifo
+ * @param max_size      The size of the buffer, a power of two between 1 and 32768
+ * @returns SUCCESS or EINVAL when max_size is not a power of two
+ */
+error_t fifo_spsc_init(fifo_spsc_t* fifo, uint8_t* buffer, uint16_t max_size);
+
+/**
+ * @brief Initializes the single producer single consumer fifo with a pre-filled buffer
+ * @param fifo          Fifo state, initialized by this function
+ * @param buffer        The buffer used for the fifo
+ * @param filled_size   The length of the pre-filled buffer
+ * @param max_size      The size of the buffer, a power of two between 1 and 32768
+ * @returns SUCCESS or EINVAL when max_size is not a power of two
+ */
+error_t fifo_spsc_init_filled(fifo_spsc_t* fifo, uint8_t* buffer, uint16_t filled_size, uint16_t max_size);
+
+/**
+ * @brief Put bytes in to the FIFO from the producer side. Either all bytes are put or none at all.
+ * @param fifo  Pointer to the fifo object
+ * @param data  Pointer to the data to be put in the FIFO
+ * @param len   Number of bytes to put in the FIFO
+ * @returns SUCCESS or ESIZE when data would overwrite head of FIFO
+ */
+error_t fifo_put_from_isr(fifo_spsc_t* fifo, const uint8_t* data, uint16_t len);
+
+/**
+ * @brief Returns the number of bytes currently in the FIFO. More bytes can be added by the producer at any time.
+ * @param fifo      Pointer to the fifo object
+ * @return Number of bytes currently in the FIFO
+ */
+uint16_t fifo_spsc_get_size(fifo_spsc_t* fifo);
+
+/**
+ * @brief Peek at the FIFO contents without popping, see fifo_peek()
+ * @returns SUCCESS or ESIZE when offset + len > current size
+ */
+error_t fifo_spsc_peek(fifo_spsc_t* fifo, uint8_t* buffer, uint16_t offset, uint16_t len);
+
+/**
+ * @brief Skips bytes from the FIFO, which makes room for the producer
+ * @param fifo      Pointer to the fifo object
+ * @param len       number of bytes to skip
+ * @returns SUCCESS or ESIZE if len > current size
+ */
+error_t fifo_spsc_skip(fifo_spsc_t* fifo, uint16_t len);
+
+/**
+ * @brief Drops all bytes currently in the FIFO
+ * @param fifo      Pointer to the fifo object
+ */
+void fifo_spsc_clear(fifo_spsc_t* fifo);
+
+/**
+ * @brief Initializes a fifo_t which is a subset of the bytes in the FIFO, starting from its head, so the bytes can be parsed
+ * with the fifo_t functions. Like for fifo_init_subview(), popping from the subset does not change the head of the original
+ * FIFO, use fifo_spsc_skip() to remove the parsed bytes.
+ * @param subset_fifo   The fifo containing the subset
+ * @param original_fifo The original fifo
+ * @param offset        The offset which will be used as the subset's head (starting from original_fifo's head)
+ * @param subset_size   The size of the subset
+ * @returns SUCCESS or ESIZE when offset + subset_size > current size
+ */
+error_t fifo_spsc_init_subview(fifo_t* subset_fifo, fifo_spsc_t* original_fifo, uint16_t offset, uint16_t subset_size);
+
 #endif // FIFO_H
 
 /** @}*/
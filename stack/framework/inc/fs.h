@@ -97,6 +97,12 @@ uint32_t fs_get_address(uint8_t file_id);
 
 error_t fs_register_block_device(blockdevice_t* block_device, uint8_t bd_index);
 
+/*! \brief Writes back the data buffered by the blockdevices, the write-back cache of the permanent storage when
+ * FRAMEWORK_FS_WRITE_BACK_CACHE is enabled. This is done automatically FRAMEWORK_FS_WRITE_BACK_CACHE_FLUSH_DELAY seconds
+ * after the first write and on a brownout (see hw_brownout_detected()), but should also be called before a reset.
+ */
+error_t fs_flush();
+
 #endif /* FS_H_ */
 
 /** @}*/
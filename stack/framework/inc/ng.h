@@ -20,6 +20,7 @@
 #ifndef NG_H_
 #define NG_H_
 #include "link_c.h"
+#include <stddef.h>
 //#include "platform.h"
 
 #ifdef __cplusplus
@@ -27,7 +28,6 @@ extern "C" {
 #endif //__cplusplus
 
 #if defined(NODE_GLOBALS)
-#include <stddef.h>
 #include <debug.h>
 #ifndef NODE_GLOBALS_MAX_NODES
     #warning NODE_GLOBALS_MAX_NODES is not defined. Using default value of 256
@@ -50,6 +50,10 @@ static inline size_t get_node_global_id() { assert(__ng_node_id__ < __ng_max_nod
 #define NGDEF(var)	(__ng_single_ ## var ## __)
 #define NG(var)		(__ng_single_ ## var ## __)
 
+// without node globals there is only a single node, with id 0
+static inline void set_node_global_id(size_t node_id) {}
+static inline size_t get_node_global_id() { return 0; }
+
 
 #endif //defined(NODE_GLOBALS)
 
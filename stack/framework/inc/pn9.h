@@ -26,6 +26,8 @@
  * @{
  * \brief Implements the PN9 Encoder used for data whitening
  *
+ * The whitening sequence always starts from PN9_INITIALIZER and repeats after 511 bytes, so it is stored
+ * as a precomputed table which is XOR'ed with the data a word at a time.
  */
 
 #ifndef PN9_H_
@@ -40,6 +42,24 @@
  */
 void pn9_encode(uint8_t *data, uint16_t length);
 
+/*
+ * Continue whitening a frame of which the first 'offset' bytes are already processed by pn9_encode(),
+ * data points to the byte at 'offset' in the frame
+ */
+void pn9_encode_from(uint8_t *data, uint16_t length, uint16_t offset);
+
+/*
+ * Whiten 'length' bytes of a frame starting at 'offset' from src into dst, while updating the CRC with the
+ * original bytes. dst can be equal to src. Returns the updated CRC, see crc_update().
+ */
+uint16_t pn9_encode_crc(uint8_t *dst, const uint8_t *src, uint16_t length, uint16_t offset, uint16_t crc);
+
+/*
+ * De-whiten 'length' bytes of a frame starting at 'offset' in place, while updating the CRC with the
+ * de-whitened bytes. Returns the updated CRC, see crc_update().
+ */
+uint16_t pn9_decode_crc(uint8_t *data, uint16_t length, uint16_t offset, uint16_t crc);
+
 #endif // PN9_H_
 
 /** @}*/
@@ -35,12 +35,23 @@
 
 #define POWER_TRACKING_FILE_ID   FRAMEWORK_POWER_TRACKING_FILE_ID
 
+// the low power modes passed to hw_enter_lowpower_mode() for which the residency is tracked
+#define POWER_TRACKING_LP_MODES 3
+
 #ifdef FRAMEWORK_POWER_TRACKING_RF
-#define POWER_TRACKING_FILE_SIZE 17
+#define POWER_TRACKING_FILE_RF_SIZE 12
 #else
-#define POWER_TRACKING_FILE_SIZE 5
+#define POWER_TRACKING_FILE_RF_SIZE 0
 #endif // FRAMEWORK_POWER_TRACKING_RF
 
+#ifdef FRAMEWORK_POWER_TRACKING_LP_MODES
+#define POWER_TRACKING_FILE_LP_MODES_SIZE (POWER_TRACKING_LP_MODES * 8)
+#else
+#define POWER_TRACKING_FILE_LP_MODES_SIZE 0
+#endif // FRAMEWORK_POWER_TRACKING_LP_MODES
+
+#define POWER_TRACKING_FILE_SIZE (5 + POWER_TRACKING_FILE_RF_SIZE + POWER_TRACKING_FILE_LP_MODES_SIZE)
+
 typedef enum
 {
     POWER_TRACKING_LORA = 0,
@@ -80,6 +91,10 @@ typedef struct
             timer_tick_t temp_rx_time;
             timer_tick_t temp_standby_time;
 #endif // FRAMEWORK_POWER_TRACKING_RF
+#ifdef FRAMEWORK_POWER_TRACKING_LP_MODES
+            uint32_t lp_mode_count[POWER_TRACKING_LP_MODES]; // the number of times each low power mode was entered
+            timer_tick_t lp_mode_time[POWER_TRACKING_LP_MODES]; // the time spent in each low power mode
+#endif // FRAMEWORK_POWER_TRACKING_LP_MODES
         } __attribute__((__packed__));
     };
 } power_tracking_file_t;
@@ -90,6 +105,9 @@ error_t power_tracking_register_run_time(timer_tick_t time);
 error_t power_tracking_register_radio_action(power_tracking_transmit_mode_t power_tracking_transmit_mode,
     power_tracking_radio_type_t type, timer_tick_t time, void* argument);
 #endif // FRAMEWORK_POWER_TRACKING_RF
+#ifdef FRAMEWORK_POWER_TRACKING_LP_MODES
+error_t power_tracking_register_lp_mode_time(uint8_t mode, timer_tick_t time);
+#endif // FRAMEWORK_POWER_TRACKING_LP_MODES
 error_t power_tracking_file_initialize();
 error_t power_tracking_persist_file();
 void power_tracking_file_toggle_persisting(bool persist);
@@ -37,6 +37,16 @@
  */
 typedef void (*task_t)(void *arg);
 
+/*! \brief Type definition for the handle of a registered task, see sched_register_task_id()
+ *
+ */
+typedef uint8_t sched_task_id_t;
+
+/*! \brief The sched_task_id_t which does not refer to any registered task
+ *
+ */
+#define SCHED_INVALID_TASK_ID ((sched_task_id_t)0xFF)
+
 /*! \brief Initialise the scheduler sub system. 
  *
  * This function is called while bootstrapping the framework. On no account should you call this function 
@@ -58,6 +68,18 @@ __LINK_C void scheduler_init();
  */
 __LINK_C void scheduler_run();
 
+/*! \brief Execute all pending tasks and return
+ *
+ * This function executes a single iteration of the main task loop: all pending tasks are executed
+ * (according to priority) until the task queues are empty, after which the function returns without
+ * putting the MCU to sleep. scheduler_run() is built on top of this function.
+ *
+ * This is intended for platforms that drive the scheduler themselves, such as the NATIVE simulator which
+ * steps a number of node instances on a shared virtual clock. On NO ACCOUNT should this function be called
+ * by the application.
+ */
+__LINK_C void scheduler_run_pending_tasks();
+
 enum
 {
 	/*! \brief The minimum allowed priority for scheduled tasks
@@ -100,6 +122,9 @@ __LINK_C error_t sched_register_task_allow_multiple(task_t task, bool allow);
 static inline error_t sched_register_task(task_t task) { return sched_register_task_allow_multiple(task, false);}
 
 /*! \brief Post a task with the given priority
+ *
+ * The task is looked up in the table of registered tasks first, callers which post a task often should cache its
+ * handle and use sched_post_task_id() instead.
  *
  * \param task		The task to be executed by the scheduler
  * \param priority	The priority of the task
@@ -123,6 +148,24 @@ __LINK_C error_t sched_post_task_prio(task_t task, uint8_t priority, void *arg);
  */
 static inline error_t sched_post_task(task_t task) { return sched_post_task_prio(task,DEFAULT_PRIORITY, NULL);}
 
+/*! \brief Post a task which has to be executed before the given deadline
+ *
+ * Tasks posted with a deadline are executed before the tasks of all priorities, in order of their deadline (earliest
+ * deadline first). Tasks with the same deadline are executed in the order in which they were posted. When a task did not
+ * finish before its deadline this is counted, see sched_get_missed_deadlines().
+ * The D7A stack itself does not post tasks with a deadline (yet), its work is still posted with fixed priorities.
+ *
+ * \param task		The task to be executed by the scheduler
+ * \param deadline	The absolute deadline, in timer ticks (see timer_get_counter_value())
+ * \param arg		The argument passed to the task
+ *
+ * \return error_t	SUCCESS if the task was successfully scheduled
+ *			EINVAL if the task was not registered with the scheduler
+ *			EALREADY if the task was already scheduled. If this is the case,
+ *			the task will be executed but only once.
+ */
+__LINK_C error_t sched_post_task_deadline(task_t task, timer_tick_t deadline, void *arg);
+
 /*! \brief Cancel an already scheduled task
  *
  * \param task		The task to cancel
@@ -160,9 +203,147 @@ __LINK_C bool sched_is_scheduled_with_arg(task_t task, void *arg);
  */
 static inline bool sched_is_scheduled(task_t task) { return sched_is_scheduled_with_arg(task, NULL);}
 
+/*! \brief Register a task with the task scheduler and return a handle to it.
+ *
+ *  Every call reserves a new slot for the task, like sched_register_task_allow_multiple() with allow set to true.
+ *  The returned id can be cached by the caller and passed to sched_post_task_id(), sched_cancel_task_id() and
+ *  sched_is_scheduled_id(), which index the task table directly instead of searching it for the task. A task registered
+ *  this way can also still be posted using the task_t based functions.
+ *  If the task could not be registered due to memory constraints this will assert.
+ *
+ * \param task		The task to register
+ *
+ * \return sched_task_id_t	The handle of the registered task
+ */
+__LINK_C sched_task_id_t sched_register_task_id(task_t task);
+
+/*! \brief Returns the handle of a task which was registered using the task_t based functions
+ *
+ *  When the task was registered multiple times, the handle of one of these registrations is returned.
+ *
+ * \param task		The task to look up
+ *
+ * \return sched_task_id_t	The handle of the task or SCHED_INVALID_TASK_ID if the task was not registered
+ */
+__LINK_C sched_task_id_t sched_get_task_id(task_t task);
+
+/*! \brief Post a registered task with the given priority, in constant time
+ *
+ * \param id		The handle of the task to be executed by the scheduler
+ * \param priority	The priority of the task
+ * \param arg		The argument passed to the task
+ *
+ * \return error_t	SUCCESS if the task was successfully scheduled
+ *			EINVAL if the id does not refer to a registered task
+ *			ESIZE if the priority is not between MAX_PRIORITY and MIN_PRIORITY
+ *			EALREADY if the task was already scheduled. If this is the case,
+ *			the task will be executed but only once, with the argument it was first posted with.
+ */
+__LINK_C error_t sched_post_task_id(sched_task_id_t id, uint8_t priority, void *arg);
+
+/*! \brief Post a registered task which has to be executed before the given deadline, see sched_post_task_deadline()
+ *
+ * The task is inserted in the list of deadline tasks in order of its deadline, so this takes linear time in the number
+ * of pending deadline tasks.
+ *
+ * \param id		The handle of the task to be executed by the scheduler
+ * \param deadline	The absolute deadline, in timer ticks (see timer_get_counter_value())
+ * \param arg		The argument passed to the task
+ *
+ * \return error_t	SUCCESS if the task was successfully scheduled
+ *			EINVAL if the id does not refer to a registered task
+ *			EALREADY if the task was already scheduled. If this is the case,
+ *			the task will be executed but only once, with the argument and deadline it was first posted with.
+ */
+__LINK_C error_t sched_post_task_id_deadline(sched_task_id_t id, timer_tick_t deadline, void *arg);
+
+/*! \brief Returns the number of tasks posted with a deadline which did not finish before their deadline */
+__LINK_C uint32_t sched_get_missed_deadlines();
+
+/*! \brief Post a registered task from interrupt context
+ *
+ * Unlike the other post functions this does not disable interrupts to modify the task lists: the task is appended to
+ * a queue using atomic instructions only, and moved to the task lists by the scheduler before it selects the next task
+ * to execute. Tasks posted from interrupt context are executed in the order in which they were posted (within their
+ * priority). Until then the task counts as scheduled, and it can not be posted again.
+ *
+ * \param id		The handle of the task to be executed by the scheduler
+ * \param priority	The priority of the task
+ * \param arg		The argument passed to the task
+ *
+ * \return error_t	SUCCESS if the task was successfully queued
+ *			EINVAL if the id does not refer to a registered task
+ *			ESIZE if the priority is not between MAX_PRIORITY and MIN_PRIORITY
+ *			EALREADY if the task was already scheduled. If this is the case,
+ *			the task will be executed but only once, with the argument it was first posted with.
+ */
+__LINK_C error_t sched_post_task_id_from_isr(sched_task_id_t id, uint8_t priority, void *arg);
+
+/*! \brief Cancel a scheduled task, in constant time
+ *
+ * \param id		The handle of the task to cancel
+ *
+ * \return error_t	SUCCESS if the task was cancelled successfully
+ * 			EINVAL if the id does not refer to a registered task
+ *			EALREADY if the task was not scheduled or has already been executed
+ */
+__LINK_C error_t sched_cancel_task_id(sched_task_id_t id);
+
+/*! \brief Check whether a task is scheduled to be executed, in constant time
+ *
+ * \param id		The handle of the task to check
+ *
+ * \return bool		TRUE if the task is scheduled, FALSE otherwise
+ */
+__LINK_C bool sched_is_scheduled_id(sched_task_id_t id);
+
+/*! \brief The run time statistics of a registered task, collected when FRAMEWORK_SCHEDULER_PROFILING is enabled
+ *
+ * All times are in timer ticks. The queueing delay is the time between posting the task and the start of its execution.
+ */
+typedef struct
+{
+	uint32_t invocations;
+	uint32_t total_run_time;
+	uint32_t max_run_time;
+	uint32_t total_queue_delay;
+	uint32_t max_queue_delay;
+	uint32_t missed_deadlines;
+} sched_task_stats_t;
+
+/*! \brief Returns the run time statistics of a registered task
+ *
+ * Only available when FRAMEWORK_SCHEDULER_PROFILING is enabled. The ids of the registered tasks are numbered from 0, so
+ * all statistics can be retrieved by incrementing the id until EINVAL is returned.
+ *
+ * \param id		The handle of the task
+ * \param task		Returns the task which was registered with this handle
+ * \param stats		Returns the statistics of the task
+ *
+ * \return error_t	SUCCESS if the statistics were returned
+ *			EINVAL if the id does not refer to a registered task
+ */
+__LINK_C error_t sched_get_task_stats(sched_task_id_t id, task_t* task, sched_task_stats_t* stats);
+
+/*! \brief Clears the run time statistics of all tasks
+ *
+ * Only available when FRAMEWORK_SCHEDULER_PROFILING is enabled.
+ */
+__LINK_C void sched_reset_task_stats();
+
 __LINK_C uint8_t sched_get_low_power_mode(void);
 __LINK_C void    sched_set_low_power_mode(uint8_t mode);
 
+/*! \brief Returns the low power mode the scheduler enters when it becomes idle now
+ *
+ * Without FRAMEWORK_SCHEDULER_TICKLESS_IDLE this is always the mode set by sched_set_low_power_mode(). Otherwise that
+ * mode is the deepest mode which is used: the scheduler selects the deepest mode up to that mode which is available and
+ * whose wakeup latency (see hw_get_lowpower_mode_wakeup_latency()) does not exceed the time until the next timer event.
+ *
+ * \return uint8_t	The low power mode, as passed to hw_enter_lowpower_mode()
+ */
+__LINK_C uint8_t sched_select_low_power_mode(void);
+
 /*! \brief Check whether a task is the watchdog task and if we're nearing a watchdog reset
  *
  * \param task          The task to be checked
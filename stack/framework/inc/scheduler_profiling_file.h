@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*! \file scheduler_profiling_file.h
+ * \addtogroup scheduler
+ * \ingroup framework
+ * @{
+ * \brief Exposes the run time statistics collected by the scheduler in a D7A file
+ *
+ * The file is stored in volatile storage and refreshed periodically, it can be read over ALP to find the tasks which
+ * take the most time on a deployed node. It contains the time over which the statistics were collected, followed by
+ * the statistics of the FRAMEWORK_SCHEDULER_PROFILING_FILE_ENTRIES tasks with the longest maximum run time (see
+ * sched_task_stats_t). All fields are little endian and times are in timer ticks. Tasks are identified by the address
+ * of the task function, which can be looked up in the map file of the firmware. Unused entries are zero.
+ *
+ * Writing any data to the file resets the statistics.
+ */
+#ifndef __SCHEDULER_PROFILING_FILE_H
+#define __SCHEDULER_PROFILING_FILE_H
+
+#include "errors.h"
+#include "framework_defs.h"
+#include "scheduler.h"
+#include "stdint.h"
+
+#define SCHEDULER_PROFILING_FILE_ID FRAMEWORK_SCHEDULER_PROFILING_FILE_ID
+#define SCHEDULER_PROFILING_FILE_ENTRY_SIZE 28
+#define SCHEDULER_PROFILING_FILE_SIZE (4 + FRAMEWORK_SCHEDULER_PROFILING_FILE_ENTRIES * SCHEDULER_PROFILING_FILE_ENTRY_SIZE)
+
+typedef struct __attribute__((__packed__))
+{
+    uint32_t task;
+    sched_task_stats_t stats;
+} scheduler_profiling_file_entry_t;
+
+typedef struct
+{
+    union
+    {
+        uint8_t bytes[SCHEDULER_PROFILING_FILE_SIZE];
+        struct
+        {
+            uint32_t profiling_time;
+            scheduler_profiling_file_entry_t entries[FRAMEWORK_SCHEDULER_PROFILING_FILE_ENTRIES];
+        } __attribute__((__packed__));
+    };
+} scheduler_profiling_file_t;
+
+/*! \brief Create the scheduler profiling file and start refreshing it periodically
+ *
+ * \return error_t	SUCCESS if the file was created
+ *			another error code if the file could not be created, for example because there is no room left in volatile storage
+ */
+error_t scheduler_profiling_file_initialize();
+
+/*! \brief Refresh the contents of the scheduler profiling file with the current statistics
+ */
+error_t scheduler_profiling_file_update();
+
+#endif
+
+/** @}*/
@@ -39,6 +39,10 @@
  * 1,5 days (32KHz timer) and 48 days (1MS ticks). timer_get_counter_value() therefore always
  * returns the time since system bootup (or since the last overflow)
  *
+ * Internally the timer keeps a 64-bit monotonic time (see timer_get_time64()) which does not overflow during the
+ * lifetime of a device. Timer events are ordered on this time, so events keep firing in the right order when the
+ * 32-bit counter loops back to zero.
+ *
  * \author maarten.weyn@uantwerpen.be
  * \author daniel.vandenakker@uantwerpen.be
  *
@@ -56,7 +60,10 @@
 #define FRAMEWORK_TIMER_RESOLUTION 1MS
 #endif
 
-typedef uint32_t timer_tick_t;
+/*! \brief Identifies a single pending timer event, see timer_post_task_prio_handle() */
+typedef uint32_t timer_handle_t;
+
+#define TIMER_HANDLE_NONE 0
 
 typedef struct
 {
@@ -65,8 +72,17 @@ typedef struct
     uint8_t priority;
     void *arg;
     timer_tick_t period;
+    timer_tick_t slack;
+    timer_handle_t handle; // set by timer_add_event()
 } timer_event;
 
+typedef struct
+{
+    uint32_t wakeups; // the number of times the hw timer woke up the timer to fire an event
+    uint32_t events_fired;
+    uint32_t wakeups_saved; // the number of events fired early in the wakeup of another event, see timer_post_task_prio()
+} timer_stats_t;
+
 //a bit of dirty macro evaluation to prepend HWTIMER_FREQ_ to the value of 'FRAMEWORK_TIMER_RESOLUTION'
 #define ___CONCAT2(a,b) a ## b
 #define ___CONCAT(a, b) ___CONCAT2(a,b)
@@ -108,6 +124,15 @@ __LINK_C void timer_init();
  */
 __LINK_C timer_tick_t timer_get_counter_value();
 
+/*! \brief Retrieve the 64-bit monotonic time of the timer
+ *
+ * The returned value is the number of clock ticks since the device booted, it does not loop back to zero.
+ * The lower 32 bits are equal to timer_get_counter_value().
+ *
+ * \return uint64_t	The current time, in timer ticks.
+ */
+__LINK_C uint64_t timer_get_time64();
+
 /*! \brief Post a task to be scheduled at a given time with a given priority
  *
  * The time parameter denotes the clock tick at which the task is to be scheduled
@@ -125,6 +150,15 @@ __LINK_C timer_tick_t timer_get_counter_value();
  * This equates to checking whether time < cur_time, except that it also works when the timer is about
  * to overflow.
  *
+ * Tasks which do not have to be executed at an exact time can be posted with slack: the task is then
+ * scheduled somewhere between time and time + slack. The timer only wakes up at the end of this window,
+ * and all events whose window has started by then are fired in the same wakeup. This way events whose windows
+ * overlap only cost a single wakeup, see timer_get_stats().
+ *
+ * An event is identified by its task and argument: posting a task again with the same argument updates the pending
+ * event, while posting it with another argument adds a new event. A task which has multiple events pending at the
+ * same time has to be registered with sched_register_task_allow_multiple(), otherwise the scheduler executes it only once.
+ *
  * Please note that posting a task with the framework timers does NOT automatically register
  * it with the scheduler. If the posted task is not registered with the scheduler, the task
  * will not be executed.
@@ -133,21 +167,35 @@ __LINK_C timer_tick_t timer_get_counter_value();
  * \param time		The time at which to schedule the task for execution.
  * \param priority	The priority with which the task should be executed
  * \param period    The period on which the task should be repeated (0 is not repeated)
+ * \param slack     The number of ticks the execution of the task can be delayed to share a wakeup with other events
  *
  * \returns error_t	SUCCESS if the task was posted successfully
  *					ENOMEM if the task could not be posted there are already too
  *						   many tasks waiting for execution.
- * 					EALREADY if the task was already scheduled.
+ * 					EALREADY if the task was already scheduled with the same argument and another priority.
  *					EINVAL if an invalid priority was specified.
  *
  */
-__LINK_C error_t timer_post_task_prio(task_t task, timer_tick_t time, uint8_t priority, timer_tick_t period, void *arg);
+__LINK_C error_t timer_post_task_prio(task_t task, timer_tick_t time, uint8_t priority, timer_tick_t period, timer_tick_t slack, void *arg);
+
+/*! \brief Post a task like timer_post_task_prio() and return the handle of the event
+ *
+ * The handle identifies this single event and can be passed to timer_cancel_handle() and timer_is_handle_scheduled(),
+ * which do not affect the other events of the same task. A handle stays valid until the event is cancelled or fired,
+ * for periodic events until they are cancelled. Afterwards it never matches another event.
+ *
+ * \param handle	Returns the handle of the event, or TIMER_HANDLE_NONE when the task was not posted as a timer event
+ *
+ * \returns error_t	the same as timer_post_task_prio()
+ */
+__LINK_C error_t timer_post_task_prio_handle(task_t task, timer_tick_t time, uint8_t priority, timer_tick_t period,
+                                             timer_tick_t slack, void *arg, timer_handle_t *handle);
 
 /*! \brief Post a task \<task\> to be scheduled at a given \<time\> with the default priority.
  *
  * This function is equivalent to
  * \code{.c}
- * 	timer_post_task_prio(task,time,DEFAULT_PRIORITY);
+ * 	timer_post_task_prio(task,time,DEFAULT_PRIORITY,0,0,NULL);
  * \endcode
  *
  * See the comments above 'timer_post_task_prio()' for a more detailed explanation.
@@ -161,7 +209,7 @@ __LINK_C error_t timer_post_task_prio(task_t task, timer_tick_t time, uint8_t pr
  *						   many tasks waiting for execution.
  * 					EALREADY if the task was already scheduled.
  */
-inline error_t timer_post_task(task_t task, timer_tick_t time) { return timer_post_task_prio(task,time,DEFAULT_PRIORITY,0,NULL);}
+inline error_t timer_post_task(task_t task, timer_tick_t time) { return timer_post_task_prio(task,time,DEFAULT_PRIORITY,0,0,NULL);}
 
 
 /*! \brief Post a task \<task\> to be scheduled with a certain \<delay\> with a given \<priority\>
@@ -187,7 +235,7 @@ inline error_t timer_post_task(task_t task, timer_tick_t time) { return timer_po
  */
 inline error_t timer_post_task_prio_delay(task_t task, timer_tick_t delay, uint8_t priority)
 {
-    return timer_post_task_prio(task, timer_get_counter_value() + delay, priority, 0, NULL);
+    return timer_post_task_prio(task, timer_get_counter_value() + delay, priority, 0, 0, NULL);
 }
 /*! \brief Post a task to be scheduled with a certain \<delay\> with the default priority.
  *
@@ -224,6 +272,8 @@ error_t timer_init_event(timer_event* event, task_t callback);
 error_t timer_add_event(timer_event* event);
 
 /*! \brief Cancel a previously scheduled task
+ *
+ * All pending events of the task are cancelled, whatever their argument.
  *
  * \param task	The task to cancel.
  *
@@ -233,6 +283,25 @@ error_t timer_add_event(timer_event* event);
  */
 __LINK_C error_t timer_cancel_task(task_t task);
 
+/*! \brief Cancel the event of a task which was scheduled with the given argument
+ *
+ * \param task	The task to cancel.
+ * \param arg	The argument with which the task was scheduled
+ *
+ * \return error_t	SUCCESS if the event was successfully canceled
+ * 					EALREADY if the task was not scheduled with this argument and therefore not canceled
+ */
+__LINK_C error_t timer_cancel_task_with_arg(task_t task, void *arg);
+
+/*! \brief Cancel the event with the given handle
+ *
+ * \param handle	The handle returned by timer_post_task_prio_handle()
+ *
+ * \return error_t	SUCCESS if the event was successfully canceled
+ * 					EALREADY if the event already fired or was cancelled
+ */
+__LINK_C error_t timer_cancel_handle(timer_handle_t handle);
+
 /*! \brief check if a task is already scheduled with a delay
  *
  * \param task	The task to verify.
@@ -243,9 +312,35 @@ __LINK_C error_t timer_cancel_task(task_t task);
  */
 __LINK_C bool timer_is_task_scheduled(task_t task);
 
+/*! \brief check if the event with the given handle is still pending
+ *
+ * \param handle	The handle returned by timer_post_task_prio_handle()
+ *
+ * \return bool	true if the event is present in the timer event queue
+ * 				false if the event already fired or was cancelled
+ */
+__LINK_C bool timer_is_handle_scheduled(timer_handle_t handle);
+
+/*! \brief Returns the fire time of the first pending timer event
+ *
+ * \param fire_time	Returns the absolute fire time of the first event, in timer ticks
+ *
+ * \return bool	true if an event is pending
+ * 				false if no events are pending, fire_time is not modified
+ */
+__LINK_C bool timer_get_next_event_time(timer_tick_t* fire_time);
+
+/*! \brief Returns the statistics of the timer since timer_init()
+ *
+ * \param stats	Returns the statistics
+ */
+__LINK_C void timer_get_stats(timer_stats_t* stats);
+
 /**
  * @brief Cancel an event
  *
+ * Only this event is cancelled, other events of the same task are not affected.
+ *
  * @param[in] event Structure containing the event parameters
  */
 void timer_cancel_event(timer_event* event);
@@ -39,4 +39,9 @@ typedef int error_t;	//use 'int' since it matches the value expected for errors
 
 typedef const char * string_t;
 
+/* \brief a time or duration in ticks of the timer framework, see timer.h
+ *
+ */
+typedef uint32_t timer_tick_t;
+
 #endif // __FRM_TYPES_H__
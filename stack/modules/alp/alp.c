@@ -19,6 +19,7 @@
 
 #include "stdlib.h"
 #include "debug.h"
+#include "ng.h"
 #include "errors.h"
 #include "string.h"
 #include "modules_defs.h"
@@ -39,7 +40,8 @@
   #define DPRINT_DATA(...)
 #endif
 
-alp_interface_t* interfaces[MODULE_ALP_INTERFACE_CNT];
+alp_interface_t* NGDEF(_interfaces)[MODULE_ALP_INTERFACE_CNT];
+#define interfaces NG(_interfaces)
 
 alp_status_codes_t alp_register_interface(alp_interface_t* itf)
 {
@@ -58,7 +60,7 @@ alp_status_codes_t alp_register_interface(alp_interface_t* itf)
 bool alp_parse_length_operand(fifo_t* cmd_fifo, uint32_t* length)
 {
     uint8_t len = 0;
-    if(fifo_pop(cmd_fifo, &len, 1) != SUCCESS)
+    if(fifo_pop_byte(cmd_fifo, &len) != SUCCESS)
         return false;
     uint8_t field_len = len >> 6;
     if(field_len == 0) {
@@ -68,7 +70,7 @@ bool alp_parse_length_operand(fifo_t* cmd_fifo, uint32_t* length)
 
     *length = (len & 0x3F) << ( 8 * field_len); // mask field length specificier bits and shift before adding other length bytes
     for(; field_len > 0; field_len--) {
-        if(fifo_pop(cmd_fifo, &len, 1) != SUCCESS)
+        if(fifo_pop_byte(cmd_fifo, &len) != SUCCESS)
             return false;
         *length += len << (8 * (field_len - 1));
     }
@@ -102,7 +104,7 @@ bool alp_append_length_operand(alp_command_t* command, uint32_t length) {
 
 bool alp_parse_file_offset_operand(fifo_t* cmd_fifo, alp_operand_file_offset_t* operand)
 {
-    if(fifo_pop(cmd_fifo, &operand->file_id, 1) != SUCCESS)
+    if(fifo_pop_byte(cmd_fifo, &operand->file_id) != SUCCESS)
         return false;
     return alp_parse_length_operand(cmd_fifo, &operand->offset);
 }
@@ -214,7 +216,7 @@ static bool parse_operand_status(alp_command_t* command, alp_action_t* action, b
         //TODO implement handling of action status
     } else if (!b7 && b6) {
         //interface status operation
-        if(fifo_pop(cmd_fifo, &action->interface_status.itf_id, 1) != SUCCESS)
+        if(fifo_pop_byte(cmd_fifo, &action->interface_status.itf_id) != SUCCESS)
             return false;
         DPRINT("itf status (%i)", action->interface_status.itf_id);
         uint32_t temp_len;
@@ -235,7 +237,7 @@ static bool parse_operand_status(alp_command_t* command, alp_action_t* action, b
 static bool parse_op_forward(alp_command_t* command, alp_action_t* action)
 {
     fifo_t* cmd_fifo = &command->alp_command_fifo;
-    if(fifo_pop(cmd_fifo, &action->interface_config.itf_id, 1) != SUCCESS)
+    if(fifo_pop_byte(cmd_fifo, &action->interface_config.itf_id) != SUCCESS)
         return false;
 
     if (action->interface_config.itf_id == ALP_ITF_ID_D7ASP) {
@@ -261,7 +263,7 @@ static bool parse_op_forward(alp_command_t* command, alp_action_t* action)
 
 static bool parse_operand_file_id(alp_command_t* command, alp_action_t* action)
 {
-    if(fifo_pop(&command->alp_command_fifo, &action->file_id_operand.file_id, 1) != SUCCESS)
+    if(fifo_pop_byte(&command->alp_command_fifo, &action->file_id_operand.file_id) != SUCCESS)
         return false;
     DPRINT("READ FILE PROPERTIES %i", action->file_id_operand.file_id);
     return true;
@@ -270,7 +272,7 @@ static bool parse_operand_file_id(alp_command_t* command, alp_action_t* action)
 static bool parse_operand_file_header(alp_command_t* command, alp_action_t* action)
 {
     fifo_t* cmd_fifo = &command->alp_command_fifo;
-    if(fifo_pop(cmd_fifo, &action->file_header_operand.file_id, 1) != SUCCESS)
+    if(fifo_pop_byte(cmd_fifo, &action->file_header_operand.file_id) != SUCCESS)
         return false;
     if(fifo_pop(cmd_fifo, (uint8_t*)&action->file_header_operand.file_header, sizeof(d7ap_fs_file_header_t)) != SUCCESS)
         return false;
@@ -300,7 +302,7 @@ static bool parse_operand_query(alp_command_t* command, alp_action_t* action)
     fifo_t* cmd_fifo = &command->alp_command_fifo;
     error_t err;
     DPRINT("BREAK QUERY");
-    if(fifo_pop(cmd_fifo, &action->query_operand.code.raw, 1) != SUCCESS)
+    if(fifo_pop_byte(cmd_fifo, &action->query_operand.code.raw) != SUCCESS)
         return false;
 
     if(action->query_operand.code.type != QUERY_CODE_TYPE_ARITHM_COMP_WITH_VALUE_IN_QUERY)
@@ -339,14 +341,14 @@ static bool parse_operand_query(alp_command_t* command, alp_action_t* action)
 
 static bool parse_operand_tag_id(alp_command_t* command, alp_action_t* action)
 {
-    return (fifo_pop(&command->alp_command_fifo, &action->tag_id_operand.tag_id, 1) == SUCCESS);
+    return (fifo_pop_byte(&command->alp_command_fifo, &action->tag_id_operand.tag_id) == SUCCESS);
 }
 
 static bool parse_operand_interface_config(alp_command_t* command, alp_action_t* action)
 {
     error_t err;
     fifo_t* cmd_fifo = &command->alp_command_fifo;
-    if(fifo_pop(cmd_fifo, &action->interface_config.itf_id, 1) != SUCCESS)
+    if(fifo_pop_byte(cmd_fifo, &action->interface_config.itf_id) != SUCCESS)
         return false;
     for (uint8_t i = 0; i < MODULE_ALP_INTERFACE_CNT; i++) {
         if (action->interface_config.itf_id == interfaces[i]->itf_id) {
@@ -380,7 +382,7 @@ static bool parse_operand_indirect_interface(alp_command_t* command, alp_action_
 {
     DPRINT("indirect fwd");
     fifo_t* cmd_fifo = &command->alp_command_fifo;
-    if(fifo_pop(cmd_fifo, &action->indirect_interface_operand.interface_file_id, 1) != SUCCESS)
+    if(fifo_pop_byte(cmd_fifo, &action->indirect_interface_operand.interface_file_id) != SUCCESS)
         return false;
 
     if (action->ctrl.b7) {
@@ -428,7 +430,7 @@ static bool parse_operand_stop(alp_command_t* command, alp_action_t* action)
 bool alp_parse_action(alp_command_t* command, alp_action_t* action)
 {
     fifo_t* cmd_fifo = &command->alp_command_fifo;
-    if(fifo_pop(cmd_fifo, &action->ctrl.raw, 1) != SUCCESS)
+    if(fifo_pop_byte(cmd_fifo, &action->ctrl.raw) != SUCCESS)
         return false;
     DPRINT("ALP op %i", action->ctrl.operation);
     bool succeeded;
@@ -488,7 +490,7 @@ int alp_get_expected_response_length(alp_command_t* command)
     
     while (fifo_get_size(command_copy_fifo) > 0) {
         alp_control_t control;
-        if(fifo_pop(command_copy_fifo, &control.raw, 1) != SUCCESS)
+        if(fifo_pop_byte(command_copy_fifo, &control.raw) != SUCCESS)
             return -EINVAL;
         
         switch (control.operation) {
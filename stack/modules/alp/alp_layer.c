@@ -60,9 +60,11 @@
 #define DPRINT_DATA(p, n)
 #endif
 
-static interface_deinit current_itf_deinit = NULL;
+static interface_deinit NGDEF(_current_itf_deinit);
+#define current_itf_deinit NG(_current_itf_deinit)
 
-bool fwd_unsollicited_serial;
+static bool NGDEF(_fwd_unsollicited_serial);
+#define fwd_unsollicited_serial NG(_fwd_unsollicited_serial)
 
 static alp_command_t NGDEF(_commands)[MODULE_ALP_MAX_ACTIVE_COMMAND_COUNT];
 #define commands NG(_commands)
@@ -70,22 +72,34 @@ static alp_command_t NGDEF(_commands)[MODULE_ALP_MAX_ACTIVE_COMMAND_COUNT];
 static alp_init_args_t* NGDEF(_init_args);
 #define init_args NG(_init_args)
 
-static uint8_t previous_interface_file_id = 0;
-static bool interface_file_changed = true;
-static alp_interface_config_t session_config_saved;
+static uint8_t NGDEF(_previous_interface_file_id);
+#define previous_interface_file_id NG(_previous_interface_file_id)
+
+static bool NGDEF(_interface_file_changed); // set in alp_layer_init()
+#define interface_file_changed NG(_interface_file_changed)
+
+static alp_interface_config_t NGDEF(_session_config_saved);
+#define session_config_saved NG(_session_config_saved)
+
 static uint8_t alp_data[ALP_PAYLOAD_MAX_SIZE]; // temp buffer statically allocated to prevent runtime stackoverflows
 static uint8_t alp_data2[ALP_QUERY_COMPARE_BODY_MAX_SIZE]; // temp buffer statically allocated to prevent runtime stackoverflows
 
-extern alp_interface_t* interfaces[MODULE_ALP_INTERFACE_CNT];
+extern alp_interface_t* NGDEF(_interfaces)[MODULE_ALP_INTERFACE_CNT];
+#define interfaces NG(_interfaces)
 
-static itf_ctrl_t current_itf_ctrl;
+static itf_ctrl_t NGDEF(_current_itf_ctrl);
+#define current_itf_ctrl NG(_current_itf_ctrl)
 
 static void process_async(void* arg);
 
-static uint8_t next_tag_id = 0;
+static uint8_t NGDEF(_next_tag_id);
+#define next_tag_id NG(_next_tag_id)
+
+static fifo_t NGDEF(_command_fifo);
+#define command_fifo NG(_command_fifo)
 
-static fifo_t command_fifo;
-static alp_command_t* command_fifo_buffer[MODULE_ALP_MAX_ACTIVE_COMMAND_COUNT];
+static alp_command_t* NGDEF(_command_fifo_buffer)[MODULE_ALP_MAX_ACTIVE_COMMAND_COUNT];
+#define command_fifo_buffer NG(_command_fifo_buffer)
 
 static void free_command(alp_command_t* command) {
   DPRINT("!!! Free cmd %02x %p", command->trans_id, command);
@@ -307,6 +321,7 @@ void alp_layer_init(alp_init_args_t* alp_init_args, bool forward_unsollicited_ov
 {
   init_args = alp_init_args;
   fwd_unsollicited_serial = forward_unsollicited_over_serial;
+  interface_file_changed = true;
   fifo_init(&command_fifo, (uint8_t*)command_fifo_buffer, MODULE_ALP_MAX_ACTIVE_COMMAND_COUNT*sizeof(alp_command_t*));
   alp_layer_free_commands();
 
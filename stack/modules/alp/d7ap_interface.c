@@ -21,6 +21,7 @@
 #include "alp_layer.h"
 #include "string.h"
 #include "log.h"
+#include "ng.h"
 #include "MODULE_ALP_defs.h"
 
 #if defined(FRAMEWORK_LOG_ENABLED) && defined(MODULE_ALP_LOG_ENABLED)
@@ -35,9 +36,14 @@ static void response_from_d7ap(uint16_t trans_id, uint8_t* payload, uint8_t len,
 static bool command_from_d7ap(uint8_t* payload, uint8_t len, d7ap_session_result_t result, bool response_expected);
 static void d7ap_command_completed(uint16_t trans_id, error_t error);
 
-static alp_interface_t d7_alp_interface;
-static uint8_t alp_client_id;
-static bool inited = false;
+static alp_interface_t NGDEF(_d7_alp_interface);
+#define d7_alp_interface NG(_d7_alp_interface)
+
+static uint8_t NGDEF(_alp_client_id);
+#define alp_client_id NG(_alp_client_id)
+
+static bool NGDEF(_inited);
+#define inited NG(_inited)
 
 static error_t d7ap_interface_init()
 {
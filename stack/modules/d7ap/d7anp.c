@@ -54,7 +54,7 @@ typedef enum {
     D7ANP_STATE_FOREGROUND_SCAN,
 } state_t;
 
-static state_t NGDEF(_d7anp_state) = D7ANP_STATE_STOPPED;
+static state_t NGDEF(_d7anp_state); // zero initialised, D7ANP_STATE_STOPPED
 #define d7anp_state NG(_d7anp_state)
 
 static state_t NGDEF(_d7anp_prev_state);
@@ -74,11 +74,18 @@ static dae_nwl_trusted_node_t* NGDEF(_latest_node);
 #define latest_node NG(_latest_node)
 #endif
 
-static timer_event d7anp_fg_scan_expired_timer;
-static timer_event d7anp_start_fg_scan_after_d7aadvp_timer;
+static timer_event NGDEF(_d7anp_fg_scan_expired_timer);
+#define d7anp_fg_scan_expired_timer NG(_d7anp_fg_scan_expired_timer)
 
-d7ap_addressee_id_type_t address_id_type;
-uint8_t address_id[8];
+static timer_event NGDEF(_d7anp_start_fg_scan_after_d7aadvp_timer);
+#define d7anp_start_fg_scan_after_d7aadvp_timer NG(_d7anp_start_fg_scan_after_d7aadvp_timer)
+
+
+static d7ap_addressee_id_type_t NGDEF(_address_id_type);
+#define address_id_type NG(_address_id_type)
+
+static uint8_t NGDEF(_address_id)[8];
+#define address_id NG(_address_id)
 
 #if defined(MODULE_D7AP_NLS_ENABLED)
 static inline uint8_t get_auth_len(uint8_t nls_method)
@@ -27,6 +27,7 @@
 #include "hwradio.h"
 #include "errors.h"
 #include "debug.h"
+#include "ng.h"
 #include "dae.h"
 #include "modules_defs.h"
 #include "MODULE_D7AP_defs.h"
@@ -47,9 +48,14 @@
 
 #define D7A_SECURITY_HEADER_SIZE 5
 
-d7ap_resource_desc_t registered_client[MODULE_D7AP_MAX_CLIENT_COUNT];
-uint8_t registered_client_nb = 0;
-bool inited = false;
+d7ap_resource_desc_t NGDEF(_registered_client)[MODULE_D7AP_MAX_CLIENT_COUNT];
+#define registered_client NG(_registered_client)
+
+uint8_t NGDEF(_registered_client_nb);
+#define registered_client_nb NG(_registered_client_nb)
+
+static bool NGDEF(_inited);
+#define inited NG(_inited)
 
 
 void d7ap_init()
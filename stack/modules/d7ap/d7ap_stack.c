@@ -24,6 +24,7 @@
 #include "bitmap.h"
 #include "errors.h"
 #include "debug.h"
+#include "ng.h"
 
 #include "packet_queue.h"
 #include "d7ap_stack.h"
@@ -54,7 +55,8 @@ typedef struct {
     uint16_t trans_id[MODULE_D7AP_FIFO_MAX_REQUESTS_COUNT];
 } session_t;
 
-static session_t sessions[MODULE_D7AP_MAX_SESSION_COUNT];
+static session_t NGDEF(_sessions)[MODULE_D7AP_MAX_SESSION_COUNT];
+#define sessions NG(_sessions)
 
 typedef struct {
     bool active;
@@ -62,14 +64,14 @@ typedef struct {
     uint8_t token;
 } slave_session_t;
 
-static slave_session_t slave_session = {
-    .active = false,
-    .expected_response = false,
-    .token = 0
-};
+static slave_session_t NGDEF(_slave_session); // zero initialised, no active slave session
+#define slave_session NG(_slave_session)
+
+extern d7ap_resource_desc_t NGDEF(_registered_client)[MODULE_D7AP_MAX_CLIENT_COUNT];
+#define registered_client NG(_registered_client)
 
-extern d7ap_resource_desc_t registered_client[MODULE_D7AP_MAX_CLIENT_COUNT];
-extern uint8_t registered_client_nb;
+extern uint8_t NGDEF(_registered_client_nb);
+#define registered_client_nb NG(_registered_client_nb)
 
 typedef enum {
     D7AP_STACK_STATE_STOPPED,
@@ -79,7 +81,8 @@ typedef enum {
     D7AP_STACK_STATE_WAIT_APP_ANSWER
 } state_t;
 
-static state_t d7ap_stack_state = D7AP_STACK_STATE_STOPPED;
+static state_t NGDEF(_d7ap_stack_state); // zero initialised, D7AP_STACK_STATE_STOPPED
+#define d7ap_stack_state NG(_d7ap_stack_state)
 
 // TODO document state diagram
 static void switch_state(state_t new_state)
@@ -91,8 +91,11 @@ static uint8_t NGDEF(_single_request_retry_limit);
 static packet_t* NGDEF(_current_response_packet);
 #define current_response_packet NG(_current_response_packet)
 
-static timer_event current_session_timer;
-static timer_event dormant_session_timer;
+static timer_event NGDEF(_current_session_timer);
+#define current_session_timer NG(_current_session_timer)
+
+static timer_event NGDEF(_dormant_session_timer);
+#define dormant_session_timer NG(_dormant_session_timer)
 
 typedef enum {
     D7ASP_STATE_STOPPED,
@@ -109,11 +112,12 @@ typedef struct {
   uint8_t id[8];
 } lowest_lb_responder_t;
 
-static lowest_lb_responder_t current_responder_lowest_lb;
+static lowest_lb_responder_t NGDEF(_current_responder_lowest_lb);
+#define current_responder_lowest_lb NG(_current_responder_lowest_lb)
 
 #define LB_MAX 140
 
-static state_t NGDEF(_state) = D7ASP_STATE_STOPPED;
+static state_t NGDEF(_state); // zero initialised, D7ASP_STATE_STOPPED
 #define d7asp_state NG(_state)
 
 static void switch_state(state_t new_state);
@@ -367,6 +371,8 @@ static void schedule_dormant_session(d7asp_master_session_t* dormant_session) {
   timer_tick_t timeout = CT_DECOMPRESS(dormant_session->config.dormant_timeout);
   DPRINT("Sched dormant timeout in %i s", timeout);
   dormant_session_timer.next_event = timeout * 1024;
+  // the timeout is coded with a 5 bit mantissa, so a slack of 1/32 stays below one step of the configured value
+  dormant_session_timer.slack = dormant_session_timer.next_event / 32;
   error_t rtc = timer_add_event(&dormant_session_timer);
   assert(rtc == SUCCESS);
 }
@@ -71,10 +71,14 @@ static dae_access_profile_t NGDEF(_active_addressee_access_profile);
 static bool NGDEF(_stop_dialog_after_tx);
 #define stop_dialog_after_tx NG(_stop_dialog_after_tx)
 
-static timer_event d7atp_response_period_expired_timer;
-static timer_event d7atp_execution_delay_expired_timer;
+static timer_event NGDEF(_d7atp_response_period_expired_timer);
+#define d7atp_response_period_expired_timer NG(_d7atp_response_period_expired_timer)
 
-static bool ctrl_xoff;
+static timer_event NGDEF(_d7atp_execution_delay_expired_timer);
+#define d7atp_execution_delay_expired_timer NG(_d7atp_execution_delay_expired_timer)
+
+static bool NGDEF(_segment_xoff);
+#define segment_xoff NG(_segment_xoff)
 
 typedef enum {
     D7ATP_STATE_STOPPED,
@@ -86,7 +90,7 @@ typedef enum {
     D7ATP_STATE_SLAVE_TRANSACTION_RESPONSE_PERIOD,
 } state_t;
 
-static state_t NGDEF(_d7atp_state) = D7ATP_STATE_STOPPED;
+static state_t NGDEF(_d7atp_state); // zero initialised, D7ATP_STATE_STOPPED
 #define d7atp_state NG(_d7atp_state)
 
 #define IS_IN_MASTER_TRANSACTION() (d7atp_state == D7ATP_STATE_MASTER_TRANSACTION_REQUEST_PERIOD || \
@@ -202,7 +206,7 @@ static void sel_config_modified_callback(uint8_t file_id)
     d7a_segment_filter_options_t segment_filter_options;
     uint32_t length = D7A_FILE_SEL_CONF_SEGMENT_FILTER_SIZE;
     d7ap_fs_read_file(D7A_FILE_SEL_CONF_FILE_ID, D7A_FILE_SEL_CONF_SEGMENT_FILTER_OFFSET, &segment_filter_options.raw, &length, ROOT_AUTH);
-    ctrl_xoff = segment_filter_options.xoff;
+    segment_xoff = segment_filter_options.xoff;
 }
 
 static void schedule_response_period_timeout_handler(timer_tick_t timeout_ticks)
@@ -420,7 +424,7 @@ error_t d7atp_send_response(packet_t* packet)
     /* 
      * a setting in the SEL_config file should be able to tell the requester this node should not be put as preferred. This XOFF bit indicates that
      */
-    packet->d7atp_ctrl.ctrl_xoff = ctrl_xoff;
+    packet->d7atp_ctrl.ctrl_xoff = segment_xoff;
 
     // we are the slave here, so we don't need to lock the other party on the channel, unless we want to signal a pending dormant session with this addressee
     if (packet->d7atp_ctrl.ctrl_is_start) {
@@ -76,7 +76,7 @@ static dae_access_profile_t NGDEF(_remote_access_profile);
 static uint8_t NGDEF(_active_access_class);
 #define active_access_class NG(_active_access_class)
 
-static dll_state_t NGDEF(_dll_state) = DLL_STATE_STOPPED;
+static dll_state_t NGDEF(_dll_state); // zero initialised, DLL_STATE_STOPPED
 #define dll_state NG(_dll_state)
 
 static packet_t* NGDEF(_current_packet);
@@ -125,13 +125,23 @@ static uint16_t NGDEF(_tsched);
 static bool NGDEF(_guarded_channel);
 #define guarded_channel NG(_guarded_channel)
 
-static timer_tick_t guarded_channel_time_stop;
+static timer_tick_t NGDEF(_guarded_channel_time_stop);
+#define guarded_channel_time_stop NG(_guarded_channel_time_stop)
 
-static uint8_t noisefl_last_measurements[PHY_STATUS_MAX_CHANNELS][NOISEFL_NUMBER_MEASUREMENTS]; //3 measurement per channel
-static channel_status_t channels[PHY_STATUS_MAX_CHANNELS];
-static uint8_t phy_status_channel_counter = 0;
-static bool reset_noisefl_last_measurements = false;
-static bool phy_status_file_inited = false;
+static uint8_t NGDEF(_noisefl_last_measurements)[PHY_STATUS_MAX_CHANNELS][NOISEFL_NUMBER_MEASUREMENTS]; //3 measurement per channel
+#define noisefl_last_measurements NG(_noisefl_last_measurements)
+
+static channel_status_t NGDEF(_channels)[PHY_STATUS_MAX_CHANNELS];
+#define channels NG(_channels)
+
+static uint8_t NGDEF(_phy_status_channel_counter);
+#define phy_status_channel_counter NG(_phy_status_channel_counter)
+
+static bool NGDEF(_reset_noisefl_last_measurements);
+#define reset_noisefl_last_measurements NG(_reset_noisefl_last_measurements)
+
+static bool NGDEF(_phy_status_file_inited);
+#define phy_status_file_inited NG(_phy_status_file_inited)
 
 static void execute_cca(void *arg);
 static void execute_csma_ca(void *arg);
@@ -142,27 +152,32 @@ static uint8_t get_position_channel();
 /*!
  * D7A timer used to perform a CCA
  */
-static timer_event dll_cca_timer;
+static timer_event NGDEF(_dll_cca_timer);
+#define dll_cca_timer NG(_dll_cca_timer)
 
 /*!
  * D7A timer used to perform a CSMA-CA
  */
-static timer_event dll_csma_timer;
+static timer_event NGDEF(_dll_csma_timer);
+#define dll_csma_timer NG(_dll_csma_timer)
 
 /*!
  * D7A timer used to start the automation scan (foreground)
  */
-static timer_event dll_scan_automation_timer;
+static timer_event NGDEF(_dll_scan_automation_timer);
+#define dll_scan_automation_timer NG(_dll_scan_automation_timer)
 
 /*!
  * D7A timer used to start a background scan
  */
-static timer_event dll_background_scan_timer;
+static timer_event NGDEF(_dll_background_scan_timer);
+#define dll_background_scan_timer NG(_dll_background_scan_timer)
 
 /*!
  * D7A timer used to delay the processing of a received packet
  */
-static timer_event dll_process_received_packet_timer;
+static timer_event NGDEF(_dll_process_received_packet_timer);
+#define dll_process_received_packet_timer NG(_dll_process_received_packet_timer)
 
 static void switch_state(dll_state_t next_state)
 {
@@ -296,13 +311,21 @@ void median_measured_noisefloor(uint8_t position) {
         E_CCA = - current_access_profile.subbands[0].cca;
 }
 
+static error_t schedule_background_scan()
+{
+    // the scan may start up to tsched / 8 early to share a wakeup with other events, but never late: the background
+    // advertising of a requester only has to cover tsched, so two scans can not be further apart than that
+    dll_background_scan_timer.slack = tsched / 8;
+    dll_background_scan_timer.next_event = tsched - dll_background_scan_timer.slack;
+    return timer_add_event(&dll_background_scan_timer);
+}
+
 void start_background_scan()
 {
     assert(dll_state == DLL_STATE_SCAN_AUTOMATION);
 
     // Start a new tsched timer
-    dll_background_scan_timer.next_event = tsched;
-    timer_add_event(&dll_background_scan_timer);
+    schedule_background_scan();
 
     phy_rx_config_t config = {
         .channel_id = current_channel_id,
@@ -837,8 +860,7 @@ void dll_execute_scan_automation()
 
         // If TSCHED > 0, an independent scheduler is set to generate regular scan start events at TSCHED rate.
         DPRINT("Perform a dll background scan at the end of TSCHED (%d ticks)", tsched);
-        dll_background_scan_timer.next_event = tsched;
-        error_t rtc = timer_add_event(&dll_background_scan_timer);
+        error_t rtc = schedule_background_scan();
         assert(rtc == SUCCESS);
     }
 
@@ -42,12 +42,6 @@
 #define DPRINT_DATA_DLL(...)
 #endif
 
-#ifdef HAL_RADIO_USE_HW_CRC
-static bool has_hardware_crc = true;
-#else
-static bool has_hardware_crc = false;
-#endif
-
 void packet_init(packet_t* packet)
 {
     memset(packet, 0x00, sizeof(packet_t));
@@ -81,14 +75,7 @@ void packet_assemble(packet_t* packet)
 
     // TODO network protocol footer
 
-    // add CRC - SW CRC when using FEC
-    if (!has_hardware_crc ||
-              packet->phy_config.tx.channel_id.channel_header.ch_coding == PHY_CODING_FEC_PN9)
-    {
-        uint16_t crc = __builtin_bswap16(crc_calculate(packet->hw_radio_packet.data, packet->hw_radio_packet.length - 2));
-        memcpy(data_ptr, &crc, 2);
-    }
-
+    // the SW CRC (always used with FEC) is added by the PHY while encoding the packet
 }
 
 void packet_disassemble(packet_t* packet)
@@ -96,6 +83,13 @@ void packet_disassemble(packet_t* packet)
 
     if (packet->hw_radio_packet.rx_meta.crc_status == HW_CRC_UNAVAILABLE)
     {
+        // the length passed to crc_calculate() would wrap for a frame which is shorter than the CRC itself
+        if(packet->hw_radio_packet.length < 2)
+        {
+            DPRINT_DLL("Packet too short: len %d", packet->hw_radio_packet.length);
+            goto cleanup;
+        }
+
         uint16_t crc;
         crc = __builtin_bswap16(crc_calculate(packet->hw_radio_packet.data, packet->hw_radio_packet.length - 2));
 
@@ -28,6 +28,7 @@
 #include "math.h"
 
 #include "debug.h"
+#include "ng.h"
 #include "log.h"
 #include "scheduler.h"
 #include "timer.h"
@@ -129,17 +130,32 @@ typedef enum {
   STATE_CONT_RX
 } state_t;
 
-static hwradio_init_args_t init_args;
+static hwradio_init_args_t NGDEF(_init_args);
+#define init_args NG(_init_args)
 
-static phy_tx_packet_callback_t transmitted_callback;
-static phy_rx_packet_callback_t received_callback;
+static phy_tx_packet_callback_t NGDEF(_transmitted_callback);
+#define transmitted_callback NG(_transmitted_callback)
 
-static state_t state = STATE_IDLE;
-static hw_radio_packet_t *current_packet;
-static bool should_rx_after_tx_completed = false;
-static syncword_class_t current_syncword_class = PHY_SYNCWORD_CLASS0;
-static uint16_t current_syncword = 0;
-static phy_rx_config_t pending_rx_cfg;
+static phy_rx_packet_callback_t NGDEF(_received_callback);
+#define received_callback NG(_received_callback)
+
+static state_t NGDEF(_state); // zero initialised, STATE_IDLE
+#define state NG(_state)
+
+static hw_radio_packet_t *NGDEF(_current_packet);
+#define current_packet NG(_current_packet)
+
+static bool NGDEF(_should_rx_after_tx_completed);
+#define should_rx_after_tx_completed NG(_should_rx_after_tx_completed)
+
+static syncword_class_t NGDEF(_current_syncword_class); // zero initialised, PHY_SYNCWORD_CLASS0
+#define current_syncword_class NG(_current_syncword_class)
+
+static uint16_t NGDEF(_current_syncword);
+#define current_syncword NG(_current_syncword)
+
+static phy_rx_config_t NGDEF(_pending_rx_cfg);
+#define pending_rx_cfg NG(_pending_rx_cfg)
 
 const channel_id_t default_channel_id = {
   .channel_header.ch_coding = PHY_CODING_PN9,
@@ -150,43 +166,117 @@ const channel_id_t default_channel_id = {
 
 #define EMPTY_CHANNEL_ID { .channel_header_raw = 0xFF, .center_freq_index = 0xFF }
 
-static channel_id_t current_channel_id = EMPTY_CHANNEL_ID;
+static channel_id_t NGDEF(_current_channel_id); // set to EMPTY_CHANNEL_ID in phy_init()
+#define current_channel_id NG(_current_channel_id)
+
+/*
+ * The packet which is being received is decoded incrementally: radio drivers which drain their FIFO during reception
+ * pass the bytes received so far to packet_data_received(), which de-whitens, FEC decodes and checks the CRC of
+ * them right away. When the packet is complete only the last bytes remain to be decoded, which shortens the time
+ * between the end of the reception and the response. Decoding happens in place, the decoded data always trails the
+ * received data.
+ */
+typedef struct
+{
+    hw_radio_packet_t* packet;
+    uint16_t processed; // the number of received bytes which are decoded
+    uint16_t decoded; // the number of decoded bytes at the start of packet->data
+    uint16_t crc_length; // the number of decoded bytes included in crc
+    uint16_t crc;
+#ifndef HAL_RADIO_USE_HW_FEC
+    fec_decoder_t fec_decoder;
+#endif
+} rx_stream_t;
+
+static rx_stream_t NGDEF(_rx_stream);
+#define rx_stream NG(_rx_stream)
+
+static uint32_t NGDEF(_rx_bw_lo_rate);
+#define rx_bw_lo_rate NG(_rx_bw_lo_rate)
+
+static uint32_t NGDEF(_rx_bw_normal_rate);
+#define rx_bw_normal_rate NG(_rx_bw_normal_rate)
+
+static uint32_t NGDEF(_rx_bw_hi_rate);
+#define rx_bw_hi_rate NG(_rx_bw_hi_rate)
+
+static bool NGDEF(_fact_settings_changed);
+#define fact_settings_changed NG(_fact_settings_changed)
+
+static uint32_t NGDEF(_bitrate_lo_rate);
+#define bitrate_lo_rate NG(_bitrate_lo_rate)
+
+static uint32_t NGDEF(_fdev_lo_rate);
+#define fdev_lo_rate NG(_fdev_lo_rate)
+
+static uint32_t NGDEF(_bitrate_normal_rate);
+#define bitrate_normal_rate NG(_bitrate_normal_rate)
+
+static uint32_t NGDEF(_fdev_normal_rate);
+#define fdev_normal_rate NG(_fdev_normal_rate)
+
+static uint32_t NGDEF(_bitrate_hi_rate);
+#define bitrate_hi_rate NG(_bitrate_hi_rate)
+
+static uint32_t NGDEF(_fdev_hi_rate);
+#define fdev_hi_rate NG(_fdev_hi_rate)
+
+static uint32_t NGDEF(_lora_bw);
+#define lora_bw NG(_lora_bw)
+
+static uint8_t NGDEF(_lora_SF);
+#define lora_SF NG(_lora_SF)
+
+static uint8_t NGDEF(_preamble_size_lo_rate);
+#define preamble_size_lo_rate NG(_preamble_size_lo_rate)
+
+static uint8_t NGDEF(_preamble_size_normal_rate);
+#define preamble_size_normal_rate NG(_preamble_size_normal_rate)
+
+static uint8_t NGDEF(_preamble_size_hi_rate);
+#define preamble_size_hi_rate NG(_preamble_size_hi_rate)
+
+static uint8_t NGDEF(_preamble_detector_size_lo_rate);
+#define preamble_detector_size_lo_rate NG(_preamble_detector_size_lo_rate)
+
+static uint8_t NGDEF(_preamble_detector_size_normal_rate);
+#define preamble_detector_size_normal_rate NG(_preamble_detector_size_normal_rate)
+
+static uint8_t NGDEF(_preamble_detector_size_hi_rate);
+#define preamble_detector_size_hi_rate NG(_preamble_detector_size_hi_rate)
+
+static uint8_t NGDEF(_preamble_tol_lo_rate);
+#define preamble_tol_lo_rate NG(_preamble_tol_lo_rate)
+
+static uint8_t NGDEF(_preamble_tol_normal_rate);
+#define preamble_tol_normal_rate NG(_preamble_tol_normal_rate)
 
-static uint32_t rx_bw_lo_rate;
-static uint32_t rx_bw_normal_rate;
-static uint32_t rx_bw_hi_rate;
-static bool fact_settings_changed = false;
+static uint8_t NGDEF(_preamble_tol_hi_rate);
+#define preamble_tol_hi_rate NG(_preamble_tol_hi_rate)
 
-static uint32_t bitrate_lo_rate;
-static uint32_t fdev_lo_rate;
-static uint32_t bitrate_normal_rate;
-static uint32_t fdev_normal_rate;
-static uint32_t bitrate_hi_rate;
-static uint32_t fdev_hi_rate;
+static uint8_t NGDEF(_rssi_smoothing);
+#define rssi_smoothing NG(_rssi_smoothing)
 
-static uint32_t lora_bw;
-static uint8_t lora_SF;
+static uint8_t NGDEF(_rssi_offset);
+#define rssi_offset NG(_rssi_offset)
 
-static uint8_t preamble_size_lo_rate;
-static uint8_t preamble_size_normal_rate;
-static uint8_t preamble_size_hi_rate;
-static uint8_t preamble_detector_size_lo_rate;
-static uint8_t preamble_detector_size_normal_rate;
-static uint8_t preamble_detector_size_hi_rate;
-static uint8_t preamble_tol_lo_rate;
-static uint8_t preamble_tol_normal_rate;
-static uint8_t preamble_tol_hi_rate;
+static uint16_t NGDEF(_total_bg);
+#define total_bg NG(_total_bg)
 
-static uint8_t rssi_smoothing;
-static uint8_t rssi_offset;
+static uint16_t NGDEF(_total_rssi_triggers);
+#define total_rssi_triggers NG(_total_rssi_triggers)
 
-static uint16_t total_bg = 0;
-static uint16_t total_rssi_triggers = 0;
-static uint16_t total_fg = 0;
-static uint16_t total_succeeded_fg = 0;
-static uint8_t write_file_counter = 0;
+static uint16_t NGDEF(_total_fg);
+#define total_fg NG(_total_fg)
 
-static uint8_t gain_offset = 0;
+static uint16_t NGDEF(_total_succeeded_fg);
+#define total_succeeded_fg NG(_total_succeeded_fg)
+
+static uint8_t NGDEF(_write_file_counter);
+#define write_file_counter NG(_write_file_counter)
+
+static uint8_t NGDEF(_gain_offset);
+#define gain_offset NG(_gain_offset)
 
 /*
  * FSK packet handler structure
@@ -198,7 +288,8 @@ typedef struct
     uint8_t FifoThresh;
 }FskPacketHandler_t;
 
-FskPacketHandler_t FskPacketHandler;
+static FskPacketHandler_t NGDEF(_FskPacketHandler);
+#define FskPacketHandler NG(_FskPacketHandler)
 
 /*
  * Background advertising packet handler structure
@@ -214,17 +305,19 @@ typedef struct
     timer_tick_t stop_time;
 }bg_adv_t;
 
-bg_adv_t bg_adv;
+static bg_adv_t NGDEF(_bg_adv);
+#define bg_adv NG(_bg_adv)
 
 typedef struct
 {
     uint16_t encoded_length;
     uint8_t encoded_packet[PREAMBLE_HI_RATE_CLASS + 2 + (PACKET_MAX_SIZE + 1)*2]; // include space for preamble and syncword
     uint16_t transmitted_index;
-    bool bg_adv;
+    bool is_bg_adv;
 }fg_frame_t;
 
-fg_frame_t fg_frame;
+static fg_frame_t NGDEF(_fg_frame);
+#define fg_frame NG(_fg_frame)
 
 const uint16_t sync_word_value[2][4] = {
     { 0xE6D0, 0x0000, 0xF498, 0xE6D0 },
@@ -247,20 +340,172 @@ const uint8_t bg_timeout[4] = {
     To_CLASS_HI_RATE
 };
 
-uint16_t end_time;
+static uint16_t NGDEF(_end_time);
+#define end_time NG(_end_time)
+
 /*!
  * D7A timer used to expire the continuous TX
  */
-static timer_event continuous_tx_expiration_timer;
+static timer_event NGDEF(_continuous_tx_expiration_timer);
+#define continuous_tx_expiration_timer NG(_continuous_tx_expiration_timer)
 
 static void fill_in_fifo(uint16_t remaining_bytes_len);
 
+static void rx_stream_start(hw_radio_packet_t* packet)
+{
+    rx_stream.packet = packet;
+    rx_stream.processed = 0;
+    rx_stream.decoded = 0;
+    rx_stream.crc_length = 0;
+    rx_stream.crc = crc_init();
+#ifndef HAL_RADIO_USE_HW_FEC
+    fec_decoder_init(&rx_stream.fec_decoder);
+#endif
+}
+
+#ifndef HAL_RADIO_USE_HW_CRC
+// the length of the frame including the CRC, which is known as soon as the first byte is decoded
+static uint16_t rx_stream_frame_length()
+{
+    if (current_syncword_class == PHY_SYNCWORD_CLASS0)
+        return BACKGROUND_FRAME_LENGTH;
+
+    return rx_stream.packet->data[0] + 1;
+}
+
+// the end of the part of the frame which is covered by the CRC
+static uint16_t rx_stream_crc_end()
+{
+    uint16_t frame_length = rx_stream_frame_length();
+    return frame_length > 2 ? frame_length - 2 : 0;
+}
+
+static void rx_stream_update_crc()
+{
+    if (rx_stream.decoded == 0)
+        return;
+
+    uint16_t crc_end = rx_stream_crc_end();
+    if (crc_end > rx_stream.decoded)
+        crc_end = rx_stream.decoded;
+
+    if (crc_end > rx_stream.crc_length)
+    {
+        rx_stream.crc = crc_update(rx_stream.crc, rx_stream.packet->data + rx_stream.crc_length,
+                                   crc_end - rx_stream.crc_length);
+        rx_stream.crc_length = crc_end;
+    }
+}
+#endif
+
+#if !defined(HAL_RADIO_USE_HW_DC_FREE) && !defined(HAL_RADIO_USE_HW_CRC)
+// Without FEC the frame is de-whitened and included in the CRC in a single pass. The length byte is decoded first,
+// since it determines which part of the frame is covered by the CRC.
+static void rx_stream_decode_pn9_crc(uint16_t end)
+{
+    while (rx_stream.processed < end)
+    {
+        uint16_t crc_end = rx_stream.processed == 0 ? 1 : rx_stream_crc_end();
+        uint16_t chunk_end = (rx_stream.processed < crc_end && crc_end < end) ? crc_end : end;
+        uint8_t* data = rx_stream.packet->data + rx_stream.processed;
+
+        if (rx_stream.processed < crc_end)
+        {
+            rx_stream.crc = pn9_decode_crc(data, chunk_end - rx_stream.processed, rx_stream.processed, rx_stream.crc);
+            rx_stream.crc_length = chunk_end;
+        }
+        else
+            pn9_encode_from(data, chunk_end - rx_stream.processed, rx_stream.processed);
+
+        rx_stream.processed = chunk_end;
+        rx_stream.decoded = chunk_end;
+    }
+}
+#endif
+
+static void rx_stream_decode(uint16_t length)
+{
+    uint16_t end = length;
+
+#if !defined(HAL_RADIO_USE_HW_DC_FREE) && !defined(HAL_RADIO_USE_HW_CRC)
+    if (current_channel_id.channel_header.ch_coding != PHY_CODING_FEC_PN9)
+    {
+        rx_stream_decode_pn9_crc(end);
+        return;
+    }
+#endif
+
+#ifndef HAL_RADIO_USE_HW_FEC
+    bool fec = current_channel_id.channel_header.ch_coding == PHY_CODING_FEC_PN9;
+    if (fec)
+        end -= end % 4; // the FEC decoder consumes 4 byte blocks
+#endif
+
+    if (end <= rx_stream.processed)
+        return;
+
+#ifndef HAL_RADIO_USE_HW_DC_FREE
+    pn9_encode_from(rx_stream.packet->data + rx_stream.processed, end - rx_stream.processed, rx_stream.processed);
+#endif
+
+#ifndef HAL_RADIO_USE_HW_FEC
+    if (fec)
+    {
+        for (uint16_t i = rx_stream.processed; i < end; i += 4)
+            rx_stream.decoded += fec_decode_block(&rx_stream.fec_decoder, &rx_stream.packet->data[i],
+                                                  &rx_stream.packet->data[rx_stream.decoded]);
+    }
+    else
+#endif
+        rx_stream.decoded = end;
+
+    rx_stream.processed = end;
+#ifndef HAL_RADIO_USE_HW_CRC
+    rx_stream_update_crc();
+#endif
+}
+
+// decodes the remainder of the complete packet, returns the decoded length
+static uint16_t rx_stream_finish(hw_radio_packet_t* packet)
+{
+    if (rx_stream.packet != packet)
+        rx_stream_start(packet);
+
+    rx_stream_decode(packet->length);
+
+#ifndef HAL_RADIO_USE_HW_FEC
+    if (current_channel_id.channel_header.ch_coding == PHY_CODING_FEC_PN9)
+        rx_stream.decoded += fec_decoder_flush(&rx_stream.fec_decoder, &packet->data[rx_stream.decoded]);
+#endif
+
+#ifndef HAL_RADIO_USE_HW_CRC
+    rx_stream_update_crc();
+    // a length byte which does not fit the received data means the frame is corrupt
+    uint16_t frame_length = rx_stream_frame_length();
+    bool valid = false;
+    if (frame_length > 2 && frame_length <= rx_stream.decoded && rx_stream.crc_length == frame_length - 2)
+    {
+        uint16_t crc = crc_final(rx_stream.crc);
+        valid = packet->data[frame_length - 2] == (crc >> 8) && packet->data[frame_length - 1] == (crc & 0xFF);
+    }
+
+    packet->rx_meta.crc_status = valid ? HW_CRC_VALID : HW_CRC_INVALID;
+#endif
+
+    rx_stream.packet = NULL;
+    return rx_stream.decoded;
+}
+
 static hw_radio_packet_t* alloc_new_packet(uint16_t length)
 {
     // note we don't use length because in the current implementation the packets in the queue are of
     // fixed (maximum) size
     packet_t* allocated_packet = packet_queue_alloc_packet();
-    return allocated_packet == NULL ? NULL : &allocated_packet->hw_radio_packet;
+    if(allocated_packet == NULL)
+        return NULL;
+
+    rx_stream_start(&allocated_packet->hw_radio_packet);
+    return &allocated_packet->hw_radio_packet;
 }
 
 static void release_packet(hw_radio_packet_t* hw_radio_packet)
@@ -304,16 +549,7 @@ static void packet_received(hw_radio_packet_t* hw_radio_packet)
     DPRINT("Rx packet before decoding <len = %d>", hw_radio_packet->length);
     DPRINT_DATA(hw_radio_packet->data, hw_radio_packet->length);
 
-#ifndef HAL_RADIO_USE_HW_DC_FREE
-    pn9_encode(hw_radio_packet->data, hw_radio_packet->length);
-
-    DPRINT("Rx packet after pn9 encoding <len = %d>", hw_radio_packet->length);
-    DPRINT_DATA(hw_radio_packet->data, hw_radio_packet->length);
-#endif
-#ifndef HAL_RADIO_USE_HW_FEC
-    if (current_channel_id.channel_header.ch_coding == PHY_CODING_FEC_PN9)
-        fec_decode_packet(hw_radio_packet->data, hw_radio_packet->length, hw_radio_packet->length);
-#endif
+    rx_stream_finish(hw_radio_packet);
 
     if (current_syncword_class == PHY_SYNCWORD_CLASS0)
     {
@@ -374,6 +610,14 @@ static void packet_header_received(uint8_t *data, uint8_t len)
     hw_radio_set_payload_length(packet_len);
 }
 
+static void packet_data_received(hw_radio_packet_t* hw_radio_packet, uint16_t length)
+{
+    if (rx_stream.packet != hw_radio_packet)
+        rx_stream_start(hw_radio_packet);
+
+    rx_stream_decode(length);
+}
+
 bool phy_radio_channel_ids_equal(const channel_id_t* a, const channel_id_t* b)
 {
     //return memcmp(a,b, sizeof(channel_id_t)) == 0; //not working since channel_id_t not packed
@@ -589,12 +833,14 @@ error_t phy_init(void) {
     error_t ret = SUCCESS;
 
     state = STATE_IDLE;
+    current_channel_id = (channel_id_t)EMPTY_CHANNEL_ID;
 
     init_args.alloc_packet_cb = alloc_new_packet;
     init_args.release_packet_cb = release_packet;
     init_args.rx_packet_cb = packet_received;
     init_args.tx_packet_cb = packet_transmitted;
     init_args.rx_packet_header_cb = packet_header_received;
+    init_args.rx_packet_data_cb = packet_data_received;
     init_args.tx_refill_cb = fill_in_fifo;
 
     hw_radio_init(&init_args);
@@ -719,13 +965,44 @@ error_t phy_stop_rx(){
     return SUCCESS;
 }
 
+/*
+ * The software CRC is added while the frame is copied to the encode buffer. Without FEC the frame is copied, included
+ * in the CRC and whitened in a single pass. The CRC is also stored in the packet itself.
+ */
 static uint16_t encode_packet(hw_radio_packet_t* packet, uint8_t* encoded_packet)
 {
     uint16_t encoded_len = packet->length;
+    uint16_t crc_offset = packet->length - 2;
+    bool fec = current_channel_id.channel_header.ch_coding == PHY_CODING_FEC_PN9;
+#ifdef HAL_RADIO_USE_HW_CRC
+    bool add_crc = fec; // the hardware CRC can not be used in combination with software FEC
+#else
+    bool add_crc = true;
+#endif
+
+#ifndef HAL_RADIO_USE_HW_DC_FREE
+    if (!fec && add_crc)
+    {
+        uint16_t crc = crc_final(pn9_encode_crc(encoded_packet, packet->data, crc_offset, 0, crc_init()));
+        packet->data[crc_offset] = crc >> 8;
+        packet->data[crc_offset + 1] = crc & 0xFF;
+        memcpy(encoded_packet + crc_offset, packet->data + crc_offset, 2);
+        pn9_encode_from(encoded_packet + crc_offset, 2, crc_offset);
+        return encoded_len;
+    }
+#endif
+
+    if (add_crc)
+    {
+        uint16_t crc = crc_calculate(packet->data, crc_offset);
+        packet->data[crc_offset] = crc >> 8;
+        packet->data[crc_offset + 1] = crc & 0xFF;
+    }
+
     memcpy(encoded_packet, packet->data, packet->length);
 
 #ifndef HAL_RADIO_USE_HW_FEC
-    if (current_channel_id.channel_header.ch_coding == PHY_CODING_FEC_PN9)
+    if (fec)
         encoded_len = fec_encode(encoded_packet, packet->length);
 #endif
 
@@ -879,7 +1156,7 @@ error_t phy_send_packet_with_advertising(hw_radio_packet_t* packet, phy_tx_confi
     DPRINT_DATA(packet->data, packet->length);
 
     DPRINT("tx_duration_bg_frame %i", bg_adv.tx_duration);
-    fg_frame.bg_adv = true;
+    fg_frame.is_bg_adv = true;
     memset(fg_frame.encoded_packet, 0xAA, preamble_len);
     sync_word = __builtin_bswap16(sync_word_value[PHY_SYNCWORD_CLASS1][current_channel_id.channel_header.ch_coding]);
     memcpy(&fg_frame.encoded_packet[preamble_len], &sync_word, 2);
@@ -923,7 +1200,7 @@ static void fill_in_fifo(uint16_t remaining_bytes_len)
     // TODO adapt how we calculate ETA. There is no reason to use current time for each ETA update, we can just use the BG frame duration
     // and a frame counter to determine this.
 
-    if (fg_frame.bg_adv)
+    if (fg_frame.is_bg_adv)
     {
         DEBUG_BG_END();
         timer_tick_t current = timer_get_counter_value();
@@ -975,7 +1252,7 @@ static void fill_in_fifo(uint16_t remaining_bytes_len)
             DEBUG_BG_END();
 
             bg_adv.eta = 0;
-            fg_frame.bg_adv = false;
+            fg_frame.is_bg_adv = false;
         }
     }
     else
@@ -1069,7 +1346,7 @@ void phy_continuous_tx(phy_tx_config_t const* tx_cfg, uint8_t time_period, phy_t
         timer_add_event(&continuous_tx_expiration_timer);
     }
 
-    fg_frame.bg_adv = false;
+    fg_frame.is_bg_adv = false;
     if (current_channel_id.channel_header.ch_coding == PHY_CODING_FEC_PN9)
     {
         uint8_t payload_len = 32;
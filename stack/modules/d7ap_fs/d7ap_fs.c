@@ -26,6 +26,7 @@
 #include "framework_defs.h"
 #include "string.h"
 #include "debug.h"
+#include "ng.h"
 #include "fs.h"
 #include "d7ap.h"
 #include "d7ap_fs.h"
@@ -66,8 +67,33 @@
 #define FILE_SIZE_MAX (MODULE_D7AP_FS_FILE_SIZE_MAX + sizeof(d7ap_fs_file_header_t))
 static uint8_t file_buffer[FILE_SIZE_MAX]; // statically allocated buffer used during file operations, to prevent stack overflow at runtime
 
-static d7ap_fs_modified_file_callback_t file_modified_callbacks[FRAMEWORK_FS_FILE_COUNT] = { NULL }; // TODO limit to lower number so save RAM?
-static d7ap_fs_modifying_file_callback_t file_modifying_callbacks[FRAMEWORK_FS_FILE_COUNT] = { NULL };
+static d7ap_fs_modified_file_callback_t NGDEF(_file_modified_callbacks)[FRAMEWORK_FS_FILE_COUNT]; // TODO limit to lower number so save RAM?
+#define file_modified_callbacks NG(_file_modified_callbacks)
+
+static d7ap_fs_modifying_file_callback_t NGDEF(_file_modifying_callbacks)[FRAMEWORK_FS_FILE_COUNT];
+#define file_modifying_callbacks NG(_file_modifying_callbacks)
+
+#ifdef MODULE_D7AP_FS_CACHE_FILE_HEADERS
+// Write-through copy of the D7A file headers in RAM, in native byte order. The header is checked (permissions, length,
+// action protocol) on every file access, the cache avoids reading it from the blockdevice each time. A header is
+// cached when the file is created or on its first read, and is updated after every successful header write.
+static d7ap_fs_file_header_t NGDEF(_file_headers)[FRAMEWORK_FS_FILE_COUNT];
+#define file_headers NG(_file_headers)
+
+static uint8_t NGDEF(_file_header_cached)[(FRAMEWORK_FS_FILE_COUNT + 7) / 8];
+#define file_header_cached NG(_file_header_cached)
+
+static inline bool is_file_header_cached(uint8_t file_id)
+{
+    return file_header_cached[file_id / 8] & (1 << (file_id % 8));
+}
+
+static inline void cache_file_header(uint8_t file_id, const d7ap_fs_file_header_t* file_header)
+{
+    memcpy(&file_headers[file_id], file_header, sizeof(d7ap_fs_file_header_t));
+    file_header_cached[file_id / 8] |= 1 << (file_id % 8);
+}
+#endif // MODULE_D7AP_FS_CACHE_FILE_HEADERS
 
 static inline bool is_file_defined(uint8_t file_id)
 {
@@ -160,7 +186,12 @@ int d7ap_fs_init_file_on_blockdevice(
         memcpy(file_buffer + sizeof(d7ap_fs_file_header_t), initial_data, file_header->length);
     }
        
-    return fs_init_file(file_id, blockdevice_index, (const uint8_t *)file_buffer, length, sizeof(d7ap_fs_file_header_t) + file_header->allocated_length);
+    int rtc = fs_init_file(file_id, blockdevice_index, (const uint8_t *)file_buffer, length, sizeof(d7ap_fs_file_header_t) + file_header->allocated_length);
+#ifdef MODULE_D7AP_FS_CACHE_FILE_HEADERS
+    if(rtc == 0)
+        cache_file_header(file_id, file_header);
+#endif
+    return rtc;
 }
 
 int d7ap_fs_read_file(uint8_t file_id, uint32_t offset, uint8_t* buffer, uint32_t* length, authentication_t auth)
@@ -211,6 +242,14 @@ int d7ap_fs_read_file_header(uint8_t file_id, d7ap_fs_file_header_t* file_header
   int rtc;
   if(!is_file_defined(file_id)) return -ENOENT;
 
+#ifdef MODULE_D7AP_FS_CACHE_FILE_HEADERS
+  if(is_file_header_cached(file_id))
+  {
+    memcpy(file_header, &file_headers[file_id], sizeof(d7ap_fs_file_header_t));
+    return 0;
+  }
+#endif
+
   rtc = fs_read_file(file_id, 0, (uint8_t *)file_header, sizeof(d7ap_fs_file_header_t));
   if (rtc != 0)
     return rtc;
@@ -221,6 +260,9 @@ int d7ap_fs_read_file_header(uint8_t file_id, d7ap_fs_file_header_t* file_header
   file_header->allocated_length = __builtin_bswap32(file_header->allocated_length);
 #endif
 
+#ifdef MODULE_D7AP_FS_CACHE_FILE_HEADERS
+  cache_file_header(file_id, file_header);
+#endif
   return 0;
 }
 
@@ -238,12 +280,19 @@ int d7ap_fs_write_file_header(uint8_t file_id, d7ap_fs_file_header_t* file_heade
 #endif
 
   // Input of data shall be in big-endian ordering
+  d7ap_fs_file_header_t file_header_big_endian;
+  memcpy(&file_header_big_endian, file_header, sizeof(d7ap_fs_file_header_t));
 #if __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__
-  file_header->length = __builtin_bswap32(file_header->length);
-  file_header->allocated_length = __builtin_bswap32(file_header->allocated_length);
+  file_header_big_endian.length = __builtin_bswap32(file_header_big_endian.length);
+  file_header_big_endian.allocated_length = __builtin_bswap32(file_header_big_endian.allocated_length);
 #endif
 
-  return (fs_write_file(file_id, 0, (const uint8_t*)file_header, sizeof(d7ap_fs_file_header_t)));
+  int rtc = fs_write_file(file_id, 0, (const uint8_t*)&file_header_big_endian, sizeof(d7ap_fs_file_header_t));
+#ifdef MODULE_D7AP_FS_CACHE_FILE_HEADERS
+  if(rtc == 0)
+    cache_file_header(file_id, file_header);
+#endif
+  return rtc;
 }
 
 int d7ap_fs_write_file(uint8_t file_id, uint32_t offset, const uint8_t* buffer, uint32_t length, authentication_t auth)
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Tests the write-back cache blockdevice on top of a RAM blockdevice, and the flush of the permanent storage by the fs
+// when FRAMEWORK_FS_WRITE_BACK_CACHE is enabled.
+
+#include "blockdevice_cache.h"
+#include "blockdevice_ram.h"
+#include "framework_defs.h"
+#include "platform.h"
+#include "scheduler.h"
+#include "timer.h"
+#include "fs.h"
+#include "errors.h"
+#include "assert.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BACKING_SIZE 1000 // not a multiple of the page size, so the last page is partial
+#define WRITE_BLOCK_SIZE 16
+#define PAGE_SIZE 64
+#define PAGE_COUNT 3
+
+static uint8_t backing_buffer[BACKING_SIZE];
+static uint8_t shadow[BACKING_SIZE]; // the expected content of the blockdevice
+
+// a RAM blockdevice with write blocks, which checks the programs do not cross them
+static error_t backing_program(blockdevice_t* bd, const uint8_t* data, uint32_t addr, uint32_t size)
+{
+    assert(size > 0 && addr / WRITE_BLOCK_SIZE == (addr + size - 1) / WRITE_BLOCK_SIZE);
+    return blockdevice_driver_ram.program(bd, data, addr, size);
+}
+
+static blockdevice_driver_t backing_driver;
+static blockdevice_ram_t backing = {
+    .base.driver = &backing_driver,
+    .base.size = BACKING_SIZE,
+    .buffer = backing_buffer
+};
+
+static uint8_t cache_buffer[PAGE_COUNT * PAGE_SIZE];
+static blockdevice_cache_page_t cache_pages[PAGE_COUNT];
+static blockdevice_cache_t cache = {
+    .base.driver = &blockdevice_driver_cache,
+    .backing = &backing.base,
+    .buffer = cache_buffer,
+    .pages = cache_pages,
+    .page_size = PAGE_SIZE,
+    .page_count = PAGE_COUNT
+};
+
+static void write(uint32_t addr, const uint8_t* data, uint32_t size)
+{
+    assert(blockdevice_program(&cache.base, data, addr, size) == SUCCESS);
+    memcpy(shadow + addr, data, size);
+}
+
+static void check(uint32_t addr, uint32_t size)
+{
+    uint8_t data[BACKING_SIZE];
+    assert(blockdevice_read(&cache.base, data, addr, size) == SUCCESS);
+    assert(memcmp(data, shadow + addr, size) == 0);
+}
+
+void test_write_back()
+{
+    uint8_t data[BACKING_SIZE];
+    for(int i = 0; i < BACKING_SIZE; i++)
+        backing_buffer[i] = shadow[i] = i;
+
+    assert(blockdevice_init(&cache.base) == SUCCESS);
+    assert(cache.base.size == BACKING_SIZE);
+
+    // repeated small writes to the same page are only programmed on the flush
+    for(uint8_t i = 0; i < 100; i++)
+        write(10 + i % 4, &i, 1);
+
+    check(0, BACKING_SIZE);
+    assert(cache.stats.programs == 0 && cache.stats.reads == 2); // the page was filled, the read missed the other pages
+    assert(memcmp(backing_buffer, shadow, BACKING_SIZE) != 0);
+    assert(blockdevice_flush(&cache.base) == SUCCESS);
+    assert(cache.stats.programs == PAGE_SIZE / WRITE_BLOCK_SIZE);
+    assert(memcmp(backing_buffer, shadow, BACKING_SIZE) == 0);
+    assert(blockdevice_flush(&cache.base) == SUCCESS);
+    assert(cache.stats.programs == PAGE_SIZE / WRITE_BLOCK_SIZE);
+
+    // a page which is overwritten completely is not read first
+    uint32_t reads = cache.stats.reads;
+    memset(data, 0xAA, PAGE_SIZE);
+    write(2 * PAGE_SIZE, data, PAGE_SIZE);
+    assert(cache.stats.reads == reads);
+
+    // the partial last page
+    memset(data, 0x55, 30);
+    write(BACKING_SIZE - 30, data, 30);
+    check(BACKING_SIZE - 100, 100);
+    assert(blockdevice_program(&cache.base, data, BACKING_SIZE - 1, 2) == -ESIZE);
+    assert(blockdevice_read(&cache.base, data, BACKING_SIZE - 1, 2) == -ESIZE);
+
+    // the least recently used page is written back when a page is needed
+    uint32_t programs = cache.stats.programs;
+    write(5 * PAGE_SIZE + 3, data, 1);
+    write(6 * PAGE_SIZE + 3, data, 1);
+    assert(cache.stats.programs > programs);
+    assert(memcmp(backing_buffer + 2 * PAGE_SIZE, shadow + 2 * PAGE_SIZE, PAGE_SIZE) == 0);
+    check(0, BACKING_SIZE);
+    assert(blockdevice_flush(&cache.base) == SUCCESS);
+    assert(memcmp(backing_buffer, shadow, BACKING_SIZE) == 0);
+}
+
+void test_random_access()
+{
+    uint8_t data[3 * PAGE_SIZE];
+    srand(0);
+    for(int i = 0; i < 5000; i++)
+    {
+        uint32_t size = 1 + rand() % sizeof(data);
+        uint32_t addr = rand() % (BACKING_SIZE - size + 1);
+        if(rand() % 2)
+        {
+            for(uint32_t j = 0; j < size; j++)
+                data[j] = rand();
+
+            write(addr, data, size);
+        }
+        else
+            check(addr, size);
+
+        if(rand() % 100 == 0)
+        {
+            assert(blockdevice_flush(&cache.base) == SUCCESS);
+            assert(memcmp(backing_buffer, shadow, BACKING_SIZE) == 0);
+        }
+    }
+
+    assert(blockdevice_flush(&cache.base) == SUCCESS);
+    assert(memcmp(backing_buffer, shadow, BACKING_SIZE) == 0);
+}
+
+#ifdef FRAMEWORK_FS_WRITE_BACK_CACHE
+#define FILE_ID 0x40
+#define FILE_LENGTH 8
+
+static const uint8_t file_data[FILE_LENGTH] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+
+static bool is_stored(const uint8_t* data)
+{
+    uint8_t stored[FILE_LENGTH];
+    assert(blockdevice_read(PLATFORM_PERMANENT_BLOCKDEVICE, stored, fs_get_address(FILE_ID), FILE_LENGTH) == SUCCESS);
+    return memcmp(stored, data, FILE_LENGTH) == 0;
+}
+
+void check_flushed_task(void* arg)
+{
+    // written back by the timer, FRAMEWORK_FS_WRITE_BACK_CACHE_FLUSH_DELAY after the first write
+    assert(is_stored(file_data));
+    printf("All blockdevice cache tests passed!\n");
+    exit(0);
+}
+
+void test_fs_flush()
+{
+    uint8_t data[FILE_LENGTH] = { 0 };
+    fs_init();
+    assert(fs_init_file(FILE_ID, FS_BLOCKDEVICE_TYPE_PERMANENT, data, FILE_LENGTH, FILE_LENGTH) == SUCCESS);
+    assert(fs_flush() == SUCCESS);
+    assert(is_stored(data));
+
+    assert(fs_write_file(FILE_ID, 0, file_data, FILE_LENGTH) == SUCCESS);
+    assert(fs_read_file(FILE_ID, 0, data, FILE_LENGTH) == SUCCESS);
+    assert(memcmp(data, file_data, FILE_LENGTH) == 0);
+    assert(!is_stored(file_data));
+
+    sched_register_task(&check_flushed_task);
+    timer_post_task_delay(&check_flushed_task, FRAMEWORK_FS_WRITE_BACK_CACHE_FLUSH_DELAY * TIMER_TICKS_PER_SEC + 1);
+}
+#endif
+
+void bootstrap()
+{
+    backing_driver = blockdevice_driver_ram;
+    backing_driver.program = &backing_program;
+    backing_driver.write_block_size = WRITE_BLOCK_SIZE;
+
+    test_write_back();
+    test_random_access();
+
+#ifdef FRAMEWORK_FS_WRITE_BACK_CACHE
+    test_fs_flush();
+#else
+    printf("All blockdevice cache tests passed!\n");
+    exit(0);
+#endif
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "crc.h"
+
+// the original bytewise implementation, used as reference
+static uint16_t reference_crc(const uint8_t* data, uint16_t length)
+{
+    uint16_t crc = 0xffff;
+    for(uint16_t i = 0; i < length; i++)
+    {
+        uint16_t crc_new = (uint8_t)(crc >> 8) | (crc << 8);
+        crc_new ^= data[i];
+        crc_new ^= (uint8_t)(crc_new & 0xff) >> 4;
+        crc_new ^= crc_new << 12;
+        crc_new ^= (crc_new & 0xff) << 5;
+        crc = crc_new;
+    }
+
+    return crc;
+}
+
+void bootstrap()
+{
+    // check value of CRC-16/CCITT-FALSE
+    assert(crc_calculate((const uint8_t*)"123456789", 9) == 0x29B1);
+    assert(crc_calculate(NULL, 0) == CRC_INITIALIZER);
+
+    uint8_t data[600];
+    for(int i = 0; i < sizeof(data); i++)
+        data[i] = rand();
+
+    // lengths above 255 and all possible alignments of the slice-by-N loop
+    for(uint16_t length = 0; length <= sizeof(data); length++)
+        assert(crc_calculate(data, length) == reference_crc(data, length));
+
+    for(uint16_t offset = 1; offset < 16; offset++)
+        assert(crc_calculate(data + offset, 300) == reference_crc(data + offset, 300));
+
+    // incremental calculation, in chunks of any size
+    for(uint16_t chunk = 1; chunk <= 20; chunk++)
+    {
+        uint16_t crc = crc_init();
+        for(uint16_t i = 0; i < sizeof(data); i += chunk)
+            crc = crc_update(crc, data + i, (sizeof(data) - i < chunk) ? sizeof(data) - i : chunk);
+
+        assert(crc_final(crc) == reference_crc(data, sizeof(data)));
+    }
+
+    printf("All CRC tests passed!\n");
+    exit(0);
+}
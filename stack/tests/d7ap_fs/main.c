@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks that the file headers kept in RAM by d7ap_fs stay coherent with the headers on the blockdevice, and that
+// permission and length checks use them.
+
+#include "d7ap_fs.h"
+#include "fs.h"
+#include "MODULE_D7AP_FS_defs.h"
+#include "errors.h"
+#include "assert.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// define here now, since we are not using APP_BUILD() macro for tests
+const char _APP_NAME[] = "d7ap_fs_test";
+const char _GIT_SHA1[] = "";
+
+#define FILE_ID 0x40
+#define FILE_LENGTH 8
+
+// reads the header as stored on the blockdevice, converted to native byte order
+static void read_stored_file_header(uint8_t file_id, d7ap_fs_file_header_t* header)
+{
+    assert(fs_read_file(file_id, 0, (uint8_t*)header, sizeof(d7ap_fs_file_header_t)) == SUCCESS);
+    header->length = __builtin_bswap32(header->length);
+    header->allocated_length = __builtin_bswap32(header->allocated_length);
+}
+
+void bootstrap()
+{
+    d7ap_fs_file_header_t header = {
+        .file_permissions = (file_permission_t) { .guest_read = true, .user_read = true, .user_write = true },
+        .file_properties.storage_class = FS_STORAGE_PERMANENT,
+        .length = FILE_LENGTH,
+        .allocated_length = FILE_LENGTH
+    };
+    const uint8_t initial_data[FILE_LENGTH] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    d7ap_fs_file_header_t read_header, stored_header;
+    uint8_t data[FILE_LENGTH];
+    uint32_t length;
+
+    fs_init();
+    assert(d7ap_fs_read_file_header(FILE_ID, &read_header) == -ENOENT);
+    assert(d7ap_fs_init_file(FILE_ID, &header, initial_data) == SUCCESS);
+    assert(d7ap_fs_read_file_header(FILE_ID, &read_header) == SUCCESS);
+    assert(memcmp(&read_header, &header, sizeof(header)) == 0);
+
+    // permissions
+    length = FILE_LENGTH;
+    assert(d7ap_fs_read_file(FILE_ID, 0, data, &length, GUEST_AUTH) == SUCCESS);
+    assert(length == FILE_LENGTH && memcmp(data, initial_data, FILE_LENGTH) == 0);
+    assert(d7ap_fs_write_file(FILE_ID, 0, data, 1, GUEST_AUTH) == -EACCES);
+    assert(d7ap_fs_write_file(FILE_ID, 0, data, 1, USER_AUTH) == SUCCESS);
+    assert(d7ap_fs_update_permissions(FILE_ID, false, false, true, false) == SUCCESS);
+    assert(d7ap_fs_read_file(FILE_ID, 0, data, &length, GUEST_AUTH) == -EACCES);
+    assert(d7ap_fs_write_file(FILE_ID, 0, data, 1, USER_AUTH) == -EACCES);
+    assert(d7ap_fs_read_file(FILE_ID, 0, data, &length, USER_AUTH) == SUCCESS);
+
+    // the header is written through to the blockdevice, without modifying the header passed by the caller
+    assert(d7ap_fs_change_file_length(FILE_ID, FILE_LENGTH / 2) == SUCCESS);
+    assert(d7ap_fs_get_file_length(FILE_ID) == FILE_LENGTH / 2);
+    read_stored_file_header(FILE_ID, &stored_header);
+    assert(d7ap_fs_read_file_header(FILE_ID, &read_header) == SUCCESS);
+    assert(memcmp(&read_header, &stored_header, sizeof(header)) == 0);
+    assert(stored_header.length == FILE_LENGTH / 2 && !stored_header.file_permissions.guest_read);
+
+    header.length = FILE_LENGTH / 2;
+    assert(d7ap_fs_write_file_header(FILE_ID, &header, ROOT_AUTH) == SUCCESS);
+    assert(header.length == FILE_LENGTH / 2);
+    read_stored_file_header(FILE_ID, &stored_header);
+    assert(memcmp(&header, &stored_header, sizeof(header)) == 0);
+
+    // reads and writes are bounded by the length in the header
+    length = FILE_LENGTH;
+    assert(d7ap_fs_read_file(FILE_ID, 0, data, &length, ROOT_AUTH) == SUCCESS);
+    assert(length == FILE_LENGTH / 2);
+    assert(d7ap_fs_write_file(FILE_ID, 0, data, FILE_LENGTH, ROOT_AUTH) == -EINVAL);
+    assert(d7ap_fs_write_file(FILE_ID, 0, data, FILE_LENGTH / 2, ROOT_AUTH) == SUCCESS);
+
+#ifdef MODULE_D7AP_FS_CACHE_FILE_HEADERS
+    // once cached, the header is not read from the blockdevice anymore
+    memset(&stored_header, 0, sizeof(stored_header));
+    assert(fs_write_file(FILE_ID, 0, (uint8_t*)&stored_header, sizeof(stored_header)) == SUCCESS);
+    assert(d7ap_fs_read_file_header(FILE_ID, &read_header) == SUCCESS);
+    assert(memcmp(&read_header, &header, sizeof(header)) == 0);
+    assert(d7ap_fs_read_file(FILE_ID, 0, data, &length, GUEST_AUTH) == SUCCESS);
+#endif
+
+    printf("All d7ap_fs tests passed!\n");
+    exit(0);
+}
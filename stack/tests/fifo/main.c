@@ -20,6 +20,7 @@
 #include "assert.h"
 #include "errors.h"
 #include "stdio.h"
+#include <string.h>
 
 #define BUFFER_SIZE 10
 
@@ -254,6 +255,188 @@ void test_pop_empty()
     assert(fifo_get_size(&test_fifo) == 0);
 }
 
+void test_peek_segments()
+{
+    fifo_t test_fifo;
+    uint8_t buffer[BUFFER_SIZE] = {0,};
+    uint8_t expected[BUFFER_SIZE] = {0,1,2,3,4,5,6,7,8,9};
+    uint8_t buff[BUFFER_SIZE] = {0};
+    fifo_segment_t segments[2];
+
+    fifo_init(&test_fifo, buffer, BUFFER_SIZE);
+    assert(fifo_peek_segments(&test_fifo, 0, 0, segments) == SUCCESS);
+    assert(segments[0].len == 0 && segments[1].len == 0);
+    assert(fifo_peek_segments(&test_fifo, 0, 1, segments) == ESIZE);
+
+    // contiguous
+    assert(fifo_put(&test_fifo, expected, 6) == SUCCESS);
+    assert(fifo_peek_segments(&test_fifo, 1, 4, segments) == SUCCESS);
+    assert(segments[0].data == &buffer[1] && segments[0].len == 4 && segments[1].len == 0);
+    assert(fifo_peek_segments(&test_fifo, 1, 6, segments) == ESIZE);
+
+    // wrapped: the fifo holds 4,5,6,7,8,9,0,1,2 starting from index 4
+    assert(fifo_pop(&test_fifo, buff, 4) == SUCCESS);
+    assert(fifo_put(&test_fifo, &expected[6], 4) == SUCCESS);
+    assert(fifo_put(&test_fifo, expected, 3) == SUCCESS);
+    assert(fifo_peek_segments(&test_fifo, 1, 7, segments) == SUCCESS);
+    assert(segments[0].data == &buffer[5] && segments[0].len == 5);
+    assert(segments[1].data == &buffer[0] && segments[1].len == 2);
+    assert(memcmp(segments[0].data, &expected[5], 5) == 0 && memcmp(segments[1].data, expected, 2) == 0);
+
+    // the offset itself wraps
+    assert(fifo_peek_segments(&test_fifo, 7, 2, segments) == SUCCESS);
+    assert(segments[0].data == &buffer[1] && segments[0].len == 2 && segments[1].len == 0);
+    assert(fifo_get_size(&test_fifo) == 9);
+}
+
+void test_reserve_commit()
+{
+    fifo_t test_fifo;
+    uint8_t buffer[BUFFER_SIZE] = {0,};
+    uint8_t expected[BUFFER_SIZE] = {0,1,2,3,4,5,6,7,8,9};
+    uint8_t buff[BUFFER_SIZE] = {0};
+    fifo_segment_t segments[2];
+
+    fifo_init(&test_fifo, buffer, BUFFER_SIZE);
+    assert(fifo_reserve(&test_fifo, BUFFER_SIZE + 1, segments) == ESIZE);
+    assert(fifo_reserve(&test_fifo, 4, segments) == SUCCESS);
+    assert(segments[0].data == buffer && segments[0].len == 4 && segments[1].len == 0);
+    memcpy(segments[0].data, expected, 3);
+    // the reservation does not modify the fifo, only the committed bytes are added
+    assert(fifo_get_size(&test_fifo) == 0);
+    assert(fifo_commit(&test_fifo, 3) == SUCCESS);
+    assert(fifo_get_size(&test_fifo) == 3);
+
+    // reserve space which wraps around the end of the buffer
+    assert(fifo_pop(&test_fifo, buff, 3) == SUCCESS);
+    assert(fifo_put(&test_fifo, expected, 5) == SUCCESS);
+    assert(fifo_skip(&test_fifo, 5) == SUCCESS);
+    assert(fifo_reserve(&test_fifo, BUFFER_SIZE, segments) == SUCCESS);
+    assert(segments[0].data == &buffer[8] && segments[0].len == 2);
+    assert(segments[1].data == buffer && segments[1].len == 8);
+    memcpy(segments[0].data, expected, 2);
+    memcpy(segments[1].data, &expected[2], 8);
+    assert(fifo_commit(&test_fifo, BUFFER_SIZE) == SUCCESS);
+    assert(fifo_is_full(&test_fifo) == true);
+    assert(fifo_reserve(&test_fifo, 1, segments) == ESIZE);
+    assert(fifo_commit(&test_fifo, 1) == ESIZE);
+    assert(fifo_pop(&test_fifo, buff, BUFFER_SIZE) == SUCCESS);
+    assert(memcmp(buff, expected, BUFFER_SIZE) == 0);
+
+    // writing to a subview is not allowed
+    fifo_t subview;
+    assert(fifo_put(&test_fifo, expected, 4) == SUCCESS);
+    assert(fifo_init_subview(&subview, &test_fifo, 0, 2) == SUCCESS);
+    assert(fifo_reserve(&subview, 1, segments) == EINVAL);
+    assert(fifo_commit(&subview, 1) == EINVAL);
+}
+
+void test_byte_access()
+{
+    // a power of two size is masked, other sizes are wrapped with a compare
+    static const uint16_t sizes[] = { 8, BUFFER_SIZE };
+    for(int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        fifo_t test_fifo;
+        uint8_t buffer[BUFFER_SIZE] = {0,};
+        uint8_t element;
+        uint8_t next_put = 0, next_pop = 0;
+
+        fifo_init(&test_fifo, buffer, sizes[s]);
+        assert(fifo_pop_byte(&test_fifo, &element) == ESIZE);
+        for(int i = 0; i < 5 * BUFFER_SIZE; i++)
+        {
+            // put 3 bytes and pop 2, until the fifo is full, then drain it
+            for(int j = 0; j < 3; j++)
+            {
+                if(fifo_get_size(&test_fifo) == sizes[s])
+                {
+                    assert(fifo_is_full(&test_fifo));
+                    assert(fifo_put_byte(&test_fifo, next_put) == ESIZE);
+                    while(fifo_pop_byte(&test_fifo, &element) == SUCCESS)
+                        assert(element == next_pop++);
+                    assert(fifo_get_size(&test_fifo) == 0);
+                }
+                assert(fifo_put_byte(&test_fifo, next_put++) == SUCCESS);
+            }
+            for(int j = 0; j < 2 && fifo_get_size(&test_fifo) > 0; j++)
+            {
+                assert(fifo_pop_byte(&test_fifo, &element) == SUCCESS);
+                assert(element == next_pop++);
+            }
+            assert(fifo_get_size(&test_fifo) == (uint8_t)(next_put - next_pop));
+        }
+
+        // the bulk functions wrap the same way
+        uint8_t data[BUFFER_SIZE];
+        uint16_t free = sizes[s] - fifo_get_size(&test_fifo);
+        for(int i = 0; i < free; i++)
+            data[i] = next_put++;
+        assert(fifo_put(&test_fifo, data, free) == SUCCESS);
+        assert(fifo_is_full(&test_fifo));
+        assert(fifo_pop(&test_fifo, data, sizes[s]) == SUCCESS);
+        for(int i = 0; i < sizes[s]; i++)
+            assert(data[i] == next_pop++);
+    }
+}
+
+void test_spsc()
+{
+    fifo_spsc_t test_fifo;
+    uint8_t buffer[8] = {0,};
+    uint8_t expected[BUFFER_SIZE] = {0,1,2,3,4,5,6,7,8,9};
+    uint8_t buff[BUFFER_SIZE] = {0};
+
+    assert(fifo_spsc_init(&test_fifo, buffer, 6) == EINVAL);
+    assert(fifo_spsc_init(&test_fifo, buffer, sizeof(buffer)) == SUCCESS);
+    assert(fifo_spsc_get_size(&test_fifo) == 0);
+    assert(fifo_put_from_isr(&test_fifo, expected, 9) == ESIZE);
+    assert(fifo_spsc_get_size(&test_fifo) == 0);
+
+    // fill and drain the fifo a number of times, so the puts wrap around the end of the buffer at every offset and the
+    // free running indices wrap around as well
+    uint8_t next_put = 0, next_pop = 0;
+    for(int i = 0; i < 70000; i++)
+    {
+        uint8_t len = 1 + i % 5;
+        uint8_t data[5];
+        for(int j = 0; j < len; j++)
+            data[j] = next_put + j;
+        if(fifo_put_from_isr(&test_fifo, data, len) == SUCCESS)
+            next_put += len;
+        else
+            assert(fifo_spsc_get_size(&test_fifo) + len > sizeof(buffer));
+
+        uint16_t size = fifo_spsc_get_size(&test_fifo);
+        assert(size == (uint8_t)(next_put - next_pop) && size <= sizeof(buffer));
+        uint8_t pop_len = size < 3 ? size : 3;
+        assert(fifo_spsc_peek(&test_fifo, buff, 0, pop_len) == SUCCESS);
+        for(int j = 0; j < pop_len; j++)
+            assert(buff[j] == (uint8_t)(next_pop + j));
+        assert(fifo_spsc_skip(&test_fifo, pop_len) == SUCCESS);
+        next_pop += pop_len;
+    }
+
+    // parse a subset through a fifo_t, this does not pop the bytes from the original fifo
+    fifo_spsc_clear(&test_fifo);
+    assert(fifo_spsc_get_size(&test_fifo) == 0);
+    assert(fifo_put_from_isr(&test_fifo, expected, 7) == SUCCESS);
+    fifo_t subview;
+    assert(fifo_spsc_init_subview(&subview, &test_fifo, 1, 7) == ESIZE);
+    assert(fifo_spsc_init_subview(&subview, &test_fifo, 1, 5) == SUCCESS);
+    assert(fifo_get_size(&subview) == 5);
+    assert(fifo_pop(&subview, buff, 5) == SUCCESS);
+    assert(memcmp(buff, &expected[1], 5) == 0);
+    assert(fifo_put(&subview, expected, 1) == EINVAL);
+    assert(fifo_spsc_get_size(&test_fifo) == 7);
+    assert(fifo_spsc_skip(&test_fifo, 8) == ESIZE);
+    assert(fifo_spsc_skip(&test_fifo, 7) == SUCCESS);
+
+    assert(fifo_spsc_init_filled(&test_fifo, buffer, sizeof(buffer), sizeof(buffer)) == SUCCESS);
+    assert(fifo_spsc_get_size(&test_fifo) == sizeof(buffer));
+    assert(fifo_put_from_isr(&test_fifo, expected, 1) == ESIZE);
+}
+
 int main(int argc, char *argv[])
 {
     printf("Testing fifo_peek ... ");
@@ -284,6 +467,22 @@ int main(int argc, char *argv[])
     test_pop_empty();
     printf("Success!\n");
 
+    printf("Testing fifo_peek_segments ... ");
+    test_peek_segments();
+    printf("Success!\n");
+
+    printf("Testing fifo_reserve and fifo_commit ... ");
+    test_reserve_commit();
+    printf("Success!\n");
+
+    printf("Testing fifo_put_byte and fifo_pop_byte ... ");
+    test_byte_access();
+    printf("Success!\n");
+
+    printf("Testing the single producer single consumer fifo ... ");
+    test_spsc();
+    printf("Success!\n");
+
     printf("All FIFO tests passed!\n");
 
 }
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Tests the FEC encoder and decoder of the framework against the reference encoder from the D7A specification
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "fec.h"
+#include "pn9.h"
+#include "crc.h"
+
+#define MAX_FRAME_LENGTH 255
+#define MAX_ENCODED_LENGTH (2 * (MAX_FRAME_LENGTH + 3))
+
+// bit by bit convolutional encoder with interleaving, as originally implemented in fec.c
+static uint16_t reference_fec_encode(const uint8_t* input, uint16_t nbytes, uint8_t* output)
+{
+    static const uint8_t fec_lut[16] = {0, 3, 1, 2, 3, 0, 2, 1, 3, 0, 2, 1, 0, 3, 1, 2};
+    uint8_t buffer[MAX_FRAME_LENGTH + 3];
+    uint16_t total = nbytes + 2 + nbytes % 2;
+    memcpy(buffer, input, nbytes);
+    memset(buffer + nbytes, 0x0B, total - nbytes);
+
+    unsigned int encstate = 0;
+    uint8_t symbols[4];
+    uint16_t length = 0;
+    for(uint16_t n = 0; n < total; n += 2)
+    {
+        memset(symbols, 0, sizeof(symbols));
+        for(int bit = 0; bit < 16; bit++)
+        {
+            uint8_t byte = buffer[n + bit / 8];
+            encstate = (encstate << 1) | ((byte >> (7 - bit % 8)) & 1);
+            symbols[bit / 4] |= fec_lut[encstate & 0x0F] << (6 - 2 * (bit % 4));
+        }
+
+        for(int k = 0; k < 4; k++)
+            output[length++] = ((symbols[0] >> (2 * k)) & 0x03) | (((symbols[1] >> (2 * k)) & 0x03) << 2) |
+                               (((symbols[2] >> (2 * k)) & 0x03) << 4) | (((symbols[3] >> (2 * k)) & 0x03) << 6);
+    }
+
+    return length;
+}
+
+// Viterbi decoder as originally implemented in fec.c, outputs length / 2 - 1 bytes. The original reset the cost of
+// the best state to 0 while normalising, so the states after it were not normalised. This is fixed here.
+static void reference_fec_decode(const uint8_t* input, uint16_t length, uint8_t* output)
+{
+    static const uint8_t trellis0_lut[8] = {0, 1, 3, 2, 3, 2, 0, 1};
+    static const uint8_t trellis1_lut[8] = {3, 2, 0, 1, 0, 1, 3, 2};
+    uint8_t cost[8] = {0, 100, 100, 100, 100, 100, 100, 100}, new_cost[8];
+    uint16_t path[8] = {0}, new_path[8];
+    uint8_t path_size = 0;
+
+    for(uint16_t block = 0; block < length; block += 4)
+    {
+        uint8_t fecbuffer[4];
+        for(int n = 0; n < 4; n++)
+            fecbuffer[n] = ((input[block] >> (2 * n)) & 0x03) | (((input[block + 1] >> (2 * n)) & 0x03) << 2) |
+                           (((input[block + 2] >> (2 * n)) & 0x03) << 4) | (((input[block + 3] >> (2 * n)) & 0x03) << 6);
+
+        for(int i = 0; i < 4; i += 2)
+        {
+            for(int j = 7; j >= 0; j--)
+            {
+                uint8_t symbol = (j > 3) ? (fecbuffer[i] >> (j - 4) * 2) & 0x03 : (fecbuffer[i + 1] >> j * 2) & 0x03;
+                for(int k = 0; k < 8; k++)
+                {
+                    const uint8_t* lut = (k & 1) ? trellis1_lut : trellis0_lut;
+                    uint8_t state0 = k >> 1, state1 = state0 + 4;
+                    uint8_t hamming0 = cost[state0] + (((lut[state0] ^ symbol) + 1) >> 1);
+                    uint8_t hamming1 = cost[state1] + (((lut[state1] ^ symbol) + 1) >> 1);
+                    new_cost[k] = hamming0 <= hamming1 ? hamming0 : hamming1;
+                    new_path[k] = ((hamming0 <= hamming1 ? path[state0] : path[state1]) << 1) | (k & 1);
+                }
+
+                memcpy(cost, new_cost, sizeof(cost));
+                memcpy(path, new_path, sizeof(path));
+            }
+
+            if(++path_size == 2)
+            {
+                uint8_t min_state = 0;
+                for(int j = 7; j != 0; j--)
+                    if(cost[j] < cost[min_state])
+                        min_state = j;
+
+                uint8_t min_cost = cost[min_state];
+                for(int j = 0; j < 8; j++)
+                    cost[j] -= min_cost;
+
+                *output++ = path[min_state] >> 8;
+                path_size--;
+            }
+        }
+    }
+}
+
+static void set_soft_bit(uint8_t* soft, uint16_t bit, bool value, uint8_t confidence)
+{
+    soft[bit] = value ? 128 + confidence / 2 : 127 - confidence / 2;
+}
+
+void bootstrap()
+{
+    uint8_t frame[MAX_FRAME_LENGTH];
+    uint8_t expected[MAX_ENCODED_LENGTH];
+    uint8_t buffer[MAX_ENCODED_LENGTH];
+
+    for(uint16_t length = 1; length <= MAX_FRAME_LENGTH; length++)
+    {
+        for(uint16_t i = 0; i < length; i++)
+            frame[i] = rand();
+
+        uint16_t expected_length = reference_fec_encode(frame, length, expected);
+
+        // encoding happens in place
+        memcpy(buffer, frame, length);
+        assert(fec_encode(buffer, length) == expected_length);
+        assert(memcmp(buffer, expected, expected_length) == 0);
+
+        assert(fec_decode_packet(buffer, expected_length, expected_length) >= length);
+        assert(memcmp(buffer, frame, length) == 0);
+    }
+
+    // with bit errors the decoder takes the same decisions as the (fixed) original implementation
+    uint8_t reference[MAX_ENCODED_LENGTH / 2];
+    uint8_t decoded[MAX_ENCODED_LENGTH];
+    for(int run = 0; run < 1000; run++)
+    {
+        uint16_t length = 1 + rand() % MAX_FRAME_LENGTH;
+        for(uint16_t i = 0; i < length; i++)
+            frame[i] = rand();
+
+        memcpy(buffer, frame, length);
+        uint16_t encoded_length = fec_encode(buffer, length);
+        for(int error = 0; error < encoded_length / 8; error++)
+            buffer[rand() % encoded_length] ^= 1 << (rand() % 8);
+
+        reference_fec_decode(buffer, encoded_length, reference);
+        memcpy(decoded, buffer, encoded_length);
+        assert(fec_decode_packet(decoded, encoded_length, encoded_length) == encoded_length / 2);
+        assert(memcmp(decoded, reference, encoded_length / 2 - 1) == 0);
+    }
+
+    // soft decisions: bit errors which are received with low confidence are corrected far better than with hard
+    // decisions. With certain confidences the result equals hard decision decoding.
+    static uint8_t soft[8 * MAX_ENCODED_LENGTH];
+    int hard_failures = 0, soft_failures = 0;
+    for(int run = 0; run < 200; run++)
+    {
+        uint16_t length = 64;
+        for(uint16_t i = 0; i < length; i++)
+            frame[i] = rand();
+
+        memcpy(buffer, frame, length);
+        uint16_t encoded_length = fec_encode(buffer, length);
+        for(uint16_t bit = 0; bit < 8 * encoded_length; bit++)
+            set_soft_bit(soft, bit, buffer[bit / 8] & (0x80 >> (bit % 8)), 255);
+
+        assert(fec_decode_packet_soft(soft, encoded_length, decoded, sizeof(decoded)) == encoded_length / 2);
+        assert(memcmp(decoded, frame, length) == 0);
+
+        // 10% of the bits is flipped, but received with a low confidence
+        for(uint16_t bit = 0; bit < 8 * encoded_length; bit++)
+        {
+            if(rand() % 10 == 0)
+            {
+                buffer[bit / 8] ^= 0x80 >> (bit % 8);
+                set_soft_bit(soft, bit, buffer[bit / 8] & (0x80 >> (bit % 8)), 20);
+            }
+        }
+
+        fec_decode_packet_soft(soft, encoded_length, decoded, sizeof(decoded));
+        soft_failures += memcmp(decoded, frame, length) != 0;
+        fec_decode_packet(buffer, encoded_length, encoded_length);
+        hard_failures += memcmp(buffer, frame, length) != 0;
+    }
+
+    printf("Frames not recovered with 10%% bit errors: hard decisions %i, soft decisions %i (of 200)\n",
+           hard_failures, soft_failures);
+    assert(soft_failures < hard_failures);
+    assert(soft_failures <= 2);
+
+    // streaming: a frame which arrives in chunks of arbitrary size is de-whitened, decoded and checked in place while
+    // it is received, like the PHY does, with the same result as decoding the complete frame
+    for(int run = 0; run < 200; run++)
+    {
+        uint16_t length = 4 + rand() % (MAX_FRAME_LENGTH - 4);
+        frame[0] = length - 1;
+        for(uint16_t i = 1; i < length - 2; i++)
+            frame[i] = rand();
+
+        uint16_t crc = crc_calculate(frame, length - 2);
+        frame[length - 2] = crc >> 8;
+        frame[length - 1] = crc & 0xFF;
+
+        memcpy(buffer, frame, length);
+        uint16_t encoded_length = fec_encode(buffer, length);
+        pn9_encode(buffer, encoded_length);
+
+        fec_decoder_t decoder;
+        uint16_t received = 0, processed = 0, decoded_length = 0, crc_length = 0;
+        fec_decoder_init(&decoder);
+        crc = crc_init();
+        while(received < encoded_length)
+        {
+            received += 1 + rand() % 40;
+            if(received > encoded_length)
+                received = encoded_length;
+
+            uint16_t end = received - received % 4;
+            if(end <= processed)
+                continue;
+
+            pn9_encode_from(buffer + processed, end - processed, processed);
+            for(; processed < end; processed += 4)
+                decoded_length += fec_decode_block(&decoder, &buffer[processed], &buffer[decoded_length]);
+
+            uint16_t crc_end = decoded_length < length - 2 ? decoded_length : length - 2;
+            if(decoded_length > 0 && crc_end > crc_length)
+            {
+                assert(buffer[0] == length - 1);
+                crc = crc_update(crc, buffer + crc_length, crc_end - crc_length);
+                crc_length = crc_end;
+            }
+        }
+
+        decoded_length += fec_decoder_flush(&decoder, &buffer[decoded_length]);
+        assert(decoded_length == encoded_length / 2);
+        assert(crc_length == length - 2);
+        assert(crc_final(crc) == ((buffer[length - 2] << 8) | buffer[length - 1]));
+        assert(memcmp(buffer, frame, length) == 0);
+    }
+
+    printf("All PHY coding tests passed!\n");
+    exit(0);
+}
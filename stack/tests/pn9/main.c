@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "pn9.h"
+#include "crc.h"
+
+#define MAX_LENGTH 1100 // more than twice the period of the sequence
+
+// the original LFSR implementation, used as reference
+static void reference_pn9(uint8_t* data, uint16_t length)
+{
+    uint16_t pn9 = PN9_INITIALIZER;
+    for(uint16_t i = 0; i < length; i++)
+    {
+        data[i] ^= pn9;
+        for(int bit = 0; bit < 8; bit++)
+            pn9 = (((((pn9 & 0x20) >> 5) ^ pn9) << 8) | ((pn9 >> 1) & 0xff)) & 0x1ff;
+    }
+}
+
+void bootstrap()
+{
+    uint8_t data[MAX_LENGTH];
+    uint8_t expected[MAX_LENGTH];
+    uint8_t buffer[MAX_LENGTH + 8];
+    for(int i = 0; i < MAX_LENGTH; i++)
+        data[i] = rand();
+
+    memcpy(expected, data, MAX_LENGTH);
+    reference_pn9(expected, MAX_LENGTH);
+
+    // all lengths, also at unaligned addresses
+    for(uint16_t length = 0; length <= MAX_LENGTH; length++)
+    {
+        uint8_t* unaligned = buffer + (length % 8);
+        memcpy(unaligned, data, length);
+        pn9_encode(unaligned, length);
+        assert(memcmp(unaligned, expected, length) == 0);
+    }
+
+    // whitening is its own inverse
+    memcpy(buffer, expected, MAX_LENGTH);
+    pn9_encode(buffer, MAX_LENGTH);
+    assert(memcmp(buffer, data, MAX_LENGTH) == 0);
+
+    // resuming from an offset gives the same result as whitening the frame in one go
+    for(uint16_t offset = 0; offset <= MAX_LENGTH; offset++)
+    {
+        memcpy(buffer, data, MAX_LENGTH);
+        pn9_encode(buffer, offset);
+        pn9_encode_from(buffer + offset, MAX_LENGTH - offset, offset);
+        assert(memcmp(buffer, expected, MAX_LENGTH) == 0);
+    }
+
+    // the fused kernels whiten like pn9_encode_from() and calculate the CRC of the frame before whitening
+    for(uint16_t offset = 0; offset <= MAX_LENGTH; offset += 7)
+    {
+        uint16_t length = MAX_LENGTH - offset;
+        uint8_t* unaligned = buffer + (offset % 8);
+        uint16_t crc = pn9_encode_crc(unaligned, data + offset, length, offset, crc_init());
+        assert(crc_final(crc) == crc_calculate(data + offset, length));
+        assert(memcmp(unaligned, expected + offset, length) == 0);
+
+        crc = pn9_decode_crc(unaligned, length, offset, crc_init());
+        assert(crc_final(crc) == crc_calculate(data + offset, length));
+        assert(memcmp(unaligned, data + offset, length) == 0);
+    }
+
+    printf("All PN9 tests passed!\n");
+    exit(0);
+}
@@ -17,6 +17,8 @@
  * limitations under the License.
  */
 #include "scheduler.h"
+#include "timer.h"
+#include "framework_defs.h"
 #include "assert.h"
 #include "errors.h"
 #include "stdio.h"
@@ -31,6 +33,17 @@ bool task4a_called = false;
 bool task5_called[] = {false, false};
 bool task6_called[] = {false, false, false, false};
 bool task7_called[] = {false, false};
+bool task8_called[] = {false, false};
+sched_task_id_t task8_ids[2];
+uint8_t task9_order[4];
+uint8_t task9_count = 0;
+sched_task_id_t task9_ids[4];
+uint8_t isr_order[3];
+uint8_t isr_count = 0;
+sched_task_id_t isr_task_ids[4];
+uint8_t deadline_order[5];
+uint8_t deadline_count = 0;
+sched_task_id_t deadline_task_ids[4];
 
 
 void task1(void* arg)
@@ -97,6 +110,50 @@ void task7(void* arg)
     }
 }
 
+void task8(void* arg)
+{
+    unsigned long long index = (unsigned long long)arg;
+    assert(index<2);
+    task8_called[index] = true;
+    assert(!sched_is_scheduled_id(task8_ids[index]));
+    if(index == 0)
+    {
+        assert(sched_is_scheduled_id(task8_ids[1]));
+        assert(sched_cancel_task_id(task8_ids[1]) == SUCCESS);
+        assert(sched_cancel_task_id(task8_ids[1]) == -EALREADY);
+    }
+}
+
+void task9(void* arg)
+{
+    unsigned long long priority = (unsigned long long)arg;
+    task9_order[task9_count++] = priority;
+    if(priority == 3)
+    {
+        // a task posted at a higher priority preempts the pending tasks of lower priorities
+        assert(sched_post_task_id(task9_ids[3], 2, (void*)2) == SUCCESS);
+    }
+}
+
+void isr_task(void* arg)
+{
+    unsigned long long index = (unsigned long long)arg;
+    assert(index < 3);
+    isr_order[isr_count++] = index;
+}
+
+void deadline_task(void* arg)
+{
+    unsigned long long index = (unsigned long long)arg;
+    // deadline tasks are executed before the tasks of all priorities
+    assert(task9_count == 0 && !task1_called);
+    deadline_order[deadline_count++] = index;
+}
+
+void missed_deadline_task(void* arg)
+{
+    deadline_order[deadline_count++] = 4;
+}
 
 void end_task(void*arg)
 {
@@ -114,6 +171,38 @@ void end_task(void*arg)
     assert(task6_called[3]);
     assert(task7_called[0]);
     assert(!task7_called[1]);
+    assert(task8_called[0]);
+    assert(!task8_called[1]);
+    assert(task9_count == 4);
+    assert(task9_order[0] == 0 && task9_order[1] == 3 && task9_order[2] == 2 && task9_order[3] == 4);
+    // tasks posted from interrupt context are executed in the order in which they were posted
+    assert(isr_count == 3);
+    assert(isr_order[0] == 2 && isr_order[1] == 0 && isr_order[2] == 1);
+    // deadline tasks are executed earliest deadline first, in posting order for equal deadlines
+    assert(deadline_count == 5);
+    assert(deadline_order[0] == 4 && deadline_order[1] == 1 && deadline_order[2] == 3 && deadline_order[3] == 2
+           && deadline_order[4] == 0);
+    assert(sched_get_missed_deadlines() == 1);
+#ifdef FRAMEWORK_SCHEDULER_PROFILING
+    task_t task;
+    sched_task_stats_t stats;
+    assert(sched_get_task_stats(SCHED_INVALID_TASK_ID, &task, &stats) == -EINVAL);
+    assert(sched_get_task_stats(sched_get_task_id(&task1), &task, &stats) == SUCCESS);
+    assert(task == &task1 && stats.invocations == 1);
+    assert(sched_get_task_stats(task8_ids[0], &task, &stats) == SUCCESS);
+    assert(task == &task8 && stats.invocations == 1);
+    assert(sched_get_task_stats(task8_ids[1], &task, &stats) == SUCCESS);
+    assert(stats.invocations == 0);
+    assert(sched_get_task_stats(isr_task_ids[3], &task, &stats) == SUCCESS);
+    assert(stats.invocations == 0);
+    assert(sched_get_task_stats(sched_get_task_id(&missed_deadline_task), &task, &stats) == SUCCESS);
+    assert(stats.invocations == 1 && stats.missed_deadlines == 1);
+    assert(sched_get_task_stats(deadline_task_ids[0], &task, &stats) == SUCCESS);
+    assert(stats.invocations == 1 && stats.missed_deadlines == 0);
+    sched_reset_task_stats();
+    assert(sched_get_task_stats(sched_get_task_id(&task1), &task, &stats) == SUCCESS);
+    assert(stats.invocations == 0);
+#endif
     printf("All scheduler tests passed!\n");
     exit(0);
 }
@@ -166,6 +255,59 @@ void bootstrap()
     assert(sched_post_task_prio(&task7, 6, (void*)0) == SUCCESS);
     assert(sched_register_task_allow_multiple(&task7, true) == SUCCESS);
     assert(sched_post_task_prio(&task7, 6, (void*)1) == SUCCESS);
+
+    assert(sched_get_task_id(&task8) == SCHED_INVALID_TASK_ID);
+    assert(sched_post_task_id(SCHED_INVALID_TASK_ID, 6, NULL) == -EINVAL);
+    assert(sched_cancel_task_id(SCHED_INVALID_TASK_ID) == -EINVAL);
+    assert(!sched_is_scheduled_id(SCHED_INVALID_TASK_ID));
+    task8_ids[0] = sched_register_task_id(&task8);
+    task8_ids[1] = sched_register_task_id(&task8);
+    assert(task8_ids[0] != task8_ids[1]);
+    assert(sched_get_task_id(&task8) == task8_ids[0] || sched_get_task_id(&task8) == task8_ids[1]);
+    assert(sched_get_task_id(&task1) != SCHED_INVALID_TASK_ID);
+    assert(sched_post_task_id(task8_ids[0], MIN_PRIORITY + 1, NULL) == -ESIZE);
+    assert(sched_post_task_id(task8_ids[0], 5, (void*)0) == SUCCESS);
+    assert(sched_post_task_id(task8_ids[0], 5, (void*)0) == -EALREADY);
+    assert(sched_is_scheduled_id(task8_ids[0]));
+    assert(sched_post_task_id(task8_ids[1], 6, (void*)1) == SUCCESS);
+    // the task_t based API sees both registrations
+    assert(sched_is_scheduled_with_arg(&task8, (void*)1));
+
+    for(int i = 0; i < 4; i++)
+        task9_ids[i] = sched_register_task_id(&task9);
+    assert(sched_post_task_id(task9_ids[0], 4, (void*)4) == SUCCESS);
+    assert(sched_post_task_id(task9_ids[1], 3, (void*)3) == SUCCESS);
+    assert(sched_post_task_id(task9_ids[2], MAX_PRIORITY, (void*)0) == SUCCESS);
+
+    for(int i = 0; i < 4; i++)
+        isr_task_ids[i] = sched_register_task_id(&isr_task);
+    assert(sched_post_task_id_from_isr(SCHED_INVALID_TASK_ID, 6, NULL) == -EINVAL);
+    assert(sched_post_task_id_from_isr(isr_task_ids[0], MIN_PRIORITY + 1, NULL) == -ESIZE);
+    assert(sched_post_task_id_from_isr(isr_task_ids[2], 6, (void*)2) == SUCCESS);
+    assert(sched_post_task_id_from_isr(isr_task_ids[2], 6, (void*)1) == -EALREADY);
+    assert(sched_post_task_id(isr_task_ids[2], 6, (void*)1) == -EALREADY);
+    assert(sched_is_scheduled_id(isr_task_ids[2]));
+    assert(sched_post_task_id_from_isr(isr_task_ids[0], 6, (void*)0) == SUCCESS);
+    assert(sched_post_task_id_from_isr(isr_task_ids[1], 6, (void*)1) == SUCCESS);
+    // a task posted from interrupt context can be cancelled before it is executed
+    assert(sched_post_task_id_from_isr(isr_task_ids[3], 6, (void*)3) == SUCCESS);
+    assert(sched_cancel_task_id(isr_task_ids[3]) == SUCCESS);
+    assert(!sched_is_scheduled_id(isr_task_ids[3]));
+
+    timer_tick_t now = timer_get_counter_value();
+    for(int i = 0; i < 4; i++)
+        deadline_task_ids[i] = sched_register_task_id(&deadline_task);
+    assert(sched_post_task_id_deadline(SCHED_INVALID_TASK_ID, now, NULL) == -EINVAL);
+    assert(sched_post_task_id_deadline(deadline_task_ids[0], now + 300, (void*)0) == SUCCESS);
+    assert(sched_post_task_id_deadline(deadline_task_ids[0], now + 50, (void*)0) == -EALREADY);
+    assert(sched_post_task_id_deadline(deadline_task_ids[1], now + 100, (void*)1) == SUCCESS);
+    assert(sched_post_task_id_deadline(deadline_task_ids[2], now + 200, (void*)2) == SUCCESS);
+    assert(sched_post_task_id_deadline(deadline_task_ids[3], now + 200, (void*)3) == SUCCESS);
+    assert(sched_cancel_task_id(deadline_task_ids[3]) == SUCCESS);
+    assert(sched_post_task_id_deadline(deadline_task_ids[3], now + 100, (void*)3) == SUCCESS);
+    assert(sched_post_task_deadline(&missed_deadline_task, now, NULL) == -EINVAL);
+    assert(sched_register_task(&missed_deadline_task) == SUCCESS);
+    assert(sched_post_task_deadline(&missed_deadline_task, now - 1, NULL) == SUCCESS);
     
     assert(sched_post_task_prio(&end_task, MIN_PRIORITY, NULL) == SUCCESS);
 
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Runs the complete D7AP stack on all simulated nodes and lets them start a request at the same moment. Without
+// CSMA-CA these requests collide on the virtual radio medium (see test_sim_radio), through phy.c and dll.c the nodes
+// have to sense the channel and defer, so none of the frames which are transmitted may collide.
+
+#include "scheduler.h"
+#include "timer.h"
+#include "d7ap.h"
+#include "d7ap_fs.h"
+#include "ng.h"
+#include "sim.h"
+#include "platform_defs.h"
+#include "assert.h"
+#include "errors.h"
+#include "stdio.h"
+#include <stdlib.h>
+
+// define here now, since we are not using APP_BUILD() macro for tests
+const char _APP_NAME[] = "sim_d7ap_test";
+const char _GIT_SHA1[] = "";
+
+#define NODES PLATFORM_NATIVE_SIMULATOR_NODES
+#define PAYLOAD_LENGTH 16
+#define CHECK_TIME (TIMER_TICKS_PER_SEC * 5)
+
+_Static_assert(NODES >= 4, "this test needs at least 4 nodes");
+
+typedef struct
+{
+    uint8_t client_id;
+    uint16_t trans_id;
+    bool transmitted;
+    error_t error;
+} node_t;
+
+static node_t nodes[NODES];
+
+static d7ap_session_config_t session_config = {
+    .qos = {
+        .qos_resp_mode = SESSION_RESP_MODE_NO,
+        .qos_retry_mode = SESSION_RETRY_MODE_NO
+    },
+    .dormant_timeout = 0,
+    .addressee = {
+        .ctrl = {
+            .nls_method = AES_NONE,
+            .id_type = ID_TYPE_NOID,
+        },
+        .access_class = 0x01,
+        .id = { 0 }
+    }
+};
+
+static void transmitted(uint16_t trans_id, error_t error)
+{
+    node_t* node = &nodes[get_node_global_id()];
+    assert(trans_id == node->trans_id && !node->transmitted);
+    node->transmitted = true;
+    node->error = error;
+}
+
+static d7ap_resource_desc_t d7ap_client = {
+    .transmitted_cb = &transmitted
+};
+
+void send_task(void* arg)
+{
+    node_t* node = &nodes[get_node_global_id()];
+    uint8_t payload[PAYLOAD_LENGTH] = { 0 };
+    payload[0] = get_node_global_id();
+    assert(d7ap_send(node->client_id, &session_config, payload, sizeof(payload), 0, &node->trans_id) == SUCCESS);
+}
+
+void check_task(void* arg)
+{
+    const sim_radio_stats_t* stats = sim_radio_get_stats();
+    uint32_t succeeded = 0;
+    for(int i = 0; i < NODES; i++)
+    {
+        // every request is either transmitted or abandoned by CSMA-CA, it is never left pending
+        assert(nodes[i].transmitted);
+        if(nodes[i].error == SUCCESS)
+            succeeded++;
+    }
+
+    // the frames were all queued at the same moment, so the nodes which transmitted had to defer to each other
+    assert(succeeded > 1);
+    assert(stats->frames_transmitted == succeeded);
+    assert(stats->frames_collided == 0);
+    printf("%i of %i nodes transmitted without collisions\n", succeeded, NODES);
+    printf("All simulated D7AP tests passed!\n");
+    exit(0);
+}
+
+void bootstrap()
+{
+    node_t* node = &nodes[get_node_global_id()];
+    d7ap_fs_init();
+    d7ap_init();
+    node->client_id = d7ap_register(&d7ap_client);
+
+    assert(sched_register_task(&send_task) == SUCCESS);
+    assert(timer_post_task_delay(&send_task, TIMER_TICKS_PER_SEC) == SUCCESS);
+    if(get_node_global_id() == 0)
+    {
+        assert(sched_register_task(&check_task) == SUCCESS);
+        assert(timer_post_task_delay(&check_task, CHECK_TIME) == SUCCESS);
+    }
+}
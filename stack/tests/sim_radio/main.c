@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Exercises the virtual radio medium of the NATIVE simulator: delivery to all nodes in range, path loss,
+// collisions, packet error rate, RSSI measurements and the delivery of the received bytes during reception.
+
+#include "scheduler.h"
+#include "timer.h"
+#include "hwradio.h"
+#include "ng.h"
+#include "sim.h"
+#include "platform_defs.h"
+#include "assert.h"
+#include "errors.h"
+#include "stdio.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define NODES PLATFORM_NATIVE_SIMULATOR_NODES
+#define PACKET_LENGTH 10
+#define LONG_PACKET_LENGTH 200
+
+_Static_assert(NODES >= 6, "this test needs at least 6 nodes");
+
+typedef struct
+{
+    uint8_t buffer[HW_PACKET_BUF_SIZE(256)] __attribute__((aligned(4)));
+    uint32_t rx_count;
+    uint8_t last_sender;
+    bool last_valid;
+    int16_t last_rssi;
+    uint8_t streamed[LONG_PACKET_LENGTH]; // the bytes passed to the rx data callback
+    uint16_t streamed_length;
+    uint8_t data_callbacks;
+    bool streamed_valid;
+} node_t;
+
+static node_t nodes[NODES];
+static int16_t rssi_idle;
+static int16_t rssi_busy;
+
+static const uint8_t sync_word[2] = { 0xD0, 0xE6 };
+
+static hw_radio_packet_t* alloc_packet(uint16_t length)
+{
+    return (hw_radio_packet_t*)nodes[get_node_global_id()].buffer;
+}
+
+static void release_packet(hw_radio_packet_t* packet) {}
+
+static void packet_header_received(uint8_t* data, uint8_t len)
+{
+    hw_radio_set_payload_length(data[0] + 1);
+}
+
+static void packet_data_received(hw_radio_packet_t* packet, uint16_t length)
+{
+    node_t* node = &nodes[get_node_global_id()];
+    assert(length > node->streamed_length && length < packet->length && length <= LONG_PACKET_LENGTH);
+    node->data_callbacks++;
+    node->streamed_length = length;
+    memcpy(node->streamed, packet->data, length);
+}
+
+static void packet_received(hw_radio_packet_t* packet)
+{
+    node_t* node = &nodes[get_node_global_id()];
+    // the bytes passed during reception are part of the complete packet
+    node->streamed_valid = memcmp(node->streamed, packet->data, node->streamed_length) == 0;
+    node->streamed_length = 0;
+    node->rx_count++;
+    node->last_sender = packet->data[1];
+    node->last_rssi = packet->rx_meta.rssi;
+    node->last_valid = true;
+    for(int i = 2; i < packet->length; i++)
+        if(packet->data[i] != i)
+            node->last_valid = false;
+}
+
+static void packet_transmitted(timer_tick_t timestamp)
+{
+    hw_radio_set_opmode(HW_STATE_RX);
+}
+
+static void send(uint8_t length)
+{
+    uint8_t data[LONG_PACKET_LENGTH];
+    data[0] = length - 1;
+    data[1] = get_node_global_id();
+    for(int i = 2; i < length; i++)
+        data[i] = i;
+
+    assert(hw_radio_send_payload(data, length) == SUCCESS);
+}
+
+static void reset_rx()
+{
+    memset(nodes, 0, sizeof(nodes));
+}
+
+void collision_task(void* arg)
+{
+    send(PACKET_LENGTH);
+}
+
+void long_packet_task(void* arg)
+{
+    send(LONG_PACKET_LENGTH);
+}
+
+void step_task(void* arg)
+{
+    static int step = 0;
+    switch(step++)
+    {
+        case 0:
+            // node 0 is received by all nodes, except by node 4 which is out of range
+            send(PACKET_LENGTH);
+            timer_post_task_delay(&step_task, TIMER_TICKS_PER_SEC / 4);
+            break;
+        case 1:
+            for(int i = 1; i < NODES; i++)
+            {
+                assert(nodes[i].rx_count == (i == 4 ? 0 : 1));
+                assert(i == 4 || (nodes[i].last_sender == 0 && nodes[i].last_valid && nodes[i].last_rssi == 10 - 80));
+            }
+            assert(sim_radio_get_stats()->frames_collided == 0);
+            reset_rx();
+            // node 1 and 2 transmit simultaneously
+            sim_schedule(1, sim_get_time(), &collision_task, NULL);
+            sim_schedule(2, sim_get_time(), &collision_task, NULL);
+            timer_post_task_delay(&step_task, TIMER_TICKS_PER_SEC / 4);
+            break;
+        case 2:
+            assert(nodes[0].rx_count == 1 && !nodes[0].last_valid);
+            assert(sim_radio_get_stats()->frames_collided > 0);
+            reset_rx();
+            // the link from node 3 to node 0 has a PER of 1
+            sim_schedule(3, sim_get_time(), &collision_task, NULL);
+            timer_post_task_delay(&step_task, TIMER_TICKS_PER_SEC / 4);
+            break;
+        case 3:
+            assert(nodes[0].rx_count == 1 && !nodes[0].last_valid && nodes[0].last_sender == 3);
+            assert(nodes[1].rx_count == 1 && nodes[1].last_valid && nodes[1].last_sender == 3);
+            assert(sim_radio_get_stats()->frames_lost == 1);
+            // measure the RSSI while node 5 transmits a long packet
+            rssi_idle = hw_radio_get_rssi();
+            sim_schedule(5, sim_get_time(), &long_packet_task, NULL);
+            timer_post_task_delay(&step_task, 5);
+            break;
+        case 4:
+            rssi_busy = hw_radio_get_rssi();
+            assert(rssi_idle == -120);
+            assert(rssi_busy == 10 - 80);
+            timer_post_task_delay(&step_task, TIMER_TICKS_PER_SEC / 4);
+            break;
+        case 5:
+            // the long packet was passed to the rx data callback in chunks while it was on air
+            assert(nodes[1].last_sender == 5 && nodes[1].last_valid);
+            assert(nodes[1].data_callbacks == (LONG_PACKET_LENGTH - 1) / 32);
+            assert(nodes[1].streamed_valid);
+            printf("All simulated radio tests passed!\n");
+            exit(0);
+    }
+}
+
+void bootstrap()
+{
+    hwradio_init_args_t init_args = {
+        .alloc_packet_cb = &alloc_packet,
+        .release_packet_cb = &release_packet,
+        .rx_packet_cb = &packet_received,
+        .rx_packet_header_cb = &packet_header_received,
+        .rx_packet_data_cb = &packet_data_received,
+        .tx_packet_cb = &packet_transmitted,
+    };
+
+    assert(hw_radio_init(&init_args) == SUCCESS);
+    hw_radio_set_center_freq(868000000);
+    hw_radio_set_bitrate(55555);
+    hw_radio_set_sync_word((uint8_t*)sync_word, sizeof(sync_word));
+    hw_radio_set_tx_power(10);
+    hw_radio_set_payload_length(0);
+    hw_radio_set_opmode(HW_STATE_RX);
+
+    if(get_node_global_id() == 0)
+    {
+        sim_radio_set_link(0, 4, 200, 0);
+        sim_radio_set_link(3, 0, 80, 1);
+        sched_register_task(&step_task);
+        timer_post_task_delay(&step_task, TIMER_TICKS_PER_SEC / 10);
+    }
+}
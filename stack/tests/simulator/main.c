@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Runs the default number of simulated nodes, each with its own periodic timer, and verifies that the
+// nodes are isolated from each other and that the virtual clock advances correctly.
+
+#include "scheduler.h"
+#include "timer.h"
+#include "hwsystem.h"
+#include "ng.h"
+#include "sim.h"
+#include "platform_defs.h"
+#include "assert.h"
+#include "errors.h"
+#include "stdio.h"
+#include <stdlib.h>
+
+#define NODES PLATFORM_NATIVE_SIMULATOR_NODES
+#define CHECK_TIME (TIMER_TICKS_PER_SEC * 10 + TIMER_TICKS_PER_SEC / 20)
+
+static uint32_t tick_count[NODES];
+static uint64_t uid[NODES];
+
+static timer_tick_t period()
+{
+    return (get_node_global_id() + 1) * TIMER_TICKS_PER_SEC / 10;
+}
+
+void periodic_task(void* arg)
+{
+    size_t node = get_node_global_id();
+    tick_count[node]++;
+    // the timer of every node should fire exactly on time, regardless of the other nodes
+    assert(timer_get_counter_value() == tick_count[node] * period());
+    assert(timer_post_task_delay(&periodic_task, period()) == SUCCESS);
+}
+
+void check_task(void* arg)
+{
+    assert(get_node_global_id() == 0);
+    assert(timer_get_counter_value() == CHECK_TIME);
+    for(int node = 0; node < sim_get_node_count(); node++)
+    {
+        timer_tick_t node_period = (node + 1) * TIMER_TICKS_PER_SEC / 10;
+        assert(tick_count[node] == CHECK_TIME / node_period);
+        for(int other = 0; other < node; other++)
+            assert(uid[node] != uid[other]);
+    }
+
+    printf("All simulator tests passed!\n");
+    exit(0);
+}
+
+void bootstrap()
+{
+    size_t node = get_node_global_id();
+    uid[node] = hw_get_unique_id();
+
+    assert(sched_register_task(&periodic_task) == SUCCESS);
+    assert(timer_post_task_delay(&periodic_task, period()) == SUCCESS);
+    if(node == 0)
+    {
+        assert(sched_register_task(&check_task) == SUCCESS);
+        assert(timer_post_task_delay(&check_task, CHECK_TIME) == SUCCESS);
+    }
+}
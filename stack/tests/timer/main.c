@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2015-2021 University of Antwerp, Aloxy NV.
+ *
+ * This file is part of Sub-IoT.
+ * See https://github.com/Sub-IoT/Sub-IoT-Stack for further info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Runs the framework timer on the virtual clock of the NATIVE platform: a sensor reporting every minute for
+ * a simulated day, followed by waiting until the 32-bit counter loops back to zero. hw_enter_lowpower_mode() jumps
+ * to the next timer event, so this takes milliseconds.
+ */
+
+#include "scheduler.h"
+#include "timer.h"
+#include "framework_defs.h"
+#include "assert.h"
+#include "errors.h"
+#include "stdio.h"
+#include <stdlib.h>
+#include <time.h>
+
+#define REPORT_PERIOD TIMER_TICKS_PER_MINUTE
+#define REPORT_COUNT (24 * 60)
+
+static uint32_t report_count = 0;
+static timer_tick_t next_report_time;
+static bool cancelled_task_called = false;
+static clock_t start;
+
+// events which are posted in a random order, they have to fire at the exact tick they were posted for
+#define ORDER_TASKS 6
+static timer_tick_t order_fire_time[ORDER_TASKS];
+static const timer_tick_t order_delay[ORDER_TASKS] = { 70, 10, 40, 10, 25, 55 };
+static uint8_t order_count = 0;
+
+static void order_task(uint8_t index)
+{
+    assert(timer_get_counter_value() == order_fire_time[index]);
+    order_count++;
+}
+
+void order_task0(void* arg) { order_task(0); }
+void order_task1(void* arg) { order_task(1); }
+void order_task2(void* arg) { order_task(2); }
+void order_task3(void* arg) { order_task(3); }
+void order_task4(void* arg) { order_task(4); }
+void order_task5(void* arg) { order_task(5); }
+static const task_t order_tasks[ORDER_TASKS] = { &order_task0, &order_task1, &order_task2, &order_task3, &order_task4, &order_task5 };
+
+void cancelled_task(void* arg)
+{
+    cancelled_task_called = true;
+}
+
+// an event with slack is fired together with an event inside its window, or at the end of its window
+static timer_tick_t past_post_time;
+static bool past_fired = false;
+
+void past_task(void* arg)
+{
+    // a fire time in the past is due immediately
+    assert(timer_get_counter_value() == past_post_time);
+    past_fired = true;
+}
+
+static timer_tick_t coalesce_a_time;
+static timer_tick_t coalesce_b_time;
+static timer_tick_t slack_time;
+static bool slack_fired;
+
+void coalesce_a_task(void* arg)
+{
+    assert(timer_get_counter_value() == coalesce_a_time);
+}
+
+void coalesce_b_task(void* arg)
+{
+    assert(timer_get_counter_value() == coalesce_a_time);
+    coalesce_b_time = timer_get_counter_value();
+}
+
+void slack_task(void* arg)
+{
+    // other events (like the watchdog feed) can pull it forward, but never out of its window
+    timer_tick_t now = timer_get_counter_value();
+    assert(now >= slack_time - 3 * TIMER_TICKS_PER_SEC && now <= slack_time);
+    slack_fired = true;
+}
+
+// one task with an event per session, the events are identified by their argument or by their handle
+#define SESSIONS 4
+static uint8_t session_fired[SESSIONS];
+static timer_tick_t session_fire_time[SESSIONS];
+static timer_handle_t session_handle[SESSIONS];
+
+void session_task(void* arg)
+{
+    uint8_t* session = arg;
+    assert(timer_get_counter_value() == session_fire_time[session - session_fired]);
+    (*session)++;
+}
+
+#define WRAP_DELAY ((UINT32_C(1) << 31) - 1) // the longest delay which is not interpreted as being in the past
+
+static uint64_t wrap_fire_time;
+
+// runs twice, so the 32-bit counter loops back to zero in between
+void wrap_task(void* arg)
+{
+    uint64_t time = timer_get_time64();
+    assert(time == wrap_fire_time);
+    assert(timer_get_counter_value() == (timer_tick_t)time);
+    if(time < (UINT64_C(1) << 32))
+    {
+        assert(session_fired[0] == 1 && session_fired[1] == 1 && session_fired[2] == 0 && session_fired[3] == 0);
+        assert(!timer_is_handle_scheduled(session_handle[0]));
+        assert(timer_cancel_handle(session_handle[0]) == EALREADY);
+        wrap_fire_time += WRAP_DELAY;
+        assert(timer_post_task_delay(&wrap_task, WRAP_DELAY) == SUCCESS);
+        return;
+    }
+
+    printf("Simulated %lu s of virtual time in %.3f s of CPU time\n",
+           (unsigned long)(time / TIMER_TICKS_PER_SEC), (double)(clock() - start) / CLOCKS_PER_SEC);
+    printf("All timer tests passed!\n");
+    exit(0);
+}
+
+void end_task(void* arg)
+{
+    assert(report_count == REPORT_COUNT);
+    assert(past_fired);
+    assert(!cancelled_task_called);
+    assert(!timer_is_task_scheduled(&cancelled_task));
+    assert(order_count == ORDER_TASKS - 1);
+    for(int i = 0; i < ORDER_TASKS; i++)
+        assert(!timer_is_task_scheduled(order_tasks[i]));
+    assert(coalesce_b_time == coalesce_a_time && slack_fired);
+    timer_stats_t stats;
+    timer_get_stats(&stats);
+    assert(stats.wakeups_saved >= 1 && stats.events_fired > stats.wakeups);
+
+    for(int i = 0; i < SESSIONS; i++)
+    {
+        session_fire_time[i] = timer_get_counter_value() + (SESSIONS - i) * TIMER_TICKS_PER_SEC;
+        assert(timer_post_task_prio_handle(&session_task, session_fire_time[i], DEFAULT_PRIORITY, 0, 0,
+                                           &session_fired[i], &session_handle[i]) == SUCCESS);
+        assert(session_handle[i] != TIMER_HANDLE_NONE);
+    }
+
+    // reposting with the same argument updates the event and keeps its handle
+    timer_handle_t handle;
+    session_fire_time[1] += TIMER_TICKS_PER_SEC / 2;
+    assert(timer_post_task_prio_handle(&session_task, session_fire_time[1], DEFAULT_PRIORITY, 0, 0, &session_fired[1],
+                                       &handle) == SUCCESS);
+    assert(handle == session_handle[1]);
+    assert(timer_cancel_handle(session_handle[2]) == SUCCESS);
+    assert(timer_cancel_handle(session_handle[2]) == EALREADY);
+    assert(!timer_is_handle_scheduled(session_handle[2]));
+    assert(timer_cancel_task_with_arg(&session_task, &session_fired[3]) == SUCCESS);
+    assert(timer_is_handle_scheduled(session_handle[0]) && timer_is_handle_scheduled(session_handle[1]));
+    assert(timer_is_task_scheduled(&session_task));
+
+    // the 64-bit time keeps counting when the 32-bit counter loops back to zero
+    wrap_fire_time = timer_get_time64() + WRAP_DELAY;
+    assert(timer_post_task_delay(&wrap_task, WRAP_DELAY) == SUCCESS);
+}
+
+void report_task(void* arg)
+{
+    // the virtual clock is exact, every report runs at the tick it was scheduled for
+    assert(timer_get_counter_value() == next_report_time);
+    report_count++;
+    next_report_time += REPORT_PERIOD;
+    if(report_count < REPORT_COUNT)
+        assert(timer_post_task_delay(&report_task, REPORT_PERIOD) == SUCCESS);
+    else
+        assert(sched_post_task(&end_task) == SUCCESS);
+}
+
+void bootstrap()
+{
+    start = clock();
+    assert(sched_register_task(&report_task) == SUCCESS);
+    assert(sched_register_task(&cancelled_task) == SUCCESS);
+    assert(sched_register_task(&end_task) == SUCCESS);
+    assert(sched_register_task(&wrap_task) == SUCCESS);
+    for(int i = 0; i < SESSIONS; i++)
+        assert(sched_register_task_allow_multiple(&session_task, true) == SUCCESS);
+
+    // right after boot the time is smaller than the distance to this past fire time, it may not wrap around
+    assert(sched_register_task(&past_task) == SUCCESS);
+    past_post_time = timer_get_counter_value();
+    assert(past_post_time < 15);
+    assert(timer_post_task(&past_task, past_post_time - 15) == SUCCESS);
+
+    next_report_time = timer_get_counter_value() + REPORT_PERIOD;
+    assert(timer_post_task_delay(&report_task, REPORT_PERIOD) == SUCCESS);
+
+    assert(timer_post_task_delay(&cancelled_task, 10 * TIMER_TICKS_PER_MINUTE + 1) == SUCCESS);
+    assert(timer_is_task_scheduled(&cancelled_task));
+    assert(timer_cancel_task(&cancelled_task) == SUCCESS);
+    assert(timer_cancel_task(&cancelled_task) == EALREADY);
+
+    for(int i = 0; i < ORDER_TASKS; i++)
+    {
+        assert(sched_register_task(order_tasks[i]) == SUCCESS);
+        order_fire_time[i] = timer_get_counter_value() + order_delay[i] * TIMER_TICKS_PER_SEC;
+        assert(timer_post_task(order_tasks[i], order_fire_time[i]) == SUCCESS);
+        assert(timer_is_task_scheduled(order_tasks[i]));
+    }
+    // an event can be moved in both directions, and removed from the middle of the queue
+    order_fire_time[0] = timer_get_counter_value() + 5 * TIMER_TICKS_PER_SEC;
+    assert(timer_post_task(order_tasks[0], order_fire_time[0]) == SUCCESS);
+    order_fire_time[1] = timer_get_counter_value() + 45 * TIMER_TICKS_PER_SEC;
+    assert(timer_post_task(order_tasks[1], order_fire_time[1]) == SUCCESS);
+    assert(timer_post_task_prio(order_tasks[1], order_fire_time[1], MAX_PRIORITY, 0, 0, NULL) == EALREADY);
+    assert(timer_cancel_task(order_tasks[4]) == SUCCESS);
+
+#ifdef FRAMEWORK_SCHEDULER_TICKLESS_IDLE
+    // the NATIVE platform reports a wakeup latency of 1 ms for mode 1 and 10 ms for mode 2
+    sched_set_low_power_mode(2);
+    assert(sched_select_low_power_mode() == 2);
+    assert(timer_post_task_delay(&cancelled_task, TIMER_TICKS_PER_SEC / 200) == SUCCESS);
+    assert(sched_select_low_power_mode() == 1);
+    assert(timer_cancel_task(&cancelled_task) == SUCCESS);
+    assert(sched_select_low_power_mode() == 2);
+    sched_set_low_power_mode(0);
+    assert(sched_select_low_power_mode() == 0);
+    sched_set_low_power_mode(2);
+#endif
+
+    assert(sched_register_task(&coalesce_a_task) == SUCCESS);
+    assert(sched_register_task(&coalesce_b_task) == SUCCESS);
+    assert(sched_register_task(&slack_task) == SUCCESS);
+    coalesce_a_time = timer_get_counter_value() + 15 * TIMER_TICKS_PER_SEC;
+    assert(timer_post_task(&coalesce_a_task, coalesce_a_time) == SUCCESS);
+    assert(timer_post_task_prio(&coalesce_b_task, coalesce_a_time - 2 * TIMER_TICKS_PER_SEC, DEFAULT_PRIORITY, 0,
+                                4 * TIMER_TICKS_PER_SEC, NULL) == SUCCESS);
+    slack_time = timer_get_counter_value() + 33 * TIMER_TICKS_PER_SEC;
+    assert(timer_post_task_prio(&slack_task, slack_time - 3 * TIMER_TICKS_PER_SEC, DEFAULT_PRIORITY, 0,
+                                3 * TIMER_TICKS_PER_SEC, NULL) == SUCCESS);
+}